@@ -0,0 +1,601 @@
+// Command-to-LED pipeline microbenchmarks, see include/benchmarks.h.
+//
+// Target: pio run -e esp32dev_bench -t upload && pio device monitor
+// Host:   pio run -e native_bench && .pio/build/native_bench/program > bench.json
+//
+// On the host the "serial" runs echo Serial to stderr, so redirect stderr to
+// pick the sink being measured (terminal, file or /dev/null).
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include "benchmarks.h"
+#include "main.h"
+#include "ble_protocol.h"
+#include "chord_check.h"
+#include "chord_listen.h"
+#include "chord_voicing.h"
+#include "data_handling.h"
+#include "effects.h"
+#include "frame_buffer.h"
+#include "guitar_tuning.h"
+#include "legacy_parsers.h"
+#include "onset_detect.h"
+#include "pitch_detect.h"
+#include "pixel_mapping.h"
+#include "scale_and_chord_notes.h"
+#include "shape_index.h"
+
+#ifdef GUITARPAL_NATIVE
+#include <chrono>
+#include <thread>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+#ifndef BENCH_BUILD_ID
+#define BENCH_BUILD_ID __DATE__ " " __TIME__
+#endif
+
+#define BENCH_MAX_SCALE_PAIRS 20
+
+// ================== Clock ==================
+// 32-bit cycle stamps; stage times are differences, so wrap-around is harmless
+#ifdef GUITARPAL_NATIVE
+#if defined(__x86_64__) || defined(__i386__)
+#define BENCH_CLOCK_NAME "rdtsc"
+static inline uint32_t benchCycles()
+{
+  return (uint32_t)__rdtsc();
+}
+#else
+#define BENCH_CLOCK_NAME "steady_clock"
+static inline uint32_t benchCycles()
+{
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif
+#define BENCH_PLATFORM "native"
+#else
+#define BENCH_CLOCK_NAME "ccount"
+#define BENCH_PLATFORM "esp32"
+static inline uint32_t benchCycles()
+{
+  return ESP.getCycleCount();
+}
+#endif
+
+// Counter ticks per microsecond, to convert percentiles to nanoseconds
+static uint32_t clockTicksPerMicrosecond()
+{
+#ifdef GUITARPAL_NATIVE
+  auto start = std::chrono::steady_clock::now();
+  uint32_t startCycles = benchCycles();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  uint32_t cycles = benchCycles() - startCycles;
+  auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+  return elapsed.count() > 0 ? (uint32_t)((cycles + elapsed.count() / 2) / elapsed.count()) : 1;
+#else
+  return ESP.getCpuFreqMHz();
+#endif
+}
+
+// ================== Serial Sink ==================
+static void setSerialLogging(bool enabled)
+{
+#ifdef GUITARPAL_NATIVE
+  Serial.setEcho(enabled);
+#else
+  if (enabled)
+  {
+    Serial.begin(115200);
+  }
+  else
+  {
+    Serial.flush();
+    Serial.end(); // prints still format, but nothing reaches the UART
+  }
+#endif
+}
+
+static void emit(const char *text)
+{
+#ifdef GUITARPAL_NATIVE
+  fputs(text, stdout);
+#else
+  Serial.print(text);
+#endif
+}
+
+// ================== Inputs ==================
+// G major open chord and the C major scale in first position, as the app sends them
+static const char chordText[] = "[-1, 3, 2, 0, 1, 0]";
+static const char altChordText[] = "[-1, 0, 2, 2, 1, 0]";
+static const char scaleText[] = "[[0, 0], [0, 1], [0, 3], [1, 0], [1, 2], [1, 3], [2, 0], [2, 2], "
+                                "[2, 3], [3, 0], [3, 2], [4, 0], [4, 1], [4, 3], [5, 0], [5, 1], [5, 3]]";
+
+static uint8_t chordFrame[CHORD_FRAME_SIZE];
+static uint8_t altChordFrame[CHORD_FRAME_SIZE];
+static uint8_t scaleFrame[FRAME_OVERHEAD + BENCH_MAX_SCALE_PAIRS];
+static size_t scaleFrameLength = 0;
+
+static int tokens[NUM_STRINGS];
+static int pixels[VALID_LEDS];
+static int scaleData[BENCH_MAX_SCALE_PAIRS][2];
+static int scaleCount = 0;
+static int notes[MAX_SCALE_NOTES];
+static int noteCount = 0;
+static volatile int sink; // keeps results live so calls are not optimised away
+static uint32_t iteration = 0;
+
+static size_t buildFrame(uint8_t *frame, uint8_t opcode, const uint8_t *payload, uint8_t length)
+{
+  frame[0] = FRAME_HEADER;
+  frame[1] = opcode;
+  frame[2] = length;
+  memcpy(frame + 3, payload, length);
+  frame[3 + length] = frameCrc8(frame, 3 + length);
+  return length + FRAME_OVERHEAD;
+}
+
+static void buildChordFrame(uint8_t *frame, const char *text)
+{
+  int frets[NUM_STRINGS];
+  parseChordCommand(text, strlen(text), frets, NUM_STRINGS);
+
+  uint8_t payload[CHORD_FRAME_PAYLOAD] = {0, 0, 0};
+  for (int string = 0; string < NUM_STRINGS; string++)
+  {
+    uint8_t nibble = (uint8_t)(frets[string] + 1);
+    payload[string / 2] |= (string % 2 == 0) ? (uint8_t)(nibble << 4) : nibble;
+  }
+  buildFrame(frame, FRAME_OP_CHORD, payload, CHORD_FRAME_PAYLOAD);
+}
+
+static void prepareInputs()
+{
+  buildChordFrame(chordFrame, chordText);
+  buildChordFrame(altChordFrame, altChordText);
+
+  int pairs[BENCH_MAX_SCALE_PAIRS][2];
+  int pairCount = parseScaleCommand(scaleText, strlen(scaleText), pairs, BENCH_MAX_SCALE_PAIRS);
+  uint8_t payload[BENCH_MAX_SCALE_PAIRS];
+  for (int i = 0; i < pairCount; i++)
+  {
+    payload[i] = (uint8_t)((pairs[i][0] << 4) | pairs[i][1]);
+  }
+  scaleFrameLength = buildFrame(scaleFrame, FRAME_OP_SCALE, payload, (uint8_t)pairCount);
+
+  parseChordCommand(chordText, strlen(chordText), tokens, NUM_STRINGS);
+  scaleCount = parseScaleCommand(scaleText, strlen(scaleText), scaleData, BENCH_MAX_SCALE_PAIRS);
+  noteCount = generateChordById(7, CHORD_MAJOR, notes); // G major, matches chordText
+}
+
+// ================== Stages ==================
+static void benchParseChordText()
+{
+  sink = parseChordCommand(chordText, sizeof(chordText) - 1, tokens, NUM_STRINGS);
+}
+
+// The original path: a String copy of the characteristic value, then the
+// String parser (legacy_parsers.h)
+static void benchParseChordString()
+{
+  String value(chordText);
+  sink = legacyParseChordCommand(value, tokens, NUM_STRINGS);
+}
+
+static void benchDecodeChordFrame()
+{
+  FrameView frame;
+  sink = decodeFrame(chordFrame, sizeof(chordFrame), &frame) ? decodeChordFrame(frame, tokens, NUM_STRINGS) : 0;
+}
+
+static void benchParseScaleText()
+{
+  sink = parseScaleCommand(scaleText, sizeof(scaleText) - 1, scaleData, BENCH_MAX_SCALE_PAIRS);
+}
+
+static void benchParseScaleString()
+{
+  String value(scaleText);
+  sink = legacyParseScaleCommand(value, scaleData, BENCH_MAX_SCALE_PAIRS);
+}
+
+static void benchDecodeScaleFrame()
+{
+  FrameView frame;
+  sink = decodeFrame(scaleFrame, scaleFrameLength, &frame) ? decodeScaleFrame(frame, scaleData, BENCH_MAX_SCALE_PAIRS) : 0;
+}
+
+static void benchConvertChord()
+{
+  convertChordPositionsToPixels(tokens, pixels);
+}
+
+static void benchConvertScale()
+{
+  convertScalePositionsToPixels(scaleData, scaleCount);
+}
+
+static void benchConvertShape()
+{
+  convertShapeToPixels(0, SCALE_MAJOR);
+}
+
+static void benchPixelCalculator()
+{
+  sink = pixelCalculator(notes, noteCount, pixels);
+}
+
+static void benchGenerateScale()
+{
+  sink = generateScale(9, "Harmonic Minor", notes);
+}
+
+static void benchGenerateChord()
+{
+  sink = generateChord(7, "Major 7", notes);
+}
+
+static void benchShow()
+{
+  FastLED.show();
+}
+
+// Every other iteration draws a different frame, so half the pushes change cells
+static void prepareChangedFrame()
+{
+  clearGrid();
+  if (iteration % 2 == 0)
+    convertShapeToPixels(0, SCALE_MAJOR);
+  else
+    convertShapeToPixels(7, SHAPE_CHORD_FLAG | CHORD_MAJOR);
+}
+
+static void benchPresentFrame()
+{
+  sink = presentFrame();
+}
+
+// Full chord path as the render task runs it, alternating chords so every push is real
+static void benchPipelineChordText()
+{
+  const char *text = (iteration % 2 == 0) ? chordText : altChordText;
+  int frets[NUM_STRINGS];
+  if (parseChordCommand(text, strlen(text), frets, NUM_STRINGS) == NUM_STRINGS)
+  {
+    clearGrid();
+    convertChordPositionsToPixels(frets, pixels);
+  }
+  sink = presentFrame();
+}
+
+static void benchPipelineChordString()
+{
+  String value((iteration % 2 == 0) ? chordText : altChordText);
+  int frets[NUM_STRINGS];
+  if (legacyParseChordCommand(value, frets, NUM_STRINGS) == NUM_STRINGS)
+  {
+    clearGrid();
+    convertChordPositionsToPixels(frets, pixels);
+  }
+  sink = presentFrame();
+}
+
+static void benchPipelineChordFrame()
+{
+  const uint8_t *data = (iteration % 2 == 0) ? chordFrame : altChordFrame;
+  int frets[NUM_STRINGS];
+  FrameView frame;
+  if (decodeFrame(data, CHORD_FRAME_SIZE, &frame) && decodeChordFrame(frame, frets, NUM_STRINGS) == NUM_STRINGS)
+  {
+    clearGrid();
+    convertChordPositionsToPixels(frets, pixels);
+  }
+  sink = presentFrame();
+}
+
+// Every effect on at once: a cross-fade into a scale that is still being
+// revealed, pulsing, with the metronome flashing
+static void prepareEffectsFrame()
+{
+  static const uint8_t settings[][4] = {
+      {EFFECT_OP_TRANSITIONS, 0xE8, 0x03, 0x64}, // 1000 ms fade, 100 ms reveal step
+      {EFFECT_OP_PULSE, 0xE8, 0x03},
+      {EFFECT_OP_METRONOME, 0x78, 0x00, 0x04},
+  };
+  static const uint8_t lengths[] = {5, 3, 4};
+  if (iteration == 0)
+  {
+    for (size_t i = 0; i < sizeof(lengths); i++)
+    {
+      FrameView frame = {FRAME_OP_EFFECTS, lengths[i], settings[i]};
+      effectsHandleFrame(frame);
+    }
+  }
+
+  PixelCommand command;
+  command.type = CMD_SHAPE;
+  command.root = 0;
+  command.shapeType = SCALE_MAJOR;
+  clearGrid();
+  convertShapeToPixels(command.root, command.shapeType);
+  effectsNewTarget(&command);
+}
+
+static void benchEffectsCompose()
+{
+  sink = effectsCompose();
+}
+
+// A C major target against a hand with one finger a string off
+static void benchChordCheckCompare()
+{
+  static const int frets[NUM_STRINGS] = {-1, 3, 2, 0, 1, 0};
+  static ChordTarget target;
+  static CellMask pressed;
+  if (iteration == 0)
+  {
+    chordTargetFromFrets(target, frets);
+    cellMaskClear(pressed);
+    cellMaskSet(pressed, 3 * NUM_STRINGS + 1);
+    cellMaskSet(pressed, 2 * NUM_STRINGS + 2);
+    cellMaskSet(pressed, 1 * NUM_STRINGS + 5);
+  }
+
+  ChordCheckResult result;
+  chordCheckCompare(target, pressed, result);
+  sink = result.correct + result.wrongCount;
+}
+
+// Low E with two harmonics: the lowest string searches the most lags
+static void benchEstimatePitch()
+{
+  static int16_t frame[PITCH_FRAME_SAMPLES];
+  if (iteration == 0)
+  {
+    for (int i = 0; i < PITCH_FRAME_SAMPLES; i++)
+    {
+      float phase = 2 * (float)M_PI * 82.41f * i / AUDIO_SAMPLE_RATE;
+      frame[i] = (int16_t)(800 * sinf(phase) + 400 * sinf(2 * phase + 1));
+    }
+  }
+
+  PitchEstimate estimate;
+  estimatePitch(frame, &estimate);
+  sink = (int)estimate.periodQ8;
+}
+
+// Scoring a strum: window, FFT and note fit of a C major triad with harmonics
+static void benchChordChroma()
+{
+  static ChordListenState state;
+  static int16_t frame[CHORD_FRAME_SAMPLES];
+  if (iteration == 0)
+  {
+    const float notes[3] = {130.81f, 164.81f, 196.00f};
+    for (int i = 0; i < CHORD_FRAME_SAMPLES; i++)
+    {
+      float sample = 0;
+      for (float hz : notes)
+      {
+        float phase = 2 * (float)M_PI * hz * i / AUDIO_SAMPLE_RATE;
+        sample += 300 * sinf(phase) + 150 * sinf(2 * phase) + 75 * sinf(3 * phase);
+      }
+      frame[i] = (int16_t)sample;
+    }
+  }
+
+  float chroma[12];
+  chordChroma(state, frame, CHORD_FRAME_SAMPLES, chroma);
+  sink = chordMatchScore(chroma, chordPitchSet(0, CHORD_MAJOR));
+}
+
+// One block with a strum attack half way through: every hop is scanned
+// and one onset refined
+static int16_t onsetBlock[AUDIO_BLOCK_SAMPLES];
+static OnsetDetector onsetDetector;
+
+static void prepareOnsetDetect()
+{
+  static bool built = false;
+  if (!built)
+  {
+    for (int i = 0; i < AUDIO_BLOCK_SAMPLES; i++)
+    {
+      float phase = 2 * (float)M_PI * 110.0f * i / AUDIO_SAMPLE_RATE;
+      onsetBlock[i] = (int16_t)(i < AUDIO_BLOCK_SAMPLES / 2 ? 20 * sinf(phase) : 900 * sinf(phase) + (i * 7919 % 401) - 200);
+    }
+    built = true;
+  }
+  onsetDetectorReset(onsetDetector);
+}
+
+static void benchOnsetDetect()
+{
+  int64_t onsets[ONSET_MAX_PER_BLOCK];
+  sink = detectOnsets(onsetDetector, onsetBlock, 0, onsets);
+}
+
+// Every other sample swaps standard tuning for DADGAD with a capo and back,
+// so every string is rebuilt: the worst case for a new tuning
+static void benchRetuneFretboard()
+{
+  bool swap = (iteration & 1) == 0;
+  sink = retuneFretboard(tuningPresetMidi[swap ? TUNING_DADGAD : TUNING_STANDARD], swap ? TUNING_MAX_CAPO : 0);
+}
+
+// Back to standard tuning on the first sample, then nothing changes
+static void benchRetuneUnchanged()
+{
+  sink = retuneFretboard(tuningPresetMidi[TUNING_STANDARD], 0);
+}
+
+// A minor 9 searches the most nodes of any chord in standard tuning
+static void benchSolveVoicings()
+{
+  static VoicingSet set;
+  sink = (int)solveVoicings(chordPitchSet(9, CHORD_MINOR_9), 9, tuningPresetMidi[TUNING_STANDARD], 0, set);
+}
+
+// Cycling through a full cache: every lookup hits
+static void benchChordVoicingsCached()
+{
+  sink = chordVoicings(iteration % VOICING_CACHE_SIZE, CHORD_MAJOR).count;
+}
+
+static void benchEmpty()
+{
+}
+
+struct BenchStage
+{
+  const char *name;
+  void (*prepare)(); // untimed, runs before every sample (may be nullptr)
+  void (*run)();
+};
+
+static const BenchStage stages[] = {
+    {"clock_overhead", nullptr, benchEmpty},
+    {"parseChordCommand_string", nullptr, benchParseChordString},
+    {"parseChordCommand", nullptr, benchParseChordText},
+    {"decodeChordFrame", nullptr, benchDecodeChordFrame},
+    {"parseScaleCommand_string", nullptr, benchParseScaleString},
+    {"parseScaleCommand", nullptr, benchParseScaleText},
+    {"decodeScaleFrame", nullptr, benchDecodeScaleFrame},
+    {"convertChordPositionsToPixels", clearGrid, benchConvertChord},
+    {"convertScalePositionsToPixels", clearGrid, benchConvertScale},
+    {"convertShapeToPixels", clearGrid, benchConvertShape},
+    {"pixelCalculator", nullptr, benchPixelCalculator},
+    {"generateScale", nullptr, benchGenerateScale},
+    {"generateChord", nullptr, benchGenerateChord},
+    {"FastLED.show", nullptr, benchShow},
+    {"presentFrame", prepareChangedFrame, benchPresentFrame},
+    {"presentFrame_unchanged", nullptr, benchPresentFrame},
+    {"effectsCompose", prepareEffectsFrame, benchEffectsCompose},
+    {"chordCheckCompare", nullptr, benchChordCheckCompare},
+    {"estimatePitch", nullptr, benchEstimatePitch},
+    {"chordChroma", nullptr, benchChordChroma},
+    {"detectOnsets", prepareOnsetDetect, benchOnsetDetect},
+    {"retuneFretboard", nullptr, benchRetuneFretboard},
+    {"retuneFretboard_unchanged", nullptr, benchRetuneUnchanged},
+    {"solveVoicings", nullptr, benchSolveVoicings},
+    {"chordVoicings_cached", nullptr, benchChordVoicingsCached},
+    {"pipeline_chord_string", nullptr, benchPipelineChordString},
+    {"pipeline_chord_text", nullptr, benchPipelineChordText},
+    {"pipeline_chord_frame", nullptr, benchPipelineChordFrame},
+};
+
+#define STAGE_COUNT (sizeof(stages) / sizeof(stages[0]))
+
+// ================== Runner ==================
+struct BenchResult
+{
+  uint32_t p50;
+  uint32_t p99;
+  uint32_t min;
+  uint32_t max;
+};
+
+static uint32_t samples[BENCH_ITERATIONS];
+static BenchResult results[2][STAGE_COUNT]; // [serial logging on][stage]
+
+static BenchResult runStage(const BenchStage &stage)
+{
+  for (iteration = 0; iteration < BENCH_WARMUP + BENCH_ITERATIONS; iteration++)
+  {
+    if (stage.prepare != nullptr)
+      stage.prepare();
+
+    uint32_t start = benchCycles();
+    stage.run();
+    uint32_t cycles = benchCycles() - start;
+
+    if (iteration >= BENCH_WARMUP)
+      samples[iteration - BENCH_WARMUP] = cycles;
+  }
+
+  std::sort(samples, samples + BENCH_ITERATIONS);
+  BenchResult result;
+  result.p50 = samples[BENCH_ITERATIONS / 2];
+  result.p99 = samples[(BENCH_ITERATIONS * 99) / 100];
+  result.min = samples[0];
+  result.max = samples[BENCH_ITERATIONS - 1];
+  return result;
+}
+
+static uint32_t toNanoseconds(uint32_t cycles, uint32_t ticksPerMicrosecond)
+{
+  return (uint32_t)(((uint64_t)cycles * 1000 + ticksPerMicrosecond / 2) / ticksPerMicrosecond);
+}
+
+static void printReport(uint32_t ticksPerMicrosecond)
+{
+  char line[224];
+  snprintf(line, sizeof(line),
+           "{\"build\": \"%s\", \"platform\": \"%s\", \"clock\": \"%s\", \"ticks_per_us\": %u, "
+           "\"iterations\": %u, \"leds\": %u, \"cells\": %u, \"results\": [\n",
+           BENCH_BUILD_ID, BENCH_PLATFORM, BENCH_CLOCK_NAME, (unsigned)ticksPerMicrosecond,
+           (unsigned)BENCH_ITERATIONS, (unsigned)NUM_LEDS, (unsigned)VALID_LEDS);
+  emit(line);
+
+  for (int serial = 0; serial < 2; serial++)
+  {
+    for (size_t i = 0; i < STAGE_COUNT; i++)
+    {
+      const BenchResult &result = results[serial][i];
+      bool last = (serial == 1 && i == STAGE_COUNT - 1);
+      snprintf(line, sizeof(line),
+               "  {\"stage\": \"%s\", \"serial\": %s, \"p50\": %u, \"p99\": %u, \"min\": %u, \"max\": %u, "
+               "\"p50_ns\": %u, \"p99_ns\": %u}%s\n",
+               stages[i].name, serial ? "true" : "false", (unsigned)result.p50, (unsigned)result.p99,
+               (unsigned)result.min, (unsigned)result.max, (unsigned)toNanoseconds(result.p50, ticksPerMicrosecond),
+               (unsigned)toNanoseconds(result.p99, ticksPerMicrosecond), last ? "" : ",");
+      emit(line);
+    }
+  }
+  emit("]}\n");
+}
+
+void runBenchmarks()
+{
+  uint32_t ticksPerMicrosecond = clockTicksPerMicrosecond();
+  prepareInputs();
+
+  for (int serial = 0; serial < 2; serial++)
+  {
+    setSerialLogging(serial == 1);
+    for (size_t i = 0; i < STAGE_COUNT; i++)
+    {
+      results[serial][i] = runStage(stages[i]);
+    }
+  }
+
+  setSerialLogging(true);
+#ifndef GUITARPAL_NATIVE
+  Serial.flush();
+  delay(100);
+  emit("\n"); // separate the report from the logging run's output
+#else
+  Serial.setEcho(false);
+#endif
+  printReport(ticksPerMicrosecond);
+}
+
+#ifdef GUITARPAL_NATIVE
+void setup();
+
+int main()
+{
+  setup();
+  fflush(stdout);
+  fflush(stderr);
+  _Exit(0);
+}
+#endif
@@ -0,0 +1,82 @@
+#ifndef AUDIO_INPUT_H
+#define AUDIO_INPUT_H
+
+#include <Arduino.h>
+#include "ble_protocol.h"
+
+// ================== Audio Input ==================
+// A mic or pickup preamp on AUDIO_ADC_PIN, sampled by the I2S peripheral in
+// built-in ADC mode: DMA fills AUDIO_DMA_BUFFERS buffers at AUDIO_SAMPLE_RATE
+// and the audio task wakes once per AUDIO_BLOCK_SAMPLES, turns the readings
+// into signed samples around the tracked DC level and hands the block to the
+// analysis the app selected. Capture runs only while a mode is selected; the
+// task then keeps the CPU at full speed (audioCaptureBegin in supervisor.h).
+// Uses the legacy I2S driver (Arduino-ESP32 2.x); ADC1 only.
+//
+// Built only with -DGUITARPAL_AUDIO (boards with the input fitted); otherwise
+// FRAME_OP_AUDIO is rejected with REJECT_UNSUPPORTED.
+#ifdef GUITARPAL_AUDIO
+#define AUDIO_ENABLED 1
+#else
+#define AUDIO_ENABLED 0
+#endif
+
+#define AUDIO_ADC_PIN 34           // ADC1 channel 6
+#define AUDIO_ADC_CHANNEL ADC1_CHANNEL_6
+#define AUDIO_SAMPLE_RATE 16000
+#define AUDIO_BLOCK_SAMPLES 256    // 16 ms
+#define AUDIO_DMA_BUFFERS 4        // 64 ms of slack before samples are lost
+#define AUDIO_SAMPLE_MAX 2047      // samples are 12-bit signed
+#define AUDIO_DC_SHIFT 3           // DC level follows the block mean with weight 1/8
+#define AUDIO_CLOCK_SLEW_US 16     // per block: follows an ADC clock up to 0.1% slow
+
+#define AUDIO_TASK_CORE 1
+#define AUDIO_TASK_PRIORITY 1 // below the render task
+#define AUDIO_TASK_STACK 4096
+
+// FRAME_OP_AUDIO payload is [AudioMode] or [AudioMode][argument], written to
+// the sequence characteristic
+enum AudioMode : uint8_t
+{
+  AUDIO_MODE_OFF,
+  AUDIO_MODE_TUNER, // tuner.h
+  AUDIO_MODE_CHORD, // chord_listen.h
+  AUDIO_MODE_RHYTHM, // rhythm.h; argument: strums per beat (default 1)
+  AUDIO_MODE_COUNT
+};
+
+struct AudioStats
+{
+  uint32_t blocks;
+  uint32_t shortReads;     // reads that came back without a full block
+  uint32_t maxBlockMicros; // longest analysis of one block
+};
+
+// Install the I2S driver and create the audio task. Call once from setup().
+void setupAudio();
+
+// Apply a FRAME_OP_AUDIO frame (BLE task). Returns 0, or the
+// EVENT_COMMAND_REJECTED reason.
+uint8_t audioHandleFrame(const FrameView &frame);
+
+// Stop capturing, e.g. when the app disconnects (any task)
+void stopAudio();
+
+// When a block's first sample was taken, on the esp_timer clock. readAtUs is
+// when the read returned and samplesBefore the samples captured before the
+// block. A read returns as the DMA fills a buffer, or later if the task was
+// held up; the earliest return seen (less the samples since) places the
+// sample clock, allowed to creep AUDIO_CLOCK_SLEW_US later per block so a
+// slow ADC clock is followed. offsetUs is the state, INT64_MIN for a fresh
+// capture. Pure computation.
+int64_t audioBlockStartUs(int64_t readAtUs, uint64_t samplesBefore, int64_t &offsetUs);
+
+// DMA words to samples: the 12-bit reading is the low bits of each word and
+// the DMA stores every pair of samples swapped. dcLevel (reading << 8) is
+// updated from the block. Pure computation.
+void audioConvertBlock(const uint16_t *raw, int16_t *samples, int count, int32_t &dcLevel);
+
+// Snapshot of the capture counters
+AudioStats getAudioStats();
+
+#endif // AUDIO_INPUT_H
@@ -0,0 +1,18 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+// ================== Pipeline Benchmarks ==================
+// Only built with -DGUITARPAL_BENCH (the *_bench environments); sources in bench/.
+// Each stage of the command-to-LED path is timed on its own in cycles, once
+// with Serial logging live and once with it shut off, and the p50/p99 figures
+// are printed as a single JSON document (Serial on target, stdout on host).
+#ifndef BENCH_ITERATIONS
+#define BENCH_ITERATIONS 201
+#endif
+#define BENCH_WARMUP 8
+
+// Run every stage and print the JSON report. Called from setup() instead of
+// starting the render task and BLE.
+void runBenchmarks();
+
+#endif // BENCHMARKS_H
@@ -0,0 +1,93 @@
+#ifndef BLE_PROTOCOL_H
+#define BLE_PROTOCOL_H
+
+#include <Arduino.h>
+
+// ================== Binary Frame Protocol ==================
+// Frame layout: [header][opcode][length][payload ...][crc8]
+//   header  - high nibble is the magic 0xA, low nibble the protocol version
+//   opcode  - FRAME_OP_* below
+//   length  - number of payload bytes that follow
+//   crc8    - CRC-8 (poly 0x07) over header, opcode, length and payload
+//
+// Chord payload: 3 bytes, one nibble per string (string 0 in the high nibble
+// of byte 0). Nibble value is fret + 1, so 0 = muted, 1 = open, 2..15 = frets 1-14.
+// Scale payload: one byte per string/fret pair, string in the high nibble and
+// fret in the low nibble.
+// Shape payload: 2 bytes, root pitch class (0 = C) and ShapeType from shape_index.h,
+// and for chords an optional third: which voicing (chord_voicing.h), 0 = easiest.
+// Sequence payload: [op][args], uploads and controls the sequencer (sequencer.h).
+// Effects payload: [op][args], transitions and animations (effects.h).
+// Audio payload: [mode] or [mode][argument], selects what the board listens for
+// (audio_input.h).
+// Tuning payload: [preset][capo] or [custom][capo][6 MIDI notes], the tuning
+// the chord and scale data are fitted to (guitar_tuning.h).
+// Events payload: a batch of board events, notified by the board (event_stream.h).
+//
+// Text payloads such as "[-1, 3, 2, 0, 1, 0]" never start with the header byte,
+// so they are still accepted through the legacy parsers in data_handling.cpp.
+#define FRAME_MAGIC 0xA0
+#define FRAME_MAGIC_MASK 0xF0
+#define FRAME_VERSION 0x01
+#define FRAME_HEADER (FRAME_MAGIC | FRAME_VERSION)
+#define FRAME_OVERHEAD 4 // header + opcode + length + crc
+#define FRAME_MAX_PAYLOAD 64
+
+#define FRAME_OP_CHORD 0x01
+#define FRAME_OP_SCALE 0x02
+#define FRAME_OP_SHAPE 0x03
+#define FRAME_OP_SEQUENCE 0x04
+#define FRAME_OP_EFFECTS 0x05
+#define FRAME_OP_AUDIO 0x06
+#define FRAME_OP_TUNING 0x07
+#define FRAME_OP_EVENTS 0x10 // board -> app only, see event_stream.h
+#define FRAME_OP_LINK 0x11   // board -> app only, see link_tuning.h
+
+#define CHORD_FRAME_PAYLOAD 3
+#define CHORD_FRAME_SIZE (FRAME_OVERHEAD + CHORD_FRAME_PAYLOAD) // 7 bytes
+
+// View into a validated frame; payload points into the caller's buffer
+struct FrameView
+{
+  uint8_t opcode;
+  uint8_t length;
+  const uint8_t *payload;
+};
+
+// Little-endian field writers for board -> app payloads
+inline void frameStoreU16(uint8_t *out, uint16_t value)
+{
+  out[0] = (uint8_t)value;
+  out[1] = (uint8_t)(value >> 8);
+}
+
+inline void frameStoreU32(uint8_t *out, uint32_t value)
+{
+  frameStoreU16(out, (uint16_t)value);
+  frameStoreU16(out + 2, (uint16_t)(value >> 16));
+}
+
+// CRC-8 (poly 0x07, init 0x00) used to protect every frame
+uint8_t frameCrc8(const uint8_t *data, size_t length);
+
+// Wrap a payload into a frame. out must hold length + FRAME_OVERHEAD bytes.
+// Returns the frame size, or 0 if the payload is too long.
+size_t encodeFrame(uint8_t opcode, const uint8_t *payload, size_t length, uint8_t *out);
+
+// True if the buffer starts with a header byte this firmware understands
+bool isBinaryFrame(const uint8_t *data, size_t length);
+
+// Validate header, length and CRC in place. Returns false on any mismatch.
+bool decodeFrame(const uint8_t *data, size_t length, FrameView *frame);
+
+// Unpack a chord frame into 6 fret tokens (-1 muted, 0 open). Returns token count or 0.
+int decodeChordFrame(const FrameView &frame, int *tokens, int maxTokens);
+
+// Unpack a scale frame into string/fret pairs. Returns pair count or 0.
+int decodeScaleFrame(const FrameView &frame, int scaleData[][2], int maxPairs);
+
+// Unpack a shape frame into its (root, type) ID and voicing (0 if not given).
+// Returns false if the frame is not a shape.
+bool decodeShapeFrame(const FrameView &frame, int *root, int *type, int *voicing);
+
+#endif // BLE_PROTOCOL_H
@@ -14,12 +14,24 @@
 #define PIXEL_SERVICE_UUID "c3c50c29-d4a5-4998-b382-62dcc1845e10"
 #define CHORD_PIXEL_CHAR_UUID "c3c50c29-d4a5-4998-b382-62dcc1845e11"
 #define SCALE_PIXEL_CHAR_UUID "c3c50c29-d4a5-4998-b382-62dcc1845e12"
+#define EVENT_CHAR_UUID "c3c50c29-d4a5-4998-b382-62dcc1845e13" // notify only, see event_stream.h
+#define LINK_CHAR_UUID "c3c50c29-d4a5-4998-b382-62dcc1845e14"  // granted link parameters, see link_tuning.h
+#define FAST_PIXEL_CHAR_UUID "c3c50c29-d4a5-4998-b382-62dcc1845e15" // write-without-response fast path
+#define SEQUENCE_CHAR_UUID "c3c50c29-d4a5-4998-b382-62dcc1845e16"   // sequencer upload and control, effects; see sequencer.h, effects.h
+
+// Attribute handles for the pixel service: one for the service, two per
+// characteristic and one per descriptor. The library default of 15 is too few.
+#define PIXEL_SERVICE_HANDLES 32
 
 // Declare global BLE objects (definition goes in .cpp)
 extern BLEServer *pServer;
 extern BLECharacteristic *pInitCharacteristic;
 extern BLECharacteristic *pChordPixelCharacteristic;
 extern BLECharacteristic *pScalePixelCharacteristic;
+extern BLECharacteristic *pEventCharacteristic;
+extern BLECharacteristic *pLinkCharacteristic;
+extern BLECharacteristic *pFastPixelCharacteristic;
+extern BLECharacteristic *pSequenceCharacteristic;
 
 // Function prototypes
 void setupBluetooth();
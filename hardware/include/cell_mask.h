@@ -0,0 +1,43 @@
+#ifndef CELL_MASK_H
+#define CELL_MASK_H
+
+#include <stdint.h>
+#include "fretboard_layout.h"
+
+// ================== Cell Mask ==================
+// One bit per fret cell (bit index = fret * FRETBOARD_STRINGS + string), sized
+// for the configured neck. The 8x8 grid needs a single 64-bit word.
+#define CELL_MASK_WORDS ((FRETBOARD_CELLS + 63) / 64)
+
+struct CellMask
+{
+  uint64_t words[CELL_MASK_WORDS];
+};
+
+constexpr void cellMaskClear(CellMask &mask)
+{
+  for (int i = 0; i < CELL_MASK_WORDS; i++)
+    mask.words[i] = 0;
+}
+
+constexpr void cellMaskSet(CellMask &mask, int cell)
+{
+  mask.words[cell / 64] |= (uint64_t)1 << (cell % 64);
+}
+
+constexpr bool cellMaskTest(const CellMask &mask, int cell)
+{
+  return (mask.words[cell / 64] >> (cell % 64)) & 1;
+}
+
+constexpr bool cellMaskEmpty(const CellMask &mask)
+{
+  for (int i = 0; i < CELL_MASK_WORDS; i++)
+  {
+    if (mask.words[i] != 0)
+      return false;
+  }
+  return true;
+}
+
+#endif // CELL_MASK_H
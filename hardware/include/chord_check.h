@@ -0,0 +1,65 @@
+#ifndef CHORD_CHECK_H
+#define CHORD_CHECK_H
+
+#include <Arduino.h>
+#include "cell_mask.h"
+#include "command_queue.h"
+
+// ================== Chord Check ==================
+// While a chord is on the LEDs, the cells the touch matrix senses are compared
+// with the fingers the chord needs. Both are cell masks, so a check is a few
+// ANDs and popcounts per 64-bit word, run by the touch task whenever the
+// pressed mask changes: feedback follows the scan rate, not the phone.
+//
+//   missing = fingers & ~pressed    a chord finger that is not down
+//   wrong   = pressed & ~allowed    a pressed cell the chord does not use
+//
+// allowed is the fingers plus the cells behind each one on its string (a barre
+// or a finger resting behind the fretted note does not change the sound) and
+// the nut row, which is never a finger. Feedback is drawn over the chord once
+// the player has put a finger down, and every change is reported as
+// EVENT_CHORD_CHECK. Chords only: scales and masks clear the target.
+#define CHECK_COLOR_MISSING 0xFF8000 // orange
+#define CHECK_COLOR_WRONG 0xFF0000   // red
+
+// EVENT_CHORD_CHECK state
+#define CHECK_PROGRESS 0 // fingers moved
+#define CHECK_CORRECT 1  // first time every finger is down and nothing else; time is time-to-correct
+#define CHECK_MISSED 2   // the chord was replaced before it was played correctly
+
+struct ChordTarget
+{
+  CellMask fingers;
+  CellMask allowed;
+  uint8_t fingerCount;
+};
+
+struct ChordCheckResult
+{
+  CellMask missing;
+  CellMask wrong;
+  uint8_t correct;    // chord fingers down
+  uint8_t wrongCount; // cells pressed that should not be
+};
+
+// Target for a fret per string (fret row of the finger; 0 open, negative muted)
+void chordTargetFromFrets(ChordTarget &target, const int *frets);
+
+// Compare a pressed mask with the target. Pure computation.
+void chordCheckCompare(const ChordTarget &target, const CellMask &pressed, ChordCheckResult &result);
+
+// A command was drawn, or the grid cleared if command is nullptr: a chord
+// becomes the target, anything else clears it (render task)
+void chordCheckNewTarget(const PixelCommand *command);
+
+// The debounced pressed mask changed (touch task)
+void chordCheckTouch(const CellMask &pressed);
+
+// True if the feedback changed since the last call, so the frame has to be
+// recomposed before chordCheckPaint() (render task)
+bool chordCheckFeedbackChanged();
+
+// Draw missing and wrong cells over backBuffer (render task)
+void chordCheckPaint();
+
+#endif // CHORD_CHECK_H
@@ -0,0 +1,120 @@
+#ifndef CHORD_LISTEN_H
+#define CHORD_LISTEN_H
+
+#include <Arduino.h>
+#include "audio_input.h"
+#include "command_queue.h"
+#include "fft.h"
+#include "scale_and_chord_notes.h"
+
+// ================== Chord Listening ==================
+// AUDIO_MODE_CHORD: scores each strum against the chord on the LEDs. A block
+// whose energy jumps CHORD_ONSET_RATIO over the recent level starts a strum;
+// the strum's first CHORD_ONSET_CHUNK-sample chunk to jump over the block
+// before it marks where its frame begins, and CHORD_DECIDE_BLOCKS later the
+// audio from there on (CHORD_MIN_FRAME_SAMPLES to CHORD_FRAME_SAMPLES) is
+// Hann-windowed, zero-padded to FFT_SIZE and transformed.
+//
+// The frame is too short to resolve semitones below about 500 Hz, so the
+// chroma does not come from spectral peaks. The magnitude spectrum between
+// CHORD_MIN_HZ and CHORD_MAX_HZ is fitted instead, by CHORD_FIT_ITERATIONS
+// multiplicative (KL) non-negative updates, squared to converge in half the
+// iterations, with one harmonic template per note from CHORD_LOW_NOTE to
+// CHORD_HIGH_NOTE (partials at 1/h, each shaped like the window's main lobe
+// for this frame length) plus CHORD_NOISE_ATOMS broad bumps that take up the
+// pick noise. A note's activation is how much of the spectrum its whole
+// harmonic series explains, so the upper partials, which are resolved,
+// settle which of two merged bass notes is playing. The chroma sums the
+// activations per pitch class.
+//
+// A pitch class is heard with CHORD_HEARD_RATIO of the strongest. The score
+// is the cosine between the chroma and the chord's pitch-class set
+// (chordPitchSet, the set generateChord() expands) times the chord's
+// coverage: each chord tone counts in full once heard and in proportion
+// below that, as cosine alone gives a chord sharing two of three notes most
+// of the score. Synthetic strums of twelve open and barre chords score
+// around 80 for the right chord, about 40 above the best chord sharing at
+// most one note and about 25 above the best sharing two (35-40 between C
+// and Am, the test in test/test_chord_listen); a fifth over the root is
+// also the root's third harmonic, which keeps such pairs the closest.
+//
+// The score arrives within 50 ms of the strum: at most 48 ms of audio plus
+// the transform and the fit (about 130k multiply-adds, under 2 ms on the
+// ESP32 by count), and EVENT_CHORD_MATCH skips the event batching delay. A
+// slow strum is scored on the strings it has reached by then.
+#define CHORD_DECIDE_BLOCKS 2                                              // after the onset block
+#define CHORD_FRAME_SAMPLES ((CHORD_DECIDE_BLOCKS + 1) * AUDIO_BLOCK_SAMPLES) // 48 ms
+#define CHORD_HISTORY_SAMPLES (CHORD_FRAME_SAMPLES + AUDIO_BLOCK_SAMPLES)    // and the block before
+#define CHORD_ONSET_CHUNK 32                                               // 2 ms
+#define CHORD_MIN_FRAME_SAMPLES (CHORD_FRAME_SAMPLES - AUDIO_BLOCK_SAMPLES + CHORD_ONSET_CHUNK)
+#define CHORD_MIN_HZ 60
+#define CHORD_MAX_HZ 2000
+#define CHORD_LOW_NOTE 40          // E2, the open low string
+#define CHORD_HIGH_NOTE 84         // C6
+#define CHORD_NOTES (CHORD_HIGH_NOTE - CHORD_LOW_NOTE + 1)
+#define CHORD_NOISE_ATOMS 4
+#define CHORD_FIT_ITERATIONS 15
+#define CHORD_LOBE_BINS 10         // main lobe of the shortest frame, in FFT bins
+#define CHORD_LOBE_PHASES 8        // partial positions per bin
+#define CHORD_HEARD_RATIO 0.4f     // pitch classes with this share of the strongest are heard
+#define CHORD_ONSET_RATIO 4        // energy over the level: +6 dB is a strum
+#define CHORD_MIN_RMS 32           // quieter blocks never start a strum (as PITCH_MIN_RMS)
+#define CHORD_REFRACTORY_BLOCKS 6  // about 100 ms between strums
+#define CHORD_LEVEL_SHIFT 2        // level follows block energy with weight 1/4
+
+#define CHORD_MIN_BIN (CHORD_MIN_HZ * FFT_SIZE / AUDIO_SAMPLE_RATE)
+#define CHORD_MAX_BIN (CHORD_MAX_HZ * FFT_SIZE / AUDIO_SAMPLE_RATE)
+#define CHORD_FIT_BINS (CHORD_MAX_BIN + CHORD_LOBE_BINS) // partials' lobes may reach past CHORD_MAX_BIN
+
+struct ChordMatch
+{
+  uint8_t score;         // percent
+  PitchClassSet heard;   // pitch classes with CHORD_HEARD_RATIO of the strongest
+  float chroma[12];      // note activation per pitch class, 0 = C
+  uint16_t frameSamples; // audio scored, from the strum's start
+};
+
+struct ChordListenState
+{
+  int16_t history[CHORD_HISTORY_SAMPLES];                // newest samples last
+  uint32_t level;                                        // block energy envelope
+  int pending;                                           // blocks until the strum is scored, -1 if none
+  int refractory;                                        // blocks until another strum may start
+  float spectrum[FFT_SIZE];                              // scratch
+  float power[FFT_BINS];                                 // scratch, magnitude after the transform
+  float lobe[CHORD_LOBE_PHASES][CHORD_LOBE_BINS];        // scratch: main lobe for this frame length
+  float noteNorm[CHORD_NOTES];                           // scratch: template sums within the fit range
+  float activation[CHORD_NOTES + CHORD_NOISE_ATOMS];     // scratch
+  float model[CHORD_FIT_BINS];                           // scratch: fitted spectrum, then data / fit
+};
+
+// Forget any strum in progress
+void chordListenStateReset(ChordListenState &state);
+
+// Chroma vector of a frame of CHORD_MIN_FRAME_SAMPLES to CHORD_FRAME_SAMPLES
+// samples. Pure computation.
+void chordChroma(ChordListenState &state, const int16_t *frame, int samples, float *chroma);
+
+// Cosine between a chroma vector and a pitch-class set times the share of
+// the chord's tones heard, in percent
+uint8_t chordMatchScore(const float *chroma, PitchClassSet chord);
+
+// Feed one AUDIO_BLOCK_SAMPLES block. Returns true with a match when a strum
+// has been scored against chord. Pure computation, so the host can run
+// recordings through it.
+bool chordListenAnalyze(ChordListenState &state, const int16_t *block, PitchClassSet chord, ChordMatch *match);
+
+// Pitch classes of a command's chord, 0 if it is not a chord: sounding
+// strings of a fret chord, chordPitchSet() of a chord shape
+PitchClassSet chordCommandPitchSet(const PixelCommand &command);
+
+// A command was drawn, or the grid cleared if command is nullptr (render task)
+void chordListenNewTarget(const PixelCommand *command);
+
+// Chord mode entered (audio task)
+void resetChordListen();
+
+// Analyse a block and report strums (audio task)
+void chordListenProcessBlock(const int16_t *block);
+
+#endif // CHORD_LISTEN_H
@@ -0,0 +1,66 @@
+#ifndef CHORD_VOICING_H
+#define CHORD_VOICING_H
+
+#include <Arduino.h>
+#include "fretboard_layout.h"
+#include "scale_and_chord_notes.h"
+
+// ================== Chord Voicings ==================
+// Playable fingerings of any chordCatalogue chord on the grid, for the
+// current tuning and capo (guitar_tuning.h). A depth-first search runs from
+// the low string up; on each string it tries every fret from the capo up
+// whose note is in the chord, then muting it. A voicing must:
+//   - sound at least VOICING_MIN_STRINGS strings (one more than the chord
+//     has notes, for two- and three-note chords), all adjacent;
+//   - have the root as its lowest note;
+//   - contain every chord tone, except that chords of four or more notes
+//     may leave out the perfect fifth;
+//   - fit in VOICING_MAX_SPAN frets and VOICING_MAX_FINGERS fingers. With
+//     more fretted notes than fingers, the lowest fret must be on two or
+//     more strings with no open string between them: one finger barres it.
+// Partial voicings are cut off as soon as they break a rule, can no longer
+// supply the missing tones from the strings left, or cannot score under the
+// worst voicing kept once VOICING_MAX_RESULTS are found (branch and bound:
+// the cost only grows as strings are added). The cost adds two per muted
+// string and per left-out tone, plus the hand position above the capo, the
+// span, the fingers and two for a barre.
+//
+// chordVoicings() keeps the results of the last VOICING_CACHE_SIZE chords
+// (least recently used goes first), keyed by root, chord, open strings and
+// capo, so switching back and forth between chords or tunings solves once.
+// A cold solve visits at most about 450 nodes (11 us on the host); a cache
+// hit costs a scan of the keys.
+#define VOICING_MAX_RESULTS 8
+#define VOICING_MAX_SPAN 3    // lowest to highest fretted note: four frets under the hand
+#define VOICING_MAX_FINGERS 4 // thumb not used
+#define VOICING_MIN_STRINGS 4
+#define VOICING_CACHE_SIZE 8
+#define VOICING_MUTED -1
+
+struct ChordVoicing
+{
+  int8_t frets[6]; // per string, low string first: VOICING_MUTED, or the fret (the capo's fret plays open)
+  uint8_t barre;   // fret one finger barres, 0 for none
+  uint8_t fingers;
+  uint8_t cost;    // lower is easier
+};
+
+struct VoicingSet
+{
+  uint8_t count;
+  ChordVoicing voicings[VOICING_MAX_RESULTS]; // easiest first
+};
+
+// Search the voicings of `chord` (a pitch-class set, root at `root`) for
+// open strings openMidi (6 MIDI notes) and a capo. Fills set with the
+// easiest, returns the number of search nodes visited. Pure computation.
+uint32_t solveVoicings(PitchClassSet chord, int root, const uint8_t *openMidi, int capo, VoicingSet &set);
+
+// Voicings of a chordCatalogue chord on the current neck, from the cache or
+// solved now (render task). Empty for unknown IDs.
+const VoicingSet &chordVoicings(int root, int chordId);
+
+// Forget every cached chord
+void clearVoicingCache();
+
+#endif // CHORD_VOICING_H
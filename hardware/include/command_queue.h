@@ -0,0 +1,62 @@
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "cell_mask.h"
+
+// ================== Commands ==================
+// Decoded display commands on their way from the producers (BLE callbacks,
+// sequencer, audio task) to the render task. The board only ever shows the
+// newest one, so each producer hands them over through a mailbox.
+#define MAX_SCALE_PAIRS 20
+
+enum CommandType : uint8_t
+{
+  CMD_CLEAR,
+  CMD_CHORD,
+  CMD_SCALE,
+  CMD_SHAPE,
+  CMD_MASK,
+  CMD_TUNER
+};
+
+// A fully decoded display command, ready for the pixel mapping functions
+struct PixelCommand
+{
+  CommandType type;
+  int count;                         // tokens for a chord, pairs for a scale
+  int frets[6];                      // CMD_CHORD: fret per string
+  int scaleData[MAX_SCALE_PAIRS][2]; // CMD_SCALE: string/fret pairs
+  int root;                          // CMD_SHAPE: root pitch class
+  int shapeType;                     // CMD_SHAPE: ShapeType
+  int voicing;                       // CMD_SHAPE chords: index into chordVoicings(), -1 for the shape mask
+  CellMask mask;                     // CMD_MASK: fret cells to light
+  uint32_t color;                    // CMD_MASK: 0xRRGGBB
+  int tunerString;                   // CMD_TUNER: string being tuned
+  int cents;                         // CMD_TUNER: its deviation
+  uint32_t receivedAt;               // micros() when the write arrived, for latency events
+  int sequence;                      // fast-path sequence number, -1 for acknowledged writes
+};
+
+// ================== Command Mailbox ==================
+// Single-slot "latest wins" hand-off between one producer and the render task.
+// Triple-buffered: the producer always has a free slot to write and a put
+// simply replaces whatever has not been taken yet, so it never fails; the
+// replaced commands are counted so the render task can report them.
+struct CommandMailbox
+{
+  PixelCommand slots[3];
+  std::atomic<uint8_t> middle{1};    // slot holding the newest command
+  std::atomic<uint16_t> replaced{0}; // puts over a command not yet taken
+  uint8_t back = 0;                  // producer only
+  uint8_t front = 2;                 // consumer only
+};
+
+void commandMailboxPut(CommandMailbox &mailbox, const PixelCommand &command);
+
+// Take the newest command put since the last take. Returns false if none.
+// `replaced` gets the number of commands overwritten since the last take.
+bool commandMailboxTake(CommandMailbox &mailbox, PixelCommand *command, int *replaced);
+
+#endif // COMMAND_QUEUE_H
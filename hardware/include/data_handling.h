@@ -3,10 +3,17 @@
 
 #include <Arduino.h>
 
-// Function to parse comma-separated string into integer tokens (for chords)
-int parseChordCommand(String value, int *tokens, int maxTokens);
+// Both parsers work directly on the raw characteristic bytes in a single pass,
+// without building any String objects. Input is read up to `length` bytes or
+// the first NUL, whichever comes first. Malformed input (unbalanced or nested
+// brackets, stray characters, missing numbers, negative scale values, more
+// values than fit in the output) is rejected as a whole and the parser
+// returns 0.
 
-// Function to parse nested array string into scale data pairs
-int parseScaleCommand(String value, int scaleData[][2], int maxPairs);
+// Function to parse comma-separated integers such as "[-1, 3, 2, 0, 1, 0]" (for chords)
+int parseChordCommand(const char *value, size_t length, int *tokens, int maxTokens);
+
+// Function to parse nested array string such as "[[5, 5], [5, 7]]" into scale data pairs
+int parseScaleCommand(const char *value, size_t length, int scaleData[][2], int maxPairs);
 
 #endif // DATA_HANDLING_H
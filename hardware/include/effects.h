@@ -0,0 +1,69 @@
+#ifndef EFFECTS_H
+#define EFFECTS_H
+
+#include <Arduino.h>
+#include "ble_protocol.h"
+#include "command_queue.h"
+
+// ================== Effects ==================
+// Animations between and on top of the frames the converters draw. A new
+// command's frame becomes the target; while anything animates, a periodic
+// esp_timer wakes the render task every EFFECT_FRAME_PERIOD_US and the frame
+// is recomposed into backBuffer from the target. All math is 8-bit fixed
+// point (lib8tion), nothing waits, and with every effect idle the timer is
+// stopped and frames are drawn exactly as before.
+//
+// FRAME_OP_EFFECTS payload is [op][args] (little-endian), written to the
+// sequence characteristic:
+//   EFFECT_OP_TRANSITIONS [fade ms: u16][reveal step ms: u16]
+//       cross-fade from the frame on the LEDs to each new one; scales appear
+//       one note per reveal step, in the order sent. 0 turns either off.
+//   EFFECT_OP_PULSE     [period ms: u16]          breathe the lit cells, 0 = off
+//   EFFECT_OP_METRONOME [bpm: u16][beats per bar] start the tempo clock
+//       (tempo_clock.h) and flash the unlit nut-row cells on every beat, the
+//       first of each bar brighter. 0 bpm = off.
+#define EFFECT_OP_TRANSITIONS 0x01
+#define EFFECT_OP_PULSE 0x02
+#define EFFECT_OP_METRONOME 0x03
+
+#define EFFECT_FRAME_PERIOD_US 16667 // 60 frames per second
+#define EFFECT_MAX_FADE_MS 2000
+#define EFFECT_MAX_REVEAL_MS 1000
+#define EFFECT_MIN_PULSE_MS 200
+#define EFFECT_MAX_PULSE_MS 5000
+#define EFFECT_PULSE_FLOOR 64        // pulsed cells never dim below this (of 255)
+#define EFFECT_MIN_BPM 20
+#define EFFECT_MAX_BPM 300
+#define EFFECT_MAX_BEATS_PER_BAR 16
+#define EFFECT_FLASH_MS 120          // metronome flash decay
+#define EFFECT_FLASH_ACCENT CRGB::White
+#define EFFECT_FLASH_BEAT 0x404040   // other beats
+
+// Create the frame timer. Call once from setup() after the render task is started.
+void setupEffects();
+
+// Apply a FRAME_OP_EFFECTS frame (BLE task). Returns 0, or the
+// EVENT_COMMAND_REJECTED reason.
+uint8_t effectsHandleFrame(const FrameView &frame);
+
+// Turn every effect off, e.g. when the app disconnects (any task)
+void resetEffects();
+
+// backBuffer now holds the frame drawn for command, or a blank grid if
+// command is nullptr: make it the target (render task)
+void effectsNewTarget(const PixelCommand *command);
+
+// Recompose backBuffer for this moment; with redraw, also when nothing
+// animates (something drawn over the last frame has to go). Returns true while
+// anything is still animating (render task).
+bool effectsCompose(bool redraw = false);
+
+// The frame just composed has been pushed, frameMicros after compose started.
+// Keeps the frame timer running only while animating (render task).
+void effectsFrameDone(bool animating, uint32_t frameMicros);
+
+// Largest share of the frame period spent composing and pushing an animated
+// frame since the last call, in 1/100 % (event task)
+uint16_t takeEffectsLoadPeak();
+
+#endif // EFFECTS_H
@@ -0,0 +1,89 @@
+#ifndef EVENT_STREAM_H
+#define EVENT_STREAM_H
+
+#include <Arduino.h>
+#include "cell_mask.h"
+
+// ================== Event Stream ==================
+// Board-to-app events, notified on EVENT_CHAR_UUID. Producers only queue a
+// small record and wake the event task, which waits one connection interval
+// for more, packs everything queued into FRAME_OP_EVENTS frames and notifies
+// once per frame. With nothing queued and no client it never wakes.
+//
+// Each event in the frame payload is [type][body]. Body size is fixed per
+// type, multi-byte fields are little-endian:
+//   EVENT_RENDER_COMPLETE  [command type][superseded][latency us: u32]  write -> LEDs lit
+//   EVENT_COMMAND_REJECTED [source][reason]
+//   EVENT_STATS            [free heap: u32][LED pushes per second: u16][events dropped: u16]
+//                          [effects frame load: u16]   peak, 1/100 % of EFFECT_FRAME_PERIOD_US
+//   EVENT_TOUCH            [fret per string: 6][pressed cells]   fingers moved (touch_sensing.h);
+//                          fret is the highest pressed on that string, 0xFF if none
+//   EVENT_SEQUENCE_APPLIED [sequence: u16]   newest fast-path frame now on the LEDs
+//   EVENT_SEQUENCE_STEP    [step: u16]       sequencer started a step (0xFFFF: sequence ended)
+//   EVENT_POWER            [PowerMode][max wake-to-render us: u32][peak LED mA: u16][brightness]
+//                          sent with EVENT_STATS; LED figures from led_power.h
+//   EVENT_CHORD_CHECK      [state][fingers down][fingers in chord][wrong cells][ms since chord shown: u16]
+//                          sensed fingers against the chord on the LEDs (chord_check.h)
+//   EVENT_TUNER            [string][cents: s16][frequency 0.1 Hz: u16][clarity %]
+//                          tuner reading (tuner.h); string 0xFF: the note died away
+//   EVENT_CHORD_MATCH      [score %][pitch classes heard: u16][chord on the LEDs: u16][ms since onset block]
+//                          a strum scored against the chord (chord_listen.h); sent without
+//                          waiting for the batch interval
+//   EVENT_STRUM_TIMING     [beat: u16][part of the beat][error ms: s16]
+//                          a strum against the tempo clock (rhythm.h), negative = early;
+//                          queued a bar at a time. Beat 0 is when the metronome started.
+#define EVENT_RENDER_COMPLETE 0x01
+#define EVENT_COMMAND_REJECTED 0x02
+#define EVENT_STATS 0x03
+#define EVENT_TOUCH 0x04
+#define EVENT_SEQUENCE_APPLIED 0x05
+#define EVENT_SEQUENCE_STEP 0x06
+#define EVENT_POWER 0x07
+#define EVENT_CHORD_CHECK 0x08
+#define EVENT_TUNER 0x09
+#define EVENT_CHORD_MATCH 0x0A
+#define EVENT_STRUM_TIMING 0x0B
+
+// EVENT_COMMAND_REJECTED source: which characteristic the write came in on
+#define EVENT_SOURCE_CHORD 0
+#define EVENT_SOURCE_SCALE 1
+#define EVENT_SOURCE_FAST 2
+#define EVENT_SOURCE_SEQUENCE 3
+
+// EVENT_COMMAND_REJECTED reason
+#define REJECT_MALFORMED 1  // failed to parse or decode
+#define REJECT_QUEUE_FULL 2 // no longer sent: a newer write replaces one not yet drawn
+#define REJECT_NO_ROOM 3    // sequence arena full
+#define REJECT_UNSUPPORTED 4 // feature not built into this firmware
+
+#define EVENT_MAX_BODY 12
+#define EVENT_QUEUE_SIZE 32
+#define EVENT_BATCH_INTERVAL_MS 30 // about one connection interval on phones
+#define EVENT_STATS_INTERVAL_MS 1000
+#define EVENT_DEFAULT_PACKET 20 // ATT_MTU 23 minus the 3-byte notification header
+
+#define EVENT_TASK_CORE 0
+#define EVENT_TASK_PRIORITY 1
+#define EVENT_TASK_STACK 3072
+
+// Create the event queue and task. Call once from setup() before BLE is started.
+void startEventTask();
+
+// A client connected: start the EVENT_STATS reports (supervisor task)
+void eventStreamConnected();
+
+// Largest notification the link carries (negotiated ATT_MTU - 3).
+void setEventPacketLimit(size_t bytes);
+
+// Queue events (any task, never blocks; dropped and counted if the queue is full)
+void eventRenderComplete(uint8_t commandType, int superseded, uint32_t latencyMicros);
+void eventCommandRejected(uint8_t source, uint8_t reason);
+void eventSequenceApplied(uint16_t sequence);
+void eventSequenceStep(uint16_t step);
+void eventTouch(const CellMask &pressed);
+void eventChordCheck(uint8_t state, uint8_t correct, uint8_t fingers, uint8_t wrong, uint16_t elapsedMs);
+void eventTuner(uint8_t string, int16_t cents, uint16_t deciHz, uint8_t clarity);
+void eventChordMatch(uint8_t score, uint16_t heard, uint16_t chord, uint8_t latencyMs);
+void eventStrumTiming(uint16_t beat, uint8_t part, int16_t errorMs);
+
+#endif // EVENT_STREAM_H
@@ -0,0 +1,25 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <stdint.h>
+
+// ================== FFT ==================
+// In-place radix-2 FFT for the audio analyses, in single precision (the
+// ESP32 has a hardware FPU for float, not for double). A real input of
+// FFT_SIZE samples is transformed as FFT_SIZE / 2 complex values (even
+// samples real, odd samples imaginary) and then split into the spectrum of
+// the real signal, so it costs about half a complex transform of the same
+// length. The twiddle table (FFT_SIZE / 2 complex values, 4 KB) is built on
+// first use.
+#define FFT_SIZE 1024
+#define FFT_BINS (FFT_SIZE / 2 + 1) // DC to Nyquist
+
+// Transform FFT_SIZE real samples in place. Packed result: data[0] is the DC
+// bin, data[1] the Nyquist bin (both real), then bin k (1 .. FFT_SIZE/2 - 1)
+// as data[2k] real, data[2k + 1] imaginary.
+void realFft(float *data);
+
+// Squared magnitude of every bin of a realFft() result, FFT_BINS values
+void fftPower(const float *spectrum, float *power);
+
+#endif // FFT_H
@@ -0,0 +1,34 @@
+#ifndef FRAME_BUFFER_H
+#define FRAME_BUFFER_H
+
+#include "main.h"
+#include "cell_mask.h"
+
+// ================== Frame Buffer ==================
+// Frames are composed in backBuffer and published to the strip with a single
+// presentFrame() call. leds[] (the buffer FastLED is bound to) is only ever
+// written by presentFrame(), so the strip never shows a half-drawn frame.
+extern CRGB backBuffer[NUM_LEDS];
+
+// Push counters, updated by presentFrame()
+struct FrameStats
+{
+  uint32_t pushesIssued;  // frames sent to the strip
+  uint32_t pushesSkipped; // frames identical to what was already shown
+  uint32_t refreshes;     // unchanged frames re-sent for temporal dithering
+  CellMask lastDirtyMask; // fret cells (bit = fretLEDs index) changed by the last push
+};
+
+// Diff the back buffer against leds[] cell by cell over the fretLEDs grid,
+// copy the changed cells and push them with exactly one FastLED.show() at the
+// brightness chosen by the power budget (led_power.h). Does nothing if neither
+// a cell nor the brightness changed. Returns true if the strip was updated.
+bool presentFrame();
+
+// Re-send leds[] unchanged, so FastLED's temporal dither advances a phase
+void refreshFrame();
+
+// Snapshot of the push counters
+FrameStats getFrameStats();
+
+#endif // FRAME_BUFFER_H
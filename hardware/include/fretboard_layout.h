@@ -0,0 +1,79 @@
+#ifndef FRETBOARD_LAYOUT_H
+#define FRETBOARD_LAYOUT_H
+
+#include <stdint.h>
+
+// ================== Fretboard Layout ==================
+// Physical LED layout, selected with build flags (see platformio.ini):
+//   FRETBOARD_STRINGS    - strings on the neck
+//   FRETBOARD_FRETS      - fret rows, including the open-string row (fret 0)
+//   FRETBOARD_ROW_WIDTH  - LEDs per fret row; extra LEDs past the last string stay dark
+//   FRETBOARD_SERPENTINE - 1 if every odd row is wired in reverse (zig-zag strip)
+// Default is the 8x8 test grid: 8 rows of 8 LEDs, the first 6 of each row in use.
+#ifndef FRETBOARD_STRINGS
+#define FRETBOARD_STRINGS 6
+#endif
+#ifndef FRETBOARD_FRETS
+#define FRETBOARD_FRETS 8
+#endif
+#ifndef FRETBOARD_ROW_WIDTH
+#define FRETBOARD_ROW_WIDTH 8
+#endif
+#ifndef FRETBOARD_SERPENTINE
+#define FRETBOARD_SERPENTINE 0
+#endif
+
+#define FRETBOARD_NUM_LEDS (FRETBOARD_ROW_WIDTH * FRETBOARD_FRETS)
+#define FRETBOARD_CELLS (FRETBOARD_STRINGS * FRETBOARD_FRETS)
+
+// Maps a fret cell (fret * Strings + string) to its LED index on the strip.
+// The whole table is built by the compiler and lives in flash.
+template <int RowWidth, int Strings, int Frets, bool Serpentine>
+struct FretboardLayout
+{
+  static constexpr int cells = Strings * Frets;
+  static constexpr int ledCount = RowWidth * Frets;
+
+  static_assert(Strings > 0 && Frets > 0, "empty fretboard");
+  static_assert(Strings <= RowWidth, "every string needs an LED in each row");
+  static_assert(ledCount <= 256, "LED indices are stored as uint8_t");
+
+  struct Table
+  {
+    uint8_t led[cells];
+  };
+
+  static constexpr uint8_t ledIndex(int string, int fret)
+  {
+    int column = (Serpentine && (fret % 2 == 1)) ? (RowWidth - 1 - string) : string;
+    return (uint8_t)(fret * RowWidth + column);
+  }
+
+  static constexpr Table makeTable()
+  {
+    Table table = {};
+    for (int fret = 0; fret < Frets; fret++)
+    {
+      for (int string = 0; string < Strings; string++)
+      {
+        table.led[fret * Strings + string] = ledIndex(string, fret);
+      }
+    }
+    return table;
+  }
+};
+
+typedef FretboardLayout<FRETBOARD_ROW_WIDTH, FRETBOARD_STRINGS, FRETBOARD_FRETS, FRETBOARD_SERPENTINE != 0> Fretboard;
+
+inline constexpr Fretboard::Table fretLEDTable = Fretboard::makeTable();
+
+// fretLEDs[fret * FRETBOARD_STRINGS + string] -> LED index
+inline constexpr const uint8_t (&fretLEDs)[FRETBOARD_CELLS] = fretLEDTable.led;
+
+// The default layout must reproduce the original 8x8 grid rule (i % 8 < 6)
+#if FRETBOARD_ROW_WIDTH == 8 && FRETBOARD_STRINGS == 6 && !FRETBOARD_SERPENTINE
+static_assert(fretLEDs[5] == 5 && fretLEDs[6] == 8 && fretLEDs[FRETBOARD_CELLS - 1] == FRETBOARD_NUM_LEDS - 3,
+              "8x8 grid mapping changed");
+#endif
+
+#endif // FRETBOARD_LAYOUT_H
@@ -0,0 +1,77 @@
+#ifndef GUITAR_TUNING_H
+#define GUITAR_TUNING_H
+
+#include <Arduino.h>
+#include "ble_protocol.h"
+#include "command_queue.h"
+#include "fretboard_layout.h"
+
+// ================== Guitar Tuning ==================
+// The tuning and capo the player chose (FRAME_OP_TUNING), and which note
+// every fret cell sounds with them. The app's chord and scale data are fret
+// numbers for standard tuning without a capo, so the render task fits every
+// command to the neck before drawing it (fitCommandToTuning): each note moves
+// to where that pitch is on the same string, and a chord note that ends up
+// behind the capo or off the grid becomes the lowest chord tone left on its
+// string. Chord shapes are drawn as voicings solved for the tuning
+// (chord_voicing.h), scales from masks built for it (shape_index.h).
+// Cells behind the capo stay dark.
+//
+// A new tuning only rebuilds the strings whose open note changed (all of
+// them for a new capo): cellPitchClass, the shape index columns and
+// guitarStrings/openStringMidi (main.h). The render task applies it between
+// frames and redraws what it was showing, so the app sends nothing else.
+//
+// FRAME_OP_TUNING payload: [TuningPreset][capo], or
+// [TUNING_CUSTOM][capo][6 open-string MIDI notes, low string first].
+#define TUNING_MAX_CAPO 7
+#define TUNING_MIN_MIDI 28 // E1
+#define TUNING_MAX_MIDI 76 // E5
+#define TUNING_CUSTOM 0xFF
+#define CELL_BEHIND_CAPO 0xFF
+
+enum TuningPreset : uint8_t
+{
+  TUNING_STANDARD,       // E2 A2 D3 G3 B3 E4
+  TUNING_DROP_D,         // D2 A2 D3 G3 B3 E4
+  TUNING_DADGAD,         // D2 A2 D3 G3 A3 D4
+  TUNING_HALF_STEP_DOWN, // Eb2 Ab2 Db3 Gb3 Bb3 Eb4
+  TUNING_PRESET_COUNT
+};
+
+// Open-string MIDI notes of each preset, low string first
+inline constexpr uint8_t tuningPresetMidi[TUNING_PRESET_COUNT][6] = {
+    {40, 45, 50, 55, 59, 64},
+    {38, 45, 50, 55, 59, 64},
+    {38, 45, 50, 55, 57, 62},
+    {39, 44, 49, 54, 58, 63},
+};
+
+// Pitch class of every fret cell (fret * FRETBOARD_STRINGS + string), or
+// CELL_BEHIND_CAPO. Render task.
+extern uint8_t cellPitchClass[FRETBOARD_CELLS];
+
+// Build the tables for standard tuning. Call once from setup().
+void setupGuitarTuning();
+
+// Accept a FRAME_OP_TUNING frame (BLE task); the render task applies it.
+// Returns 0, or the EVENT_COMMAND_REJECTED reason.
+uint8_t tuningHandleFrame(const FrameView &frame);
+
+// Apply a tuning accepted since the last call (render task). Returns true if
+// the tables changed and the grid needs redrawing.
+bool applyPendingTuning();
+
+// Rebuild every table for open strings openMidi (6 MIDI notes) and a capo.
+// Returns false if nothing changed.
+bool retuneFretboard(const uint8_t *openMidi, int capo);
+
+// Capo fret, 0 for none (render task)
+int tuningCapo();
+
+// Move the frets of a CMD_CHORD or CMD_SCALE from standard tuning without a
+// capo onto the current neck, and give a chord CMD_SHAPE the frets of its
+// voicing (chord_voicing.h); other commands are left as they are (render task)
+void fitCommandToTuning(PixelCommand &command);
+
+#endif // GUITAR_TUNING_H
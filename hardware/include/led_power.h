@@ -0,0 +1,70 @@
+#ifndef LED_POWER_H
+#define LED_POWER_H
+
+#include "main.h"
+
+// ================== LED Power Budget ==================
+// Every push is estimated from the composed frame and its brightness is
+// lowered if needed so the strip stays within LED_POWER_BUDGET_MA. The model
+// is the usual WS2812B one (as FastLED's power_mgt): each channel draws in
+// proportion to its brightness-scaled value, and every LED draws a small
+// quiescent current whether lit or not. Larger necks (env:esp32dev_fullneck)
+// keep the same budget and simply run dimmer when many cells are lit.
+#ifndef LED_POWER_BUDGET_MA
+#define LED_POWER_BUDGET_MA 400 // USB 2.0 port (500 mA) less the ESP32 and radio
+#endif
+#define LED_MA_RED 16 // per channel at full drive
+#define LED_MA_GREEN 11
+#define LED_MA_BLUE 15
+#define LED_MA_QUIESCENT 1 // per LED, lit or not
+
+// ================== Brightness ==================
+#ifndef LED_BRIGHTNESS_ACTIVE
+#define LED_BRIGHTNESS_ACTIVE 20 // before the budget is applied
+#endif
+#define LED_BRIGHTNESS_IDLE 6    // after LED_IDLE_AFTER_MS without a new command
+#ifndef LED_IDLE_AFTER_MS
+#define LED_IDLE_AFTER_MS 60000
+#endif
+
+// When the budget pulls the active level below LED_DITHER_BELOW, FastLED's
+// temporal dithering is switched on and the render task re-sends the frame
+// every LED_DITHER_PERIOD_MS so the dither averages out instead of freezing on
+// one phase. Set it to 0 to never refresh (no wake-ups while dimmed, at the
+// cost of coarser colours). The idle level is always shown undithered, so an
+// idle board does not wake at all until the next command.
+#ifndef LED_DITHER_BELOW
+#define LED_DITHER_BELOW 16
+#endif
+#define LED_DITHER_PERIOD_MS 10
+
+#define LED_POWER_NO_DEADLINE 0xFFFFFFFFu
+
+// Estimated strip current in mA for a frame shown at the given brightness
+uint32_t estimateStripCurrent(const CRGB *strip, uint8_t brightness);
+
+// Highest brightness up to target at which the frame fits within budgetMa
+uint8_t fitBrightness(const CRGB *strip, uint8_t target, uint32_t budgetMa);
+
+// A new command was drawn: back to full brightness, restart the idle timer (render task)
+void ledPowerActivity();
+
+// Brightness for pushing this frame: the active or idle level, fitted to the
+// budget. Records the estimate for the power report (render task).
+uint8_t ledPowerBrightness(const CRGB *strip);
+
+// The frame last pushed is active and dim enough to be dithered, so it needs
+// refreshing
+bool ledPowerDithering();
+
+// Milliseconds until the render task must run again (idle dimming or a dither
+// refresh), or LED_POWER_NO_DEADLINE
+uint32_t ledPowerWaitMs();
+
+// Highest estimated strip current since the last call, in mA (event task)
+uint16_t takeLedCurrentPeak();
+
+// Brightness of the last push
+uint8_t getLedBrightness();
+
+#endif // LED_POWER_H
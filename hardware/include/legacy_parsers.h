@@ -0,0 +1,19 @@
+#ifndef LEGACY_PARSERS_H
+#define LEGACY_PARSERS_H
+
+#include <Arduino.h>
+
+// ================== Legacy String Parsers ==================
+// The original String-based chord and scale parsers, unchanged apart from their
+// names and one signed comparison. The benchmarks time the path that the
+// binary frames (ble_protocol.h) and the tokenizer (data_handling.h) replaced,
+// and the host tests (test/test_parsers) check the tokenizer gives the same
+// values. Source in bench/legacy_parsers.cpp; the firmware never calls them.
+
+// "[-1, 3, 2, 0, 1, 0]" into integer tokens; returns the token count
+int legacyParseChordCommand(String value, int *tokens, int maxTokens);
+
+// "[[5, 5], [5, 7]]" into string/fret pairs; returns the pair count
+int legacyParseScaleCommand(String value, int scaleData[][2], int maxPairs);
+
+#endif // LEGACY_PARSERS_H
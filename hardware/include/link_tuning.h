@@ -0,0 +1,61 @@
+#ifndef LINK_TUNING_H
+#define LINK_TUNING_H
+
+#include <BLEDevice.h>
+
+// ================== Link Tuning ==================
+// Asks for a large ATT MTU, the LE 2M PHY on chips that have it, and switches
+// the connection interval between a short "active" setting while commands are
+// arriving and a long "idle" one after LINK_IDLE_AFTER_MS without any.
+// The central has the final say; what it granted is published on
+// LINK_CHAR_UUID (see bluetooth.h) as a FRAME_OP_LINK frame:
+//   [mtu: u16][interval: u16, 1.25 ms units][latency: u16][timeout: u16, 10 ms units]
+//   [tx phy][rx phy][mode: 0 idle, 1 active]   (little-endian; phy 1 = 1M, 2 = 2M)
+#define LINK_MTU 247 // fits a 244-byte notification, the LE data length maximum
+
+// Connection parameters within Apple's accessory guidelines
+#define LINK_ACTIVE_MIN_INTERVAL 12 // 15 ms
+#define LINK_ACTIVE_MAX_INTERVAL 24 // 30 ms
+#define LINK_ACTIVE_LATENCY 0
+#define LINK_ACTIVE_TIMEOUT 400     // 4 s
+#define LINK_IDLE_MIN_INTERVAL 320  // 400 ms
+#define LINK_IDLE_MAX_INTERVAL 400  // 500 ms
+#define LINK_IDLE_LATENCY 2
+#define LINK_IDLE_TIMEOUT 600       // 6 s
+#define LINK_IDLE_AFTER_MS 10000
+#define LINK_NO_DEADLINE 0xFFFFFFFFu // updateLinkMode(): nothing to wait for
+
+#define LINK_PHY_1M 1
+#define LINK_PHY_2M 2
+#define LINK_PARAMS_PAYLOAD 11
+
+// What was last granted on the current connection
+struct LinkParams
+{
+  uint16_t mtu;
+  uint16_t interval;
+  uint16_t latency;
+  uint16_t timeout;
+  uint8_t txPhy;
+  uint8_t rxPhy;
+  bool active;
+};
+
+// Set the local MTU and hook GAP events. Call after BLEDevice::init().
+void setupLinkTuning();
+
+// Connection callbacks (BLE task)
+void linkConnected(const esp_bd_addr_t address);
+void linkDisconnected();
+void linkMtuChanged(uint16_t mtu);
+
+// A display command arrived: switch to the active interval if idle (BLE task)
+void linkNoteActivity();
+
+// Fall back to the idle interval once commands stop (supervisor task).
+// Returns the milliseconds until it should run again, or LINK_NO_DEADLINE.
+uint32_t updateLinkMode();
+
+LinkParams getLinkParams();
+
+#endif // LINK_TUNING_H
@@ -3,21 +3,29 @@
 
 #include <Arduino.h>
 #include <FastLED.h>
+#include "fretboard_layout.h"
 
 // ================== LED Setup ==================
 #define DATA_PIN 14
-#define NUM_LEDS 64 // 8x8 grid
-#define VALID_LEDS 48
+#define NUM_LEDS FRETBOARD_NUM_LEDS // 64 on the 8x8 grid
+#define VALID_LEDS FRETBOARD_CELLS  // 48 on the 8x8 grid
+#define NUM_STRINGS FRETBOARD_STRINGS
 #define MAX_PIXELS 6
 #define BL_CONNECTED_PIN 2 // GPIO pin for Bluetooth connection status
+#ifdef GUITARPAL_TOUCH
+#define BL_DISCONNECTED_PIN 25 // GPIO4 is touch pad T0 on boards with the touch matrix
+#else
 #define BL_DISCONNECTED_PIN 4 // GPIO pin for Bluetooth disconnection status
+#endif
 
-extern CRGB leds[NUM_LEDS];
-extern int fretLEDs[VALID_LEDS];
-extern int guitarStrings[6];
+// Chord frames and the tuning table carry one value per string
+static_assert(NUM_STRINGS == 6, "chord protocol assumes a 6-string neck");
+
+extern CRGB leds[NUM_LEDS]; // what is on the strip; compose into backBuffer instead
+extern int guitarStrings[6];   // open strings of the current tuning (guitar_tuning.h)
+extern int openStringMidi[6];
 
 // ================== Function Declarations ==================
-void setGridPixeltoFrets();
 void setGridColor(int* sequence, int count, CRGB color);
 void clearGrid();
 
@@ -0,0 +1,43 @@
+#ifndef ONSET_DETECT_H
+#define ONSET_DETECT_H
+
+#include <stdint.h>
+#include "audio_input.h"
+
+// ================== Onset Detection ==================
+// Strum and pick attacks from the energy envelope. The signal is
+// pre-emphasised (first difference) so the broadband attack stands out from
+// the low strings still ringing, and its energy summed over ONSET_HOP-sample
+// hops. A hop ONSET_RATIO times above the background (a slow average of past
+// hops) starts an onset. The onset is then placed on the first sample in
+// that hop whose own energy is that far above the background, so timestamps
+// are finer than the hop. After an onset, ONSET_REFRACTORY_US must pass
+// before the next one, so a string buzzing or a slow strum counts once.
+//
+// Timestamps are on the esp_timer clock: the caller says when the block's
+// first sample was taken (audioBlockStartUs()).
+#define ONSET_HOP 32                // 2 ms
+#define ONSET_RATIO 8               // +9 dB over the background
+#define ONSET_MIN_RMS 16            // pre-emphasised; quieter hops never start an onset
+#define ONSET_BACKGROUND_SHIFT 4    // background follows each hop with weight 1/16 (32 ms)
+#define ONSET_REFRACTORY_US 60000
+#define ONSET_MAX_PER_BLOCK 2
+
+static_assert(AUDIO_BLOCK_SAMPLES % ONSET_HOP == 0, "a block is a whole number of hops");
+
+struct OnsetDetector
+{
+  int16_t previous;      // last sample of the previous block, for the first difference
+  uint32_t background;   // hop energy
+  int64_t lastOnsetUs;
+  bool primed;           // background initialised
+};
+
+void onsetDetectorReset(OnsetDetector &detector);
+
+// Feed one AUDIO_BLOCK_SAMPLES block whose first sample was taken at
+// blockStartUs. Writes the time of each onset found to onsetsUs and returns
+// how many (at most ONSET_MAX_PER_BLOCK). Pure computation.
+int detectOnsets(OnsetDetector &detector, const int16_t *block, int64_t blockStartUs, int64_t *onsetsUs);
+
+#endif // ONSET_DETECT_H
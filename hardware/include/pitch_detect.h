@@ -0,0 +1,38 @@
+#ifndef PITCH_DETECT_H
+#define PITCH_DETECT_H
+
+#include <stdint.h>
+#include "audio_input.h"
+
+// ================== Pitch Detection ==================
+// YIN (de Cheveigne and Kawahara, 2002) in integer arithmetic, for one
+// monophonic note. For every lag the squared difference between the window and
+// itself shifted by that lag is summed, then divided by its running mean over
+// the smaller lags (Q15). The period is the first dip below
+// PITCH_THRESHOLD_Q15, followed down to its minimum and refined to 1/256
+// sample with a parabola through its neighbours. Lags are only computed up to
+// just past the dip, so higher notes cost less.
+//
+// Samples are 12-bit signed (audio_input.h); each difference is halved so a
+// lag's sum stays within 32 bits: 256 x (2 x 2048 / 2)^2 = 2^30.
+#define PITCH_WINDOW 256
+#define PITCH_MIN_LAG 20  // 800 Hz, the high E string's 15th fret
+#define PITCH_MAX_LAG 256 // 62.5 Hz, below drop-D's low D (73.4 Hz)
+#define PITCH_FRAME_SAMPLES (PITCH_WINDOW + PITCH_MAX_LAG) // two blocks
+#define PITCH_THRESHOLD_Q15 4915                           // 0.15
+#define PITCH_MIN_RMS 32 // quieter frames (about -36 dBFS) are not voiced
+
+struct PitchEstimate
+{
+  bool voiced;
+  uint32_t periodQ8;     // samples x 256
+  uint16_t aperiodicity; // normalised difference at the period, Q15: 0 = pure tone
+};
+
+// Estimate the pitch of PITCH_FRAME_SAMPLES samples. Returns estimate->voiced.
+bool estimatePitch(const int16_t *frame, PitchEstimate *estimate);
+
+// Frequency of a period in 1/100 Hz at AUDIO_SAMPLE_RATE
+uint32_t pitchCentiHz(uint32_t periodQ8);
+
+#endif // PITCH_DETECT_H
@@ -1,10 +1,22 @@
 #ifndef PIXEL_MAPPING_H
 #define PIXEL_MAPPING_H
 
+#include <stdint.h>
+#include "cell_mask.h"
+
 // Function to convert chord string positions to LED pixel positions
 void convertChordPositionsToPixels(int *stringPositions, int *pixels);
 
 // Function to convert scale positions to LED pixel positions
 void convertScalePositionsToPixels(int scaleData[][2], int scaleCount);
 
+// Function to light a precomputed (root, shape type) mask from the shape index
+void convertShapeToPixels(int root, int type);
+
+// Function to light every cell of a mask in one colour (0xRRGGBB)
+void convertMaskToPixels(const CellMask &mask, uint32_t color);
+
+// Function to draw the tuner needle for one string (tuner.h)
+void convertTunerToPixels(int string, int cents);
+
 #endif // PIXEL_MAPPING_H
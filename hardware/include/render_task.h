@@ -0,0 +1,42 @@
+#ifndef RENDER_TASK_H
+#define RENDER_TASK_H
+
+#include "command_queue.h"
+
+// ================== Render Task ==================
+// All LED work runs on a dedicated task pinned to the application core, so the
+// BLE stack (on the protocol core) never waits on parsing output or FastLED.
+#define RENDER_TASK_CORE 1
+#define RENDER_TASK_PRIORITY 2
+#define RENDER_TASK_STACK 4096
+
+// Create the render task. Call once from setup() before BLE is started.
+void startRenderTask();
+
+// Hand a decoded command to the render task and wake it (BLE callbacks only).
+// Never fails: the newest write wins, replacing one not yet drawn.
+void submitCommand(const PixelCommand &command);
+
+// Fast path: replace any not-yet-drawn fast command and wake the render task.
+// Never fails; of several quick writes only the newest is drawn.
+void submitLatestCommand(const PixelCommand &command);
+
+// Sequencer: same as submitLatestCommand, from the sequencer's timer callback.
+void submitSequenceStep(const PixelCommand &command);
+
+// Audio modes: same as submitLatestCommand, from the audio task.
+void submitAudioCommand(const PixelCommand &command);
+
+// Ask the render task to blank the grid (any task). Ordered with the commands
+// by arrival: a command submitted after the request is drawn, one before it
+// is dropped.
+void requestClear();
+
+// Wake the render task to compose an effects frame (frame timer, settings changes).
+void requestFrame();
+
+// Longest wait from a command arriving to the render task starting on it
+// since the last call, in microseconds; includes waking the CPU from sleep.
+uint32_t takeWakeLatencyMax();
+
+#endif // RENDER_TASK_H
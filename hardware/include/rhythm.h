@@ -0,0 +1,39 @@
+#ifndef RHYTHM_H
+#define RHYTHM_H
+
+#include <Arduino.h>
+#include "onset_detect.h"
+#include "tempo_clock.h"
+
+// ================== Rhythm ==================
+// AUDIO_MODE_RHYTHM: the timing of every strum against the tempo clock.
+// Each onset is placed on the nearest point of the metronome's grid divided
+// into the strums per beat the app asked for (FRAME_OP_AUDIO argument), and
+// its error kept until the bar is over. The whole bar is then queued as
+// EVENT_STRUM_TIMING events at once, which the event task packs into one
+// notification. Without the metronome running there is no grid and strums
+// are not reported.
+#define RHYTHM_MAX_SUBDIVISIONS 4 // sixteenths
+#define RHYTHM_MAX_PENDING 16     // a 4/4 bar of sixteenths
+
+struct StrumTiming
+{
+  int64_t point;  // grid index: beat x subdivisions + part
+  int32_t errorUs; // negative = early
+};
+
+// Place an onset on the grid. Pure computation.
+StrumTiming rhythmScore(const TempoGrid &grid, int subdivisions, int64_t onsetUs);
+
+// Strums per beat for the next strums, 1 .. RHYTHM_MAX_SUBDIVISIONS (BLE
+// task). Returns false if out of range.
+bool rhythmSetSubdivisions(uint8_t subdivisions);
+
+// Rhythm mode entered (audio task)
+void resetRhythm();
+
+// Detect and score the strums in a block whose first sample was taken at
+// blockStartUs, and send the bars that are over (audio task)
+void rhythmProcessBlock(const int16_t *block, int64_t blockStartUs);
+
+#endif // RHYTHM_H
@@ -4,24 +4,175 @@
 #include <Arduino.h>
 
 // Constants
-#define MAX_SCALE_NOTES 8
-#define MAX_CHORD_NOTES 4
-#define MAX_SCALE_TYPES 4
+#define MAX_SCALE_NOTES 13 // up to 12 pitch classes plus the octave root
+#define MAX_CHORD_NOTES 6
 
 // Note names array
 extern const char* noteNames[12];
 
-// Scale structures
-struct ScalePattern {
-  const char* name;
-  int intervals[MAX_SCALE_NOTES];
-  int length;
+// ================== Pitch-Class Sets ==================
+// A scale or chord is a 12-bit set: bit n is set if the note n semitones above
+// the root belongs to it. Transposing is a rotation, membership is an AND.
+typedef uint16_t PitchClassSet;
+#define PITCH_CLASS_ALL 0x0FFF
+
+// Set of semitones above the root, e.g. pitchSet(0, 4, 7) is a major triad
+template <typename... Notes>
+constexpr PitchClassSet pitchSet(Notes... notes) {
+    return (PitchClassSet)(((1u << notes) | ... | 0u));
+}
+
+// Rotate a set up by `semitones`, e.g. intervals -> absolute pitch classes for a root
+constexpr PitchClassSet rotatePitchSet(PitchClassSet set, int semitones) {
+    int shift = ((semitones % 12) + 12) % 12;
+    return (PitchClassSet)(((set << shift) | (set >> (12 - shift))) & PITCH_CLASS_ALL);
+}
+
+constexpr bool pitchSetHas(PitchClassSet set, int pitchClass) {
+    return (set >> pitchClass) & 1;
+}
+
+constexpr int pitchSetSize(PitchClassSet set) {
+    int count = 0;
+    for (; set != 0; set &= set - 1) count++;
+    return count;
+}
+
+// Mode `degree` (0-based) of a parent scale: rotate so that degree becomes the root
+constexpr PitchClassSet modeOf(PitchClassSet parent, int degree) {
+    int offset = 0;
+    for (int found = -1; offset < 12; offset++) {
+        if (pitchSetHas(parent, offset) && ++found == degree) break;
+    }
+    return rotatePitchSet(parent, 12 - offset);
+}
+
+// Named pattern of intervals above the root
+struct PitchPattern {
+    const char* name;
+    PitchClassSet intervals;
+};
+
+// Scale IDs. The first four keep the order of the original scales[] table.
+enum ScaleId : uint8_t {
+    SCALE_MAJOR,
+    SCALE_MINOR,
+    SCALE_DIMINISHED_WH,
+    SCALE_DIMINISHED_HW,
+    SCALE_DORIAN,
+    SCALE_PHRYGIAN,
+    SCALE_LYDIAN,
+    SCALE_MIXOLYDIAN,
+    SCALE_LOCRIAN,
+    SCALE_MAJOR_PENTATONIC,
+    SCALE_MINOR_PENTATONIC,
+    SCALE_BLUES,
+    SCALE_HARMONIC_MINOR,
+    SCALE_MELODIC_MINOR,
+    SCALE_PHRYGIAN_DOMINANT,
+    SCALE_LYDIAN_DOMINANT,
+    SCALE_ALTERED,
+    SCALE_WHOLE_TONE,
+    SCALE_CHROMATIC,
+    SCALE_TYPE_COUNT
+};
+
+// Chord IDs
+enum ChordId : uint8_t {
+    CHORD_MAJOR,
+    CHORD_MINOR,
+    CHORD_DIMINISHED,
+    CHORD_AUGMENTED,
+    CHORD_SUS2,
+    CHORD_SUS4,
+    CHORD_POWER,
+    CHORD_SIXTH,
+    CHORD_MINOR_SIXTH,
+    CHORD_DOMINANT_7,
+    CHORD_MAJOR_7,
+    CHORD_MINOR_7,
+    CHORD_MINOR_MAJOR_7,
+    CHORD_HALF_DIMINISHED_7,
+    CHORD_DIMINISHED_7,
+    CHORD_7_SUS4,
+    CHORD_ADD9,
+    CHORD_MINOR_ADD9,
+    CHORD_DOMINANT_9,
+    CHORD_MAJOR_9,
+    CHORD_MINOR_9,
+    CHORD_TYPE_COUNT
 };
 
-extern ScalePattern scales[MAX_SCALE_TYPES];
+#define MAJOR_SCALE_SET pitchSet(0, 2, 4, 5, 7, 9, 11)
+#define MELODIC_MINOR_SET pitchSet(0, 2, 3, 5, 7, 9, 11)
+#define HARMONIC_MINOR_SET pitchSet(0, 2, 3, 5, 7, 8, 11)
+
+inline constexpr PitchPattern scaleCatalogue[SCALE_TYPE_COUNT] = {
+    {"Major", MAJOR_SCALE_SET},
+    {"Minor", modeOf(MAJOR_SCALE_SET, 5)},
+    {"Diminished Whole-Half", pitchSet(0, 2, 3, 5, 6, 8, 9, 11)},
+    {"Diminished Half-Whole", pitchSet(0, 1, 3, 4, 6, 7, 9, 10)},
+    {"Dorian", modeOf(MAJOR_SCALE_SET, 1)},
+    {"Phrygian", modeOf(MAJOR_SCALE_SET, 2)},
+    {"Lydian", modeOf(MAJOR_SCALE_SET, 3)},
+    {"Mixolydian", modeOf(MAJOR_SCALE_SET, 4)},
+    {"Locrian", modeOf(MAJOR_SCALE_SET, 6)},
+    {"Major Pentatonic", pitchSet(0, 2, 4, 7, 9)},
+    {"Minor Pentatonic", pitchSet(0, 3, 5, 7, 10)},
+    {"Blues", pitchSet(0, 3, 5, 6, 7, 10)},
+    {"Harmonic Minor", HARMONIC_MINOR_SET},
+    {"Melodic Minor", MELODIC_MINOR_SET},
+    {"Phrygian Dominant", modeOf(HARMONIC_MINOR_SET, 4)},
+    {"Lydian Dominant", modeOf(MELODIC_MINOR_SET, 3)},
+    {"Altered", modeOf(MELODIC_MINOR_SET, 6)},
+    {"Whole Tone", pitchSet(0, 2, 4, 6, 8, 10)},
+    {"Chromatic", PITCH_CLASS_ALL},
+};
+
+inline constexpr PitchPattern chordCatalogue[CHORD_TYPE_COUNT] = {
+    {"Major", pitchSet(0, 4, 7)},
+    {"Minor", pitchSet(0, 3, 7)},
+    {"Diminished", pitchSet(0, 3, 6)},
+    {"Augmented", pitchSet(0, 4, 8)},
+    {"Sus2", pitchSet(0, 2, 7)},
+    {"Sus4", pitchSet(0, 5, 7)},
+    {"5", pitchSet(0, 7)},
+    {"6", pitchSet(0, 4, 7, 9)},
+    {"Minor 6", pitchSet(0, 3, 7, 9)},
+    {"7", pitchSet(0, 4, 7, 10)},
+    {"Major 7", pitchSet(0, 4, 7, 11)},
+    {"Minor 7", pitchSet(0, 3, 7, 10)},
+    {"Minor Major 7", pitchSet(0, 3, 7, 11)},
+    {"Half-Diminished 7", pitchSet(0, 3, 6, 10)},
+    {"Diminished 7", pitchSet(0, 3, 6, 9)},
+    {"7 Sus4", pitchSet(0, 5, 7, 10)},
+    {"Add9", pitchSet(0, 2, 4, 7)},
+    {"Minor Add9", pitchSet(0, 2, 3, 7)},
+    {"9", pitchSet(0, 2, 4, 7, 10)},
+    {"Major 9", pitchSet(0, 2, 4, 7, 11)},
+    {"Minor 9", pitchSet(0, 2, 3, 7, 10)},
+};
+
+// Sanity checks on the rotation maths
+static_assert(scaleCatalogue[SCALE_MINOR].intervals == pitchSet(0, 2, 3, 5, 7, 8, 10), "Aeolian mode");
+static_assert(scaleCatalogue[SCALE_ALTERED].intervals == pitchSet(0, 1, 3, 4, 6, 8, 10), "Altered mode");
+static_assert(rotatePitchSet(pitchSet(0, 4, 7), 9) == pitchSet(1, 4, 9), "A major = A C# E");
+
+// Absolute pitch classes of a scale/chord on `root` (0 = C). 0 for unknown IDs.
+PitchClassSet scalePitchSet(int root, int scaleId);
+PitchClassSet chordPitchSet(int root, int chordId);
+
+// Look a catalogue entry up by name. Returns -1 if not found.
+int findScaleIndex(const char* scaleName);
+int findChordIndex(const char* chordType);
+
+// Write the notes of a scale/chord in ascending order from the root.
+// Scales end with the octave root (e.g. C D E F G A B C), chords do not.
+int generateScaleById(int root, int scaleId, int* output);
+int generateChordById(int root, int chordId, int* output);
 
-// Function declarations
+// Name-based wrappers kept for existing callers
 int generateScale(int root, const char* scaleName, int* output);
 int generateChord(int root, const char* chordType, int* output);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,65 @@
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include <Arduino.h>
+#include "ble_protocol.h"
+#include "fretboard_layout.h"
+
+// ================== Sequencer ==================
+// Plays a whole progression or exercise uploaded in one go, so rhythm practice
+// does not depend on BLE latency or the phone's scheduler. Steps are stored
+// back to back in a fixed RAM arena and advanced from a one-shot esp_timer
+// armed for each step's deadline, so the timer task only wakes when a step
+// starts; each step is handed to the render task like any other command.
+//
+// FRAME_OP_SEQUENCE payload is [op][args] (little-endian):
+//   SEQ_OP_BEGIN [bpm: u16][loop]   stop and empty the arena
+//   SEQ_OP_STEPS [step]...           append steps (the whole frame or none)
+//   SEQ_OP_PLAY                      start from the first step, or resume
+//   SEQ_OP_PAUSE                     hold the current step and its remaining time
+//   SEQ_OP_STOP                      stop and blank the grid
+//   SEQ_OP_TEMPO [bpm: u16]          takes effect immediately, rescales the current step
+//   SEQ_OP_LOOP  [loop]              0 = play once, 1 = repeat
+//
+// Step record: [kind][duration ticks: u16][body length][body], kind is a
+// CommandType:
+//   CMD_CLEAR  no body (rest)
+//   CMD_CHORD  3 bytes, as a chord frame payload
+//   CMD_SCALE  one byte per string/fret pair, as a scale frame payload
+//   CMD_SHAPE  [root][shape type] or [root][chord type][voicing], as a shape frame payload
+//   CMD_MASK   [r][g][b] then SEQUENCE_MASK_BYTES of cell bits, cell 0 in bit 0
+#define SEQ_OP_BEGIN 0x01
+#define SEQ_OP_STEPS 0x02
+#define SEQ_OP_PLAY 0x03
+#define SEQ_OP_PAUSE 0x04
+#define SEQ_OP_STOP 0x05
+#define SEQ_OP_TEMPO 0x06
+#define SEQ_OP_LOOP 0x07
+
+#define SEQUENCE_ARENA_SIZE 2048
+#define SEQUENCE_STEP_HEADER 4
+#define SEQUENCE_MASK_BYTES ((FRETBOARD_CELLS + 7) / 8)
+#define SEQUENCE_TICKS_PER_BEAT 24 // so triplets and sixteenths are both whole ticks
+#define SEQUENCE_MIN_BPM 20
+#define SEQUENCE_MAX_BPM 300
+#define SEQUENCE_DEFAULT_BPM 90
+#define SEQUENCE_ENDED 0xFFFF // EVENT_SEQUENCE_STEP value after the last step
+
+enum SequenceState : uint8_t
+{
+  SEQUENCE_STOPPED,
+  SEQUENCE_PLAYING,
+  SEQUENCE_PAUSED
+};
+
+// Create the step timer. Call once from setup() after the render task is started.
+void setupSequencer();
+
+// Stop playback, leaving the uploaded steps in place (any task)
+void stopSequence();
+
+// Apply one FRAME_OP_SEQUENCE frame (BLE task). Returns 0, or the
+// REJECT_* reason (event_stream.h) if the frame was refused.
+uint8_t sequencerHandleFrame(const FrameView &frame);
+
+#endif // SEQUENCER_H
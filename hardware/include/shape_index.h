@@ -0,0 +1,36 @@
+#ifndef SHAPE_INDEX_H
+#define SHAPE_INDEX_H
+
+#include <stdint.h>
+#include "cell_mask.h"
+#include "scale_and_chord_notes.h"
+
+// ================== Shape Index ==================
+// Every root x shape type as a fret-cell mask for the current tuning and
+// capo (guitar_tuning.h), so lighting a shape is one table lookup and one
+// mask blit. The app can select a shape with a 2-byte (root, type) ID instead
+// of sending positions.
+//
+// Shape type byte: a ScaleId, or SHAPE_CHORD_FLAG | ChordId for chords.
+// Scales light every cell on the neck whose note is in the scale.
+// Chords light the lowest matching fret on each string (as pixelCalculator does);
+// the render task only draws that for a chord with no voicing (chord_voicing.h).
+// Nothing is lit behind the capo.
+#define SHAPE_CHORD_FLAG 0x80
+#define SHAPE_COUNT (SCALE_TYPE_COUNT + CHORD_TYPE_COUNT)
+
+// Cell mask for a (root, type) pair. Returns nullptr for unknown IDs.
+const CellMask *getShapeMask(int root, int type);
+
+// Rebuild the masks on the strings in `strings` (bit n = string n) for
+// open-string pitch classes openPitch and a capo (render task)
+void retuneShapeIndex(const uint8_t *openPitch, int capo, uint32_t strings);
+
+// True if the shape type byte selects a chord rather than a scale
+bool isChordShape(int type);
+
+// True for a known (root, type) ID with a voicing index a shape frame may
+// carry: 0 for scales, below VOICING_MAX_RESULTS for chords
+bool isShapeId(int root, int type, int voicing);
+
+#endif // SHAPE_INDEX_H
@@ -0,0 +1,67 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <Arduino.h>
+
+// ================== Supervisor ==================
+// Connection changes are signalled by the BLE callbacks and handled here
+// instead of being polled from loop(): advertising restarts, the grid is
+// blanked, the status LEDs follow and the link drops to its idle interval on
+// time. Between events every task is blocked, so with power management
+// enabled the CPU scales down and enters automatic light sleep.
+#define SUPERVISOR_TASK_CORE 0
+#define SUPERVISOR_TASK_PRIORITY 1
+#define SUPERVISOR_TASK_STACK 3072
+#define SUPERVISOR_QUEUE_SIZE 8
+
+#define STATUS_TASK_CORE 0
+#define STATUS_TASK_PRIORITY 1
+#define STATUS_TASK_STACK 1536
+
+// ================== Power Management ==================
+// Needs CONFIG_PM_ENABLE in the SDK build; light sleep also needs
+// CONFIG_FREERTOS_USE_TICKLESS_IDLE, and the BLE controller keeps the chip
+// awake unless modem sleep is configured. The Arduino core's prebuilt SDK
+// ships with both off, so the esp32dev environments run at a fixed clock
+// and report POWER_MODE_UNAVAILABLE (trace and EVENT_POWER); scaling and
+// sleep need an SDK built with them on (framework = arduino, espidf with an
+// sdkconfig). Build with -DGUITARPAL_NO_SLEEP to measure idle current with
+// power management off for comparison.
+#define POWER_MAX_FREQ_MHZ 240
+#define POWER_MIN_FREQ_MHZ 80 // keeps APB at 80 MHz for the BLE controller
+
+enum PowerMode : uint8_t
+{
+  POWER_MODE_NONE,        // fixed CPU clock (GUITARPAL_NO_SLEEP)
+  POWER_MODE_DFS,         // frequency scaling only
+  POWER_MODE_LIGHT_SLEEP, // frequency scaling and automatic light sleep
+  POWER_MODE_UNAVAILABLE  // fixed CPU clock: no CONFIG_PM_ENABLE in the SDK, or it failed to configure
+};
+
+enum SystemEvent : uint8_t
+{
+  SYSTEM_CONNECTED,
+  SYSTEM_DISCONNECTED,
+  SYSTEM_LINK_ACTIVE // the link left its idle interval; re-arm the idle timeout
+};
+
+// Configure power management and start the supervisor and status-LED tasks.
+// Call once from setup() before BLE is started.
+void startSupervisor();
+
+// Signal a state change (any task, never blocks)
+void postSystemEvent(SystemEvent event);
+
+PowerMode getPowerMode();
+
+// Hold the APB clock at full speed while the strip is driven; the RMT
+// peripheral that generates the LED waveform is clocked from it (render task)
+void ledPushBegin();
+void ledPushEnd();
+
+// Hold the CPU at full speed, and out of light sleep, while audio is captured
+// and analysed block by block (audio task)
+void audioCaptureBegin();
+void audioCaptureEnd();
+
+#endif // SUPERVISOR_H
@@ -0,0 +1,37 @@
+#ifndef TEMPO_CLOCK_H
+#define TEMPO_CLOCK_H
+
+#include <Arduino.h>
+
+// ================== Tempo Clock ==================
+// The beat grid the metronome flashes (EFFECT_OP_METRONOME) and rhythm
+// practice is scored against (rhythm.h). Beat k falls at anchor + k x period
+// on the esp_timer clock, the 64-bit hardware timer behind
+// esp_timer_get_time() (1 us), so any task can place a timestamp on the grid
+// from a snapshot without asking another. A periodic esp_timer also fires on
+// every beat and wakes the render task, so the metronome flash starts on the
+// beat rather than on the next effects frame. Setting the tempo restarts the
+// grid with beat 0 at that moment.
+struct TempoGrid
+{
+  int64_t anchorUs; // esp_timer_get_time() of beat 0
+  int64_t periodUs; // 0: stopped
+  uint16_t bpm;
+  uint8_t beatsPerBar;
+};
+
+// Create the beat timer. Call once from setup() before the effects.
+void setupTempoClock();
+
+// Start the grid now, or stop it with 0 bpm (any task)
+void tempoClockSet(uint16_t bpm, uint8_t beatsPerBar);
+
+// Consistent copy of the current grid (any task)
+TempoGrid tempoClockGrid();
+
+// Nearest point of the grid divided into `subdivisions` per beat: its index
+// (beat x subdivisions + part) and how far atUs is from it, negative = early.
+// Pure computation.
+int64_t tempoGridNearest(const TempoGrid &grid, int subdivisions, int64_t atUs, int32_t *errorUs);
+
+#endif // TEMPO_CLOCK_H
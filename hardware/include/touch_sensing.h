@@ -0,0 +1,101 @@
+#ifndef TOUCH_SENSING_H
+#define TOUCH_SENSING_H
+
+#include <Arduino.h>
+#include "cell_mask.h"
+
+// ================== Touch Sensing ==================
+// One capacitive pad per fret cell. Each string's pads share a touch channel
+// (TOUCH_STRING_PADS) and an analog mux on TOUCH_ROW_PINS picks the fret row.
+// The touch FSM, started in software, measures all six string channels at
+// once, so a row costs one measurement window (TOUCH_ROW_US, about 40 us)
+// instead of six blocking touchRead() calls: a full scan is 0.3 ms on the
+// 8-fret grid, 1 ms on a 25-fret neck and 1.3 ms on the 32 rows the mux can
+// address. An esp_timer starts a full scan every TOUCH_SCAN_PERIOD_US (500 Hz)
+// on a low-priority task on the application core: the render task preempts it
+// and BLE, on the protocol core, never waits for it. Scanning runs only while
+// the app is connected.
+//
+// The string channels avoid the strapping pins that matter: a finger on GPIO12
+// (MTDI) at reset could select 1.8 V flash, and GPIO0/GPIO2 pick the boot
+// mode. GPIO15 (MTDO) only silences the ROM boot log when held low. Touch
+// builds move the disconnected status LED off GPIO4 (T0) to free it (main.h).
+//
+// Built only with -DGUITARPAL_TOUCH (boards with the sensor matrix fitted);
+// otherwise startTouchScanning() does nothing and the mask stays empty.
+#ifdef GUITARPAL_TOUCH
+#define TOUCH_ENABLED 1
+#else
+#define TOUCH_ENABLED 0
+#endif
+
+#define TOUCH_STRING_PADS {3, 4, 0, 7, 8, 9} // T3 (GPIO15), T4 (13), T0 (4), T7 (27), T8 (33), T9 (32); string 0 first
+#define TOUCH_ROW_PINS {16, 17, 18, 19, 21}  // mux address, bit 0 first (up to 32 rows)
+#define TOUCH_ROW_BITS 5
+#define TOUCH_SETTLE_US 4          // after switching the mux
+#define TOUCH_MEASURE_CYCLES 0x100 // 32 us measurement window at 8 MHz
+#define TOUCH_SLEEP_CYCLES 0x10
+#define TOUCH_ROW_US (TOUCH_SETTLE_US + TOUCH_MEASURE_CYCLES / 8 + 4) // plus start and six register reads
+
+#define TOUCH_SCAN_PERIOD_US 2000 // full neck at 500 Hz
+#define TOUCH_TASK_CORE 1
+#define TOUCH_TASK_PRIORITY 1 // below the render task
+#define TOUCH_TASK_STACK 3072
+
+// ================== Scan Processing ==================
+// Signal is how far a reading has dropped below its cell's baseline. The
+// baseline follows slow drift (temperature, humidity) as an IIR average but
+// freezes while the cell is pressed or close to it, so a resting finger is
+// not learned as the new baseline. A press needs TOUCH_PRESS_SIGNAL and a
+// release TOUCH_RELEASE_SIGNAL (hysteresis), each held TOUCH_DEBOUNCE_SCANS
+// scans in a row before the mask changes.
+#define TOUCH_CALIBRATION_SCANS 32 // averaged into the first baseline
+#define TOUCH_BASELINE_SHIFT 6     // IIR weight 1/64 per scan
+#define TOUCH_PRESS_SIGNAL 40
+#define TOUCH_RELEASE_SIGNAL 20
+#define TOUCH_DEBOUNCE_US 6000
+#define TOUCH_DEBOUNCE_SCANS (TOUCH_DEBOUNCE_US / TOUCH_SCAN_PERIOD_US) // 3 at 500 Hz
+
+struct TouchCell
+{
+  int32_t baseline; // reading << TOUCH_BASELINE_SHIFT
+  uint8_t pending;  // scans the opposite state has been seen in a row
+  bool pressed;
+};
+
+struct TouchScanner
+{
+  TouchCell cells[FRETBOARD_CELLS];
+  CellMask pressed; // debounced, bit = fret cell as in fretLEDs
+  uint32_t scans;   // since the last reset, calibration included
+};
+
+// Start over: calibrate baselines from the next TOUCH_CALIBRATION_SCANS scans
+void touchScannerReset(TouchScanner &scanner);
+
+// Feed one scan (one raw reading per fret cell). Returns true if the pressed
+// mask changed. Pure computation, so the host can replay recorded traces.
+bool touchScannerUpdate(TouchScanner &scanner, const uint16_t *readings);
+
+// ================== Touch Task ==================
+struct TouchStats
+{
+  uint32_t scans;
+  uint32_t late;          // timer ticks that found the previous scan still running
+  uint32_t maxScanMicros; // longest full scan, to check against TOUCH_SCAN_PERIOD_US
+};
+
+// Configure the pads, create the scan timer and task. Call once from setup().
+void setupTouch();
+
+// Start (with a fresh calibration) or stop scanning (supervisor task)
+void startTouchScanning();
+void stopTouchScanning();
+
+// Debounced pressed cells from the latest scan (any task)
+void getTouchMask(CellMask *mask);
+
+// Snapshot of the scan counters
+TouchStats getTouchStats();
+
+#endif // TOUCH_SENSING_H
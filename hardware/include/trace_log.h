@@ -0,0 +1,132 @@
+#ifndef TRACE_LOG_H
+#define TRACE_LOG_H
+
+#include <Arduino.h>
+
+// ================== Log Levels ==================
+// LOG_LEVEL is fixed at build time (-DLOG_LEVEL=4 for debug traces). Calls
+// above it expand to nothing: no code, no format data, arguments not evaluated.
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// ================== Trace Events ==================
+// Enabled calls store a binary record (event ID + up to TRACE_MAX_ARGS ints)
+// in a RAM ring; the trace task formats and prints them later at low priority,
+// so the caller never waits on the UART. Arguments are printf'd as ints.
+#define TRACE_EVENTS(X)                                                              \
+  X(TRACE_CHORD_MALFORMED, "Malformed chord command")                                \
+  X(TRACE_CHORD_PARSED, "Parsed tokens: %d, %d, %d, %d, %d, %d")                     \
+  X(TRACE_SCALE_EMPTY, "Empty scale command")                                        \
+  X(TRACE_SCALE_MALFORMED, "Malformed scale command")                                \
+  X(TRACE_SCALE_PARSED, "Total parsed scale pairs: %d")                              \
+  X(TRACE_CHORD_MUTED, "Don't strum string: %d")                                     \
+  X(TRACE_CHORD_OPEN, "Open string: %d")                                             \
+  X(TRACE_CHORD_FRETTED, "String %d, Position %d -> Grid position %d")               \
+  X(TRACE_SCALE_CONVERT, "Converting %d scale positions to pixels")                  \
+  X(TRACE_SCALE_NOTE, "String %d, Fret %d -> Grid position %d")                      \
+  X(TRACE_SCALE_OUT_OF_RANGE, "Grid position %d exceeds valid LED range")            \
+  X(TRACE_SCALE_BAD_STRING, "Invalid string number: %d")                             \
+  X(TRACE_SHAPE_UNKNOWN, "Unknown shape: root %d, type %d")                          \
+  X(TRACE_PIXELS_CALCULATE, "Calculating pixels for %d chord notes")                 \
+  X(TRACE_PIXELS_FOUND, "String: %d Fret: %d")                                       \
+  X(TRACE_SCALE_NOT_FOUND, "Scale not found: root %d, id %d")                        \
+  X(TRACE_CHORD_NOT_FOUND, "Chord not found: root %d, id %d")                        \
+  X(TRACE_SCALE_GENERATED, "Generated scale %d on root %d: %d notes, set 0x%03X")    \
+  X(TRACE_CHORD_GENERATED, "Generated chord %d on root %d: %d notes, set 0x%03X")    \
+  X(TRACE_RENDER_CHORD, "Rendering chord positions")                                 \
+  X(TRACE_RENDER_SCALE, "Rendering %d scale positions")                              \
+  X(TRACE_RENDER_SHAPE, "Rendering shape: root %d, type %d")                         \
+  X(TRACE_COMMANDS_SUPERSEDED, "Skipped %d stale commands")                          \
+  X(TRACE_INIT_RECEIVED, "Init service received %d bytes")                           \
+  X(TRACE_APP_INITIALIZED, "Mobile app connected and initialized")                   \
+  X(TRACE_CHORD_INVALID, "Invalid chord data format (expected 6 positions)")         \
+  X(TRACE_SCALE_INVALID, "Invalid scale data format")                                \
+  X(TRACE_CLIENT_CONNECTED, "Client connected")                                      \
+  X(TRACE_CLIENT_DISCONNECTED, "Client disconnected - Restarting advertising")       \
+  X(TRACE_ADVERTISING_RESTARTED, "BLE Advertising restarted - Ready for new connection") \
+  X(TRACE_FRAME_STATS, "LED pushes issued: %d, skipped: %d")                        \
+  X(TRACE_LINK_MTU, "Link MTU %d")                                                   \
+  X(TRACE_LINK_PARAMS, "Link interval %d x 1.25 ms, latency %d, timeout %d x 10 ms") \
+  X(TRACE_LINK_PHY, "Link PHY tx %d, rx %d")                                         \
+  X(TRACE_FAST_STALE, "Stale fast frame %d (newest accepted %d)")                    \
+  X(TRACE_FAST_INVALID, "Invalid fast frame")                                        \
+  X(TRACE_SEQUENCE_REJECTED, "Sequence frame rejected, reason %d")                   \
+  X(TRACE_SEQUENCE_STATE, "Sequence state %d: %d steps, %d bpm, loop %d")            \
+  X(TRACE_POWER_MODE, "Power management mode %d")                                   \
+  X(TRACE_POWER_UNAVAILABLE, "Power management unavailable: no CONFIG_PM_ENABLE")    \
+  X(TRACE_POWER_FAILED, "Power management setup failed, error %d")                   \
+  X(TRACE_POWER_NO_LIGHT_SLEEP, "No light sleep: tickless idle off in the SDK")      \
+  X(TRACE_TOUCH_STATS, "Touch scans: %d, late ticks: %d, longest scan %d us")       \
+  X(TRACE_AUDIO_MODE, "Audio mode %d")                                               \
+  X(TRACE_AUDIO_STATS, "Audio blocks: %d, short reads: %d, longest block %d us")     \
+  X(TRACE_EFFECTS_SETTINGS, "Effects: fade %d ms, reveal %d ms, pulse %d ms, metronome %d bpm / %d") \
+  X(TRACE_TUNING, "Tuning %d, capo %d: tables rebuilt in %d us")
+
+#define TRACE_EVENT_ID(id, format) id,
+enum TraceEvent : uint8_t
+{
+  TRACE_EVENTS(TRACE_EVENT_ID)
+  TRACE_EVENT_COUNT
+};
+#undef TRACE_EVENT_ID
+
+#define TRACE_MAX_ARGS 6
+#define TRACE_RING_SIZE 64 // records, must be a power of two
+
+struct TraceRecord
+{
+  uint32_t timestamp; // micros()
+  uint8_t level;
+  uint8_t event;
+  int args[TRACE_MAX_ARGS];
+};
+
+// ================== Trace Task ==================
+#define TRACE_TASK_CORE 0
+#define TRACE_TASK_PRIORITY 1 // just above idle: never competes with BLE or rendering
+#define TRACE_TASK_STACK 3072
+#define TRACE_DRAIN_PERIOD_MS 20
+
+// Append a record. Safe from any task; never blocks. If the ring is full the
+// record is dropped and counted, and the trace task reports the loss.
+void traceLog(uint8_t level, TraceEvent event, int a0 = 0, int a1 = 0, int a2 = 0,
+              int a3 = 0, int a4 = 0, int a5 = 0);
+
+// Take the oldest record (trace task only). Returns false if the ring is empty.
+bool tracePop(TraceRecord *record);
+
+// Start the task that prints the ring over Serial. Call once from setup().
+void startTraceTask();
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) traceLog(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) traceLog(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) traceLog(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) traceLog(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#endif // TRACE_LOG_H
@@ -0,0 +1,60 @@
+#ifndef TUNER_H
+#define TUNER_H
+
+#include <Arduino.h>
+#include "pitch_detect.h"
+
+// ================== Tuner ==================
+// AUDIO_MODE_TUNER: on every block the newest PITCH_FRAME_SAMPLES samples go
+// through estimatePitch(), the median of the last three periods is matched to
+// the nearest open string (openStringMidi in main.h) and the deviation is
+// shown on that string's line of cells: the nut cell marks the string, the
+// middle fret row is in tune and each row towards the nut is
+// TUNER_CENTS_PER_ROW flatter, towards the body sharper. The display only
+// changes when the needle moves; EVENT_TUNER carries the exact reading.
+#define TUNER_CENTS_PER_ROW 10
+#define TUNER_IN_TUNE_CENTS 5      // needle turns green within this
+#define TUNER_MAX_CENTS 300        // further from every open string: not tuning a string
+#define TUNER_HOLD_MS 1000         // keep the last reading this long after the note dies
+#define TUNER_EVENT_INTERVAL_MS 100 // EVENT_TUNER while the needle is still
+#define TUNER_NO_STRING 0xFF
+
+#define TUNER_COLOR_STRING 0x0000FF  // nut cell of the string being tuned
+#define TUNER_COLOR_CENTRE 0x202020  // in-tune row, while out of tune
+#define TUNER_COLOR_OFF 0xFF0000
+#define TUNER_COLOR_IN_TUNE 0x00FF00
+
+struct TunerReading
+{
+  uint8_t string;       // nearest open string, TUNER_NO_STRING if none
+  int16_t cents;        // from that string's pitch, negative = flat
+  uint32_t centiHz;
+  uint16_t aperiodicity; // Q15, as PitchEstimate
+};
+
+struct TunerState
+{
+  int16_t frame[PITCH_FRAME_SAMPLES]; // newest samples last
+  int filled;
+  uint32_t periods[3]; // last voiced periods, for the median
+  int periodCount;
+};
+
+// Start over with an empty frame
+void tunerStateReset(TunerState &state);
+
+// Feed one AUDIO_BLOCK_SAMPLES block. Returns true with a reading once the
+// frame is full and voiced, else false. Pure computation apart from the
+// openStringMidi table, so the host can run recordings through it.
+bool tunerAnalyze(TunerState &state, const int16_t *block, TunerReading *reading);
+
+// Needle row for a deviation: FRETBOARD_FRETS / 2 is in tune
+int tunerNeedleRow(int cents);
+
+// Tuner mode entered (audio task)
+void resetTuner();
+
+// Analyse a block and update the display and events (audio task)
+void tunerProcessBlock(const int16_t *block);
+
+#endif // TUNER_H
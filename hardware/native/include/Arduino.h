@@ -0,0 +1,184 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Host stand-in for the parts of the Arduino-ESP32 core the firmware uses.
+// Only compiled by the [env:native] build; see native/README.md.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+#include <atomic>
+
+#define GUITARPAL_NATIVE 1
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define DEC 10
+#define HEX 16
+
+#define PROGMEM
+#define IRAM_ATTR
+
+// ================== String ==================
+// Backed by std::string; only the members the firmware calls are provided
+class String
+{
+public:
+  String() {}
+  String(const char *value) : text(value ? value : "") {}
+  String(const std::string &value) : text(value) {}
+  String(char value) : text(1, value) {}
+  String(int value, unsigned char base = DEC);
+  String(unsigned int value, unsigned char base = DEC);
+  String(long value, unsigned char base = DEC);
+  String(unsigned long value, unsigned char base = DEC);
+
+  unsigned int length() const { return (unsigned int)text.size(); }
+  const char *c_str() const { return text.c_str(); }
+  char operator[](unsigned int index) const { return index < text.size() ? text[index] : 0; }
+
+  int indexOf(char c, unsigned int from = 0) const;
+  String substring(unsigned int from) const;
+  String substring(unsigned int from, unsigned int to) const;
+  void trim();
+  long toInt() const { return atol(text.c_str()); }
+  bool startsWith(const char *prefix) const { return text.compare(0, strlen(prefix), prefix) == 0; }
+  bool endsWith(const char *suffix) const;
+
+  bool operator==(const char *other) const { return text == other; }
+  bool operator==(const String &other) const { return text == other.text; }
+  String &operator+=(const String &other)
+  {
+    text += other.text;
+    return *this;
+  }
+  friend String operator+(const String &a, const String &b) { return String(a.text + b.text); }
+  friend String operator+(const char *a, const String &b) { return String(std::string(a) + b.text); }
+
+private:
+  std::string text;
+};
+
+// ================== Serial ==================
+// Output is dropped unless echo is enabled (simulator --serial), so hot paths
+// still pay for formatting but not for a terminal.
+class HardwareSerial
+{
+public:
+  void begin(unsigned long baud) { (void)baud; }
+  void end() {}
+  void flush() {}
+  void setEcho(bool enabled) { echo = enabled; }
+
+  size_t write(uint8_t c);
+  size_t write(const uint8_t *buffer, size_t size);
+
+  size_t print(const char *value);
+  size_t print(const String &value) { return print(value.c_str()); }
+  size_t print(char value);
+  size_t print(int value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = DEC);
+  size_t print(unsigned long value, int base = DEC);
+  size_t print(long long value, int base = DEC) { return print((long)value, base); }
+  size_t print(unsigned long long value, int base = DEC) { return print((unsigned long)value, base); }
+  size_t print(double value, int digits = 2);
+
+  template <typename T>
+  size_t println(const T &value)
+  {
+    size_t n = print(value);
+    return n + println();
+  }
+  template <typename T>
+  size_t println(const T &value, int format)
+  {
+    size_t n = print(value, format);
+    return n + println();
+  }
+  size_t println() { return print("\r\n"); }
+
+private:
+  bool echo = false;
+};
+
+extern HardwareSerial Serial;
+
+// ================== ESP ==================
+class EspClass
+{
+public:
+  uint32_t getFreeHeap() { return 0; } // no heap accounting on the host
+};
+
+extern EspClass ESP;
+
+// ================== Timing and GPIO ==================
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+// ================== FreeRTOS ==================
+// Tasks run as host threads; task notifications are counting semaphores.
+typedef struct NativeTask *TaskHandle_t;
+typedef struct NativeQueue *QueueHandle_t;
+typedef void (*TaskFunction_t)(void *);
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define portMAX_DELAY 0xFFFFFFFFu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskIDLE_PRIORITY 0
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stackDepth,
+                                   void *parameter, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core);
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelete(TaskHandle_t task); // host: only nullptr (the calling task) is supported
+TickType_t xTaskGetTickCount();
+
+// Critical sections: a spinlock, as between the two ESP32 cores
+typedef struct
+{
+  std::atomic<bool> locked;
+} portMUX_TYPE;
+#define portMUX_INITIALIZER_UNLOCKED {false}
+
+inline void portENTER_CRITICAL(portMUX_TYPE *mux)
+{
+  while (mux->locked.exchange(true, std::memory_order_acquire))
+  {
+  }
+}
+
+inline void portEXIT_CRITICAL(portMUX_TYPE *mux)
+{
+  mux->locked.store(false, std::memory_order_release);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticksToWait);
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticksToWait);
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue);
+
+// Host-only: block until every task is waiting (ulTaskNotifyTake, xQueueReceive
+// or vTaskDelay) with nothing pending for it, i.e. all queued work is processed.
+void nativeWaitForIdle();
+
+#endif // NATIVE_ARDUINO_H
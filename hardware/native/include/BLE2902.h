@@ -0,0 +1,17 @@
+#ifndef NATIVE_BLE2902_H
+#define NATIVE_BLE2902_H
+
+#include "BLEDevice.h"
+
+// Client Characteristic Configuration descriptor
+class BLE2902 : public BLEDescriptor
+{
+public:
+  void setNotifications(bool enabled) { notifications = enabled; }
+  bool getNotifications() const { return notifications; }
+
+private:
+  bool notifications = false;
+};
+
+#endif // NATIVE_BLE2902_H
@@ -0,0 +1,188 @@
+#ifndef NATIVE_BLEDEVICE_H
+#define NATIVE_BLEDEVICE_H
+
+// Host stand-in for the ESP32 BLE library. Characteristics keep their value in
+// memory; the simulator injects writes with simulateWrite() and drives the
+// connection callbacks with simulateConnect()/simulateDisconnect().
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+
+class BLECharacteristic;
+class BLEServer;
+
+// ================== ESP-IDF GATT/GAP types ==================
+// Only the fields the firmware reads
+typedef uint8_t esp_bd_addr_t[6];
+
+#define ESP_BT_STATUS_SUCCESS 0
+
+typedef union
+{
+  struct
+  {
+    uint16_t conn_id;
+    esp_bd_addr_t remote_bda;
+  } connect;
+  struct
+  {
+    uint16_t conn_id;
+    uint16_t mtu;
+  } mtu;
+} esp_ble_gatts_cb_param_t;
+
+typedef enum
+{
+  ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT = 20,
+} esp_gap_ble_cb_event_t;
+
+typedef union
+{
+  struct
+  {
+    int status;
+    esp_bd_addr_t bda;
+    uint16_t min_int;
+    uint16_t max_int;
+    uint16_t latency;
+    uint16_t conn_int;
+    uint16_t timeout;
+  } update_conn_params;
+} esp_ble_gap_cb_param_t;
+
+typedef void (*gap_event_handler)(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param);
+
+class BLEUUID
+{
+public:
+  BLEUUID(const char *uuid) : value(uuid) {}
+  std::string toString() const { return value; }
+
+private:
+  std::string value;
+};
+
+class BLECharacteristicCallbacks
+{
+public:
+  virtual ~BLECharacteristicCallbacks() {}
+  virtual void onRead(BLECharacteristic *pCharacteristic) { (void)pCharacteristic; }
+  virtual void onWrite(BLECharacteristic *pCharacteristic) { (void)pCharacteristic; }
+};
+
+class BLEDescriptor
+{
+public:
+  virtual ~BLEDescriptor() {}
+};
+
+class BLECharacteristic
+{
+public:
+  static const uint32_t PROPERTY_READ = 1 << 0;
+  static const uint32_t PROPERTY_WRITE = 1 << 1;
+  static const uint32_t PROPERTY_NOTIFY = 1 << 2;
+  static const uint32_t PROPERTY_BROADCAST = 1 << 3;
+  static const uint32_t PROPERTY_INDICATE = 1 << 4;
+  static const uint32_t PROPERTY_WRITE_NR = 1 << 5;
+
+  BLECharacteristic(const char *uuid, uint32_t properties) : uuid(uuid), properties(properties) {}
+
+  std::string getValue() const { return value; }
+  uint8_t *getData() { return (uint8_t *)value.data(); }
+  size_t getLength() const { return value.size(); }
+  void setValue(const char *text) { value = text; }
+  void setValue(const std::string &text) { value = text; }
+  void setValue(const uint8_t *data, size_t length) { value.assign((const char *)data, length); }
+  void addDescriptor(BLEDescriptor *descriptor) { (void)descriptor; }
+  void setCallbacks(BLECharacteristicCallbacks *pCallbacks) { callbacks = pCallbacks; }
+  void notify() { notifications.push_back(value); }
+
+  // Host-only helpers
+  const char *getUUIDString() const { return uuid.c_str(); }
+  uint32_t getProperties() const { return properties; }
+  void simulateWrite(const uint8_t *data, size_t length);
+  std::vector<std::string> notifications; // every value passed to notify()
+
+private:
+  std::string uuid;
+  uint32_t properties;
+  std::string value;
+  BLECharacteristicCallbacks *callbacks = nullptr;
+};
+
+class BLEService
+{
+public:
+  explicit BLEService(const char *uuid) : uuid(uuid) {}
+  BLECharacteristic *createCharacteristic(const char *charUuid, uint32_t properties);
+  void start() {}
+
+  // Host-only: look a characteristic up by UUID
+  BLECharacteristic *getCharacteristic(const char *charUuid);
+
+private:
+  std::string uuid;
+  std::vector<BLECharacteristic *> characteristics;
+};
+
+class BLEServerCallbacks
+{
+public:
+  virtual ~BLEServerCallbacks() {}
+  virtual void onConnect(BLEServer *pServer) { (void)pServer; }
+  virtual void onConnect(BLEServer *pServer, esp_ble_gatts_cb_param_t *param) { (void)pServer, (void)param; }
+  virtual void onDisconnect(BLEServer *pServer) { (void)pServer; }
+  virtual void onMtuChanged(BLEServer *pServer, esp_ble_gatts_cb_param_t *param) { (void)pServer, (void)param; }
+};
+
+class BLEServer
+{
+public:
+  void setCallbacks(BLEServerCallbacks *pCallbacks) { callbacks = pCallbacks; }
+  BLEService *createService(const char *uuid);
+  BLEService *createService(BLEUUID uuid, uint32_t numHandles, uint8_t instId = 0);
+  void startAdvertising() { advertising = true; }
+  uint32_t getConnectedCount() const { return connectedCount; }
+
+  // The host "central" grants every request as asked, at the maximum interval
+  void updateConnParams(esp_bd_addr_t remote_bda, uint16_t minInterval, uint16_t maxInterval,
+                        uint16_t latency, uint16_t timeout);
+
+  // Host-only helpers
+  BLECharacteristic *findCharacteristic(const char *charUuid);
+  void simulateConnect();
+  void simulateDisconnect();
+  void simulateMtu(uint16_t mtu); // central-initiated MTU exchange, capped at BLEDevice::setMTU()
+  bool isAdvertising() const { return advertising; }
+
+private:
+  std::vector<BLEService *> services;
+  BLEServerCallbacks *callbacks = nullptr;
+  uint32_t connectedCount = 0;
+  bool advertising = false;
+};
+
+class BLEAdvertising
+{
+public:
+  void addServiceUUID(const char *uuid) { (void)uuid; }
+  void setScanResponse(bool enabled) { (void)enabled; }
+  void setMinPreferred(uint16_t interval) { (void)interval; }
+  void setMaxPreferred(uint16_t interval) { (void)interval; }
+};
+
+class BLEDevice
+{
+public:
+  static void init(const char *deviceName) { (void)deviceName; }
+  static void setMTU(uint16_t mtu);
+  static uint16_t getMTU();
+  static void setCustomGapHandler(gap_event_handler handler);
+  static BLEServer *createServer();
+  static BLEAdvertising *getAdvertising();
+  static void startAdvertising();
+};
+
+#endif // NATIVE_BLEDEVICE_H
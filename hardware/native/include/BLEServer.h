@@ -0,0 +1,6 @@
+#ifndef NATIVE_BLESERVER_H
+#define NATIVE_BLESERVER_H
+
+#include "BLEDevice.h"
+
+#endif // NATIVE_BLESERVER_H
@@ -0,0 +1,99 @@
+#ifndef NATIVE_FASTLED_H
+#define NATIVE_FASTLED_H
+
+// Host stand-in for the subset of FastLED the firmware uses. show() hands the
+// registered LED buffer to a callback instead of a data pin; the 8-bit math
+// helpers are in lib8tion.h.
+
+#include <stdint.h>
+#include "lib8tion.h"
+
+struct CRGB
+{
+  uint8_t r;
+  uint8_t g;
+  uint8_t b;
+
+  // Same values as FastLED's HTMLColorCode
+  enum HTMLColorCode : uint32_t
+  {
+    Black = 0x000000,
+    Blue = 0x0000FF,
+    Green = 0x008000,
+    Orange = 0xFFA500,
+    Purple = 0x800080,
+    Red = 0xFF0000,
+    White = 0xFFFFFF,
+    Yellow = 0xFFFF00
+  };
+
+  CRGB() : r(0), g(0), b(0) {}
+  CRGB(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue) {}
+  CRGB(uint32_t colorCode) : r((colorCode >> 16) & 0xFF), g((colorCode >> 8) & 0xFF), b(colorCode & 0xFF) {}
+  CRGB(HTMLColorCode colorCode) : CRGB((uint32_t)colorCode) {}
+
+  CRGB &nscale8_video(uint8_t scale)
+  {
+    r = scale8_video(r, scale);
+    g = scale8_video(g, scale);
+    b = scale8_video(b, scale);
+    return *this;
+  }
+
+  bool operator==(const CRGB &other) const { return r == other.r && g == other.g && b == other.b; }
+  bool operator!=(const CRGB &other) const { return !(*this == other); }
+};
+
+// colorutils: amountOfP2 / 256 of the way from p1 to p2
+inline CRGB blend(const CRGB &p1, const CRGB &p2, fract8 amountOfP2)
+{
+  return CRGB(blend8(p1.r, p2.r, amountOfP2), blend8(p1.g, p2.g, amountOfP2), blend8(p1.b, p2.b, amountOfP2));
+}
+
+enum ESPIChipsets
+{
+  WS2812B
+};
+
+enum EOrder
+{
+  RGB,
+  GRB
+};
+
+#define DISABLE_DITHER 0x00
+#define BINARY_DITHER 0x01
+
+typedef void (*NativeShowCallback)(const CRGB *leds, int count, uint8_t brightness);
+
+class CFastLED
+{
+public:
+  template <ESPIChipsets CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+  void addLeds(CRGB *data, int count)
+  {
+    leds = data;
+    ledCount = count;
+  }
+
+  void show();
+  void setBrightness(uint8_t value) { brightness = value; }
+  uint8_t getBrightness() const { return brightness; }
+  void setDither(uint8_t mode = BINARY_DITHER) { dither = mode; }
+
+  // Host-only: observe every push
+  void setShowCallback(NativeShowCallback callback) { showCallback = callback; }
+  uint32_t getShowCount() const { return showCount; }
+
+private:
+  CRGB *leds = nullptr;
+  int ledCount = 0;
+  uint8_t brightness = 255;
+  uint8_t dither = BINARY_DITHER; // recorded only; pushes are not dithered on the host
+  uint32_t showCount = 0;
+  NativeShowCallback showCallback = nullptr;
+};
+
+extern CFastLED FastLED;
+
+#endif // NATIVE_FASTLED_H
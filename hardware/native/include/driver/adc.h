@@ -0,0 +1,35 @@
+#ifndef NATIVE_DRIVER_ADC_H
+#define NATIVE_DRIVER_ADC_H
+
+// Host stand-in for the ESP-IDF (legacy) ADC driver: only what the I2S
+// built-in ADC mode needs. Settings are accepted and ignored.
+
+typedef enum
+{
+  ADC_UNIT_1 = 1,
+} adc_unit_t;
+
+typedef enum
+{
+  ADC1_CHANNEL_0 = 0,
+  ADC1_CHANNEL_3 = 3,
+  ADC1_CHANNEL_4,
+  ADC1_CHANNEL_5,
+  ADC1_CHANNEL_6,
+  ADC1_CHANNEL_7,
+} adc1_channel_t;
+
+typedef enum
+{
+  ADC_ATTEN_DB_0 = 0,
+  ADC_ATTEN_DB_11 = 3,
+} adc_atten_t;
+
+typedef int esp_err_t;
+#ifndef ESP_OK
+#define ESP_OK 0
+#endif
+
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten);
+
+#endif // NATIVE_DRIVER_ADC_H
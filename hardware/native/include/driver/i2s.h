@@ -0,0 +1,69 @@
+#ifndef NATIVE_DRIVER_I2S_H
+#define NATIVE_DRIVER_I2S_H
+
+// Host stand-in for the ESP-IDF (legacy) I2S driver in built-in ADC mode.
+// i2s_read() returns samples in the ADC's DMA format (12-bit reading, channel
+// in the top nibble, each pair swapped) and paces itself to the sample rate,
+// so the audio task runs in real time. The samples come from the source set
+// with nativeSetAudioSource(); without one the input is silent (mid-scale).
+
+#include <stddef.h>
+#include <stdint.h>
+#include "driver/adc.h"
+#include "Arduino.h"
+
+typedef enum
+{
+  I2S_NUM_0 = 0,
+} i2s_port_t;
+
+typedef enum
+{
+  I2S_MODE_MASTER = 1,
+  I2S_MODE_RX = 4,
+  I2S_MODE_ADC_BUILT_IN = 32,
+} i2s_mode_t;
+
+typedef enum
+{
+  I2S_BITS_PER_SAMPLE_16BIT = 16,
+} i2s_bits_per_sample_t;
+
+typedef enum
+{
+  I2S_CHANNEL_FMT_ONLY_LEFT = 4,
+} i2s_channel_fmt_t;
+
+typedef enum
+{
+  I2S_COMM_FORMAT_STAND_I2S = 1,
+} i2s_comm_format_t;
+
+typedef struct
+{
+  i2s_mode_t mode;
+  uint32_t sample_rate;
+  i2s_bits_per_sample_t bits_per_sample;
+  i2s_channel_fmt_t channel_format;
+  i2s_comm_format_t communication_format;
+  int intr_alloc_flags;
+  int dma_buf_count;
+  int dma_buf_len;
+  bool use_apll;
+} i2s_config_t;
+
+esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t *config, int queueSize, void *queue);
+esp_err_t i2s_set_adc_mode(adc_unit_t unit, adc1_channel_t channel);
+esp_err_t i2s_adc_enable(i2s_port_t port);
+esp_err_t i2s_adc_disable(i2s_port_t port);
+esp_err_t i2s_start(i2s_port_t port);
+esp_err_t i2s_stop(i2s_port_t port);
+esp_err_t i2s_zero_dma_buffer(i2s_port_t port);
+esp_err_t i2s_read(i2s_port_t port, void *dest, size_t size, size_t *bytesRead, TickType_t ticksToWait);
+
+// Host-only: fill count samples, each a 12-bit reading (0-4095, 2048 = silence).
+// Called from the audio task inside i2s_read().
+typedef void (*NativeAudioSource)(uint16_t *samples, size_t count);
+void nativeSetAudioSource(NativeAudioSource source);
+
+#endif // NATIVE_DRIVER_I2S_H
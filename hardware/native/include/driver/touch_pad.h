@@ -0,0 +1,54 @@
+#ifndef NATIVE_DRIVER_TOUCH_PAD_H
+#define NATIVE_DRIVER_TOUCH_PAD_H
+
+// Host stand-in for the ESP-IDF (legacy) touch pad driver in software-start
+// mode. touch_pad_sw_start() measures every configured pad at once, as the
+// ESP32's touch FSM does, taking each value from the reader set with
+// nativeSetTouchReader(); without one every pad reads untouched.
+// touch_pad_read_raw_data() returns the last measurement.
+
+#include <stdint.h>
+#include "Arduino.h"
+
+typedef enum
+{
+  TOUCH_PAD_NUM0 = 0,
+  TOUCH_PAD_NUM1,
+  TOUCH_PAD_NUM2,
+  TOUCH_PAD_NUM3,
+  TOUCH_PAD_NUM4,
+  TOUCH_PAD_NUM5,
+  TOUCH_PAD_NUM6,
+  TOUCH_PAD_NUM7,
+  TOUCH_PAD_NUM8,
+  TOUCH_PAD_NUM9,
+  TOUCH_PAD_MAX,
+} touch_pad_t;
+
+typedef enum
+{
+  TOUCH_FSM_MODE_TIMER = 0,
+  TOUCH_FSM_MODE_SW,
+} touch_fsm_mode_t;
+
+typedef int esp_err_t;
+#ifndef ESP_OK
+#define ESP_OK 0
+#endif
+#ifndef ESP_ERR_INVALID_ARG
+#define ESP_ERR_INVALID_ARG 0x102
+#endif
+
+esp_err_t touch_pad_init();
+esp_err_t touch_pad_set_fsm_mode(touch_fsm_mode_t mode);
+esp_err_t touch_pad_set_meas_time(uint16_t sleepCycles, uint16_t measureCycles);
+esp_err_t touch_pad_config(touch_pad_t pad, uint16_t threshold);
+esp_err_t touch_pad_sw_start();
+bool touch_pad_meas_is_done();
+esp_err_t touch_pad_read_raw_data(touch_pad_t pad, uint16_t *value);
+
+// Host-only: where measurements get their values (default: every pad untouched)
+typedef uint16_t (*NativeTouchReader)(touch_pad_t pad);
+void nativeSetTouchReader(NativeTouchReader reader);
+
+#endif // NATIVE_DRIVER_TOUCH_PAD_H
@@ -0,0 +1,65 @@
+#ifndef NATIVE_LIB8TION_H
+#define NATIVE_LIB8TION_H
+
+// Host copies of the FastLED lib8tion functions the firmware uses, with the
+// same results as the library's portable C versions (FASTLED_SCALE8_FIXED).
+
+#include <stdint.h>
+
+typedef uint8_t fract8; // fraction of 256
+
+inline uint8_t scale8(uint8_t i, fract8 scale)
+{
+  return (uint8_t)(((uint16_t)i * (1 + (uint16_t)scale)) >> 8);
+}
+
+// Never scales a non-zero value down to zero
+inline uint8_t scale8_video(uint8_t i, fract8 scale)
+{
+  return (uint8_t)((((uint16_t)i * scale) >> 8) + ((i && scale) ? 1 : 0));
+}
+
+inline uint8_t qadd8(uint8_t i, uint8_t j)
+{
+  unsigned sum = (unsigned)i + j;
+  return sum > 255 ? 255 : (uint8_t)sum;
+}
+
+inline uint8_t qsub8(uint8_t i, uint8_t j)
+{
+  return i > j ? (uint8_t)(i - j) : 0;
+}
+
+inline uint8_t blend8(uint8_t a, uint8_t b, uint8_t amountOfB)
+{
+  uint16_t partial = (uint16_t)((a << 8) | b);
+  partial += (uint16_t)(b * amountOfB);
+  partial -= (uint16_t)(a * amountOfB);
+  return (uint8_t)(partial >> 8);
+}
+
+inline uint8_t ease8InOutQuad(uint8_t i)
+{
+  uint8_t j = i;
+  if (j & 0x80)
+    j = 255 - j;
+  uint8_t jj = scale8(j, j);
+  uint8_t jj2 = (uint8_t)(jj << 1);
+  if (i & 0x80)
+    jj2 = 255 - jj2;
+  return jj2;
+}
+
+inline uint8_t triwave8(uint8_t in)
+{
+  if (in & 0x80)
+    in = 255 - in;
+  return (uint8_t)(in << 1);
+}
+
+inline uint8_t quadwave8(uint8_t in)
+{
+  return ease8InOutQuad(triwave8(in));
+}
+
+#endif // NATIVE_LIB8TION_H
@@ -0,0 +1,641 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include <esp_timer.h>
+#include <driver/i2s.h>
+#include <driver/touch_pad.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+HardwareSerial Serial;
+EspClass ESP;
+CFastLED FastLED;
+
+// ================== String ==================
+static std::string formatNumber(unsigned long value, bool negative, unsigned char base)
+{
+  if (base < 2 || base > 16)
+    base = DEC;
+
+  char digits[72];
+  int length = 0;
+  do
+  {
+    digits[length++] = "0123456789ABCDEF"[value % base];
+    value /= base;
+  } while (value != 0);
+
+  std::string text = negative ? "-" : "";
+  while (length > 0)
+    text += digits[--length];
+  return text;
+}
+
+static std::string formatSigned(long value, unsigned char base)
+{
+  bool negative = value < 0 && base == DEC;
+  unsigned long magnitude = negative ? (unsigned long)(-(value + 1)) + 1 : (unsigned long)value;
+  return formatNumber(magnitude, negative, base);
+}
+
+String::String(int value, unsigned char base) : text(formatSigned(value, base)) {}
+String::String(unsigned int value, unsigned char base) : text(formatNumber(value, false, base)) {}
+String::String(long value, unsigned char base) : text(formatSigned(value, base)) {}
+String::String(unsigned long value, unsigned char base) : text(formatNumber(value, false, base)) {}
+
+int String::indexOf(char c, unsigned int from) const
+{
+  size_t position = text.find(c, from);
+  return position == std::string::npos ? -1 : (int)position;
+}
+
+String String::substring(unsigned int from) const
+{
+  return from >= text.size() ? String() : String(text.substr(from));
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+  if (from > to)
+  {
+    unsigned int swap = from;
+    from = to;
+    to = swap;
+  }
+  if (from >= text.size())
+    return String();
+  return String(text.substr(from, to - from));
+}
+
+void String::trim()
+{
+  size_t first = text.find_first_not_of(" \t\r\n");
+  if (first == std::string::npos)
+  {
+    text.clear();
+    return;
+  }
+  size_t last = text.find_last_not_of(" \t\r\n");
+  text = text.substr(first, last - first + 1);
+}
+
+bool String::endsWith(const char *suffix) const
+{
+  size_t length = strlen(suffix);
+  return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+// ================== Serial ==================
+size_t HardwareSerial::write(uint8_t c)
+{
+  if (echo)
+    fputc(c, stderr);
+  return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  if (echo)
+    fwrite(buffer, 1, size, stderr);
+  return size;
+}
+
+size_t HardwareSerial::print(const char *value)
+{
+  return write((const uint8_t *)value, strlen(value));
+}
+
+size_t HardwareSerial::print(char value)
+{
+  return write((uint8_t)value);
+}
+
+size_t HardwareSerial::print(long value, int base)
+{
+  return print(formatSigned(value, (unsigned char)base).c_str());
+}
+
+size_t HardwareSerial::print(unsigned long value, int base)
+{
+  return print(formatNumber(value, false, (unsigned char)base).c_str());
+}
+
+size_t HardwareSerial::print(double value, int digits)
+{
+  char text[48];
+  snprintf(text, sizeof(text), "%.*f", digits, value);
+  return print(text);
+}
+
+// ================== Timing and GPIO ==================
+static const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+
+unsigned long millis()
+{
+  return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - bootTime)
+      .count();
+}
+
+unsigned long micros()
+{
+  return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - bootTime)
+      .count();
+}
+
+void delay(unsigned long ms)
+{
+  vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+static uint8_t pinLevels[64];
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  (void)pin;
+  (void)mode;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+  if (pin < sizeof(pinLevels))
+    pinLevels[pin] = value;
+}
+
+int digitalRead(uint8_t pin)
+{
+  return pin < sizeof(pinLevels) ? pinLevels[pin] : LOW;
+}
+
+// ================== Touch Pads ==================
+#define NATIVE_TOUCH_IDLE 400 // typical untouched reading with the default cycles
+
+static std::atomic<NativeTouchReader> touchReader(nullptr);
+static bool touchConfigured[TOUCH_PAD_MAX];
+static uint16_t touchValues[TOUCH_PAD_MAX];
+
+esp_err_t touch_pad_init()
+{
+  for (int pad = 0; pad < TOUCH_PAD_MAX; pad++)
+    touchValues[pad] = NATIVE_TOUCH_IDLE;
+  return ESP_OK;
+}
+
+esp_err_t touch_pad_set_fsm_mode(touch_fsm_mode_t mode)
+{
+  (void)mode;
+  return ESP_OK;
+}
+
+esp_err_t touch_pad_set_meas_time(uint16_t sleepCycles, uint16_t measureCycles)
+{
+  (void)sleepCycles;
+  (void)measureCycles;
+  return ESP_OK;
+}
+
+esp_err_t touch_pad_config(touch_pad_t pad, uint16_t threshold)
+{
+  (void)threshold;
+  if (pad >= TOUCH_PAD_MAX)
+    return ESP_ERR_INVALID_ARG;
+  touchConfigured[pad] = true;
+  return ESP_OK;
+}
+
+esp_err_t touch_pad_sw_start()
+{
+  NativeTouchReader reader = touchReader.load();
+  for (int pad = 0; pad < TOUCH_PAD_MAX; pad++)
+  {
+    if (touchConfigured[pad])
+      touchValues[pad] = reader != nullptr ? reader((touch_pad_t)pad) : NATIVE_TOUCH_IDLE;
+  }
+  return ESP_OK;
+}
+
+bool touch_pad_meas_is_done()
+{
+  return true;
+}
+
+esp_err_t touch_pad_read_raw_data(touch_pad_t pad, uint16_t *value)
+{
+  if (pad >= TOUCH_PAD_MAX || !touchConfigured[pad])
+    return ESP_ERR_INVALID_ARG;
+  *value = touchValues[pad];
+  return ESP_OK;
+}
+
+void nativeSetTouchReader(NativeTouchReader reader)
+{
+  touchReader.store(reader);
+}
+
+// ================== FreeRTOS ==================
+struct NativeTask
+{
+  std::condition_variable wake;
+  uint32_t notifications = 0;
+  bool waiting = false; // blocked in ulTaskNotifyTake, xQueueReceive or vTaskDelay
+  NativeQueue *waitQueue = nullptr; // set while blocked in xQueueReceive
+  TaskFunction_t function = nullptr;
+  void *parameter = nullptr;
+};
+
+static std::mutex taskMutex;
+static std::vector<NativeTask *> taskList;
+static thread_local NativeTask *currentTask = nullptr;
+
+// The Arduino "loop task" (the host main thread) gets a handle on first use
+static NativeTask *selfTask()
+{
+  if (currentTask == nullptr)
+  {
+    currentTask = new NativeTask();
+    std::lock_guard<std::mutex> lock(taskMutex);
+    taskList.push_back(currentTask);
+  }
+  return currentTask;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stackDepth,
+                                   void *parameter, UBaseType_t priority, TaskHandle_t *handle,
+                                   BaseType_t core)
+{
+  (void)name;
+  (void)stackDepth;
+  (void)priority;
+  (void)core;
+
+  NativeTask *nativeTask = new NativeTask();
+  nativeTask->function = task;
+  nativeTask->parameter = parameter;
+  {
+    std::lock_guard<std::mutex> lock(taskMutex);
+    taskList.push_back(nativeTask);
+  }
+  if (handle != nullptr)
+    *handle = nativeTask;
+
+  std::thread([nativeTask]() {
+    currentTask = nativeTask;
+    nativeTask->function(nativeTask->parameter);
+  }).detach();
+  return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t ticksToWait)
+{
+  NativeTask *task = selfTask();
+  std::unique_lock<std::mutex> lock(taskMutex);
+  task->waiting = true;
+  auto ready = [task]() { return task->notifications > 0; };
+  if (ticksToWait == portMAX_DELAY)
+    task->wake.wait(lock, ready);
+  else
+    task->wake.wait_for(lock, std::chrono::milliseconds(ticksToWait), ready);
+  task->waiting = false;
+
+  uint32_t value = task->notifications;
+  if (value > 0)
+    task->notifications = clearOnExit ? 0 : value - 1;
+  return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+  std::lock_guard<std::mutex> lock(taskMutex);
+  task->notifications++;
+  task->wake.notify_one();
+  return pdPASS;
+}
+
+// Sleep counted as waiting, so nativeWaitForIdle() does not wait on it
+static void sleepUntil(std::chrono::steady_clock::time_point deadline)
+{
+  NativeTask *task = selfTask();
+  {
+    std::lock_guard<std::mutex> lock(taskMutex);
+    task->waiting = true;
+  }
+  std::this_thread::sleep_until(deadline);
+  std::lock_guard<std::mutex> lock(taskMutex);
+  task->waiting = false;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+  sleepUntil(std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks));
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+  // A host thread cannot be killed from outside; the caller parks for good instead
+  NativeTask *self = selfTask();
+  if (task != nullptr && task != self)
+    return;
+  {
+    std::lock_guard<std::mutex> lock(taskMutex);
+    self->waiting = true;
+  }
+  for (;;)
+    std::this_thread::sleep_for(std::chrono::hours(1));
+}
+
+TickType_t xTaskGetTickCount()
+{
+  return (TickType_t)millis();
+}
+
+struct NativeQueue
+{
+  std::condition_variable changed;
+  std::deque<std::string> items;
+  size_t length;
+  size_t itemSize;
+};
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+  NativeQueue *queue = new NativeQueue();
+  queue->length = length;
+  queue->itemSize = itemSize;
+  return queue;
+}
+
+template <typename Predicate>
+static bool waitFor(NativeQueue *queue, std::unique_lock<std::mutex> &lock, TickType_t ticksToWait, Predicate ready)
+{
+  if (ticksToWait == portMAX_DELAY)
+  {
+    queue->changed.wait(lock, ready);
+    return true;
+  }
+  return queue->changed.wait_for(lock, std::chrono::milliseconds(ticksToWait), ready);
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticksToWait)
+{
+  std::unique_lock<std::mutex> lock(taskMutex);
+  if (!waitFor(queue, lock, ticksToWait, [queue]() { return queue->items.size() < queue->length; }))
+    return pdFALSE;
+
+  queue->items.emplace_back((const char *)item, queue->itemSize);
+  queue->changed.notify_all();
+  return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticksToWait)
+{
+  NativeTask *task = selfTask();
+  std::unique_lock<std::mutex> lock(taskMutex);
+  task->waiting = true;
+  task->waitQueue = queue;
+  bool received = waitFor(queue, lock, ticksToWait, [queue]() { return !queue->items.empty(); });
+  task->waiting = false;
+  task->waitQueue = nullptr;
+  if (!received)
+    return pdFALSE;
+
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  queue->changed.notify_all();
+  return pdTRUE;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+  std::lock_guard<std::mutex> lock(taskMutex);
+  return (UBaseType_t)queue->items.size();
+}
+
+void nativeWaitForIdle()
+{
+  NativeTask *self = selfTask();
+  for (;;)
+  {
+    {
+      std::lock_guard<std::mutex> lock(taskMutex);
+      bool idle = true;
+      for (NativeTask *task : taskList)
+      {
+        if (task != self && (!task->waiting || task->notifications > 0 ||
+                             (task->waitQueue != nullptr && !task->waitQueue->items.empty())))
+          idle = false;
+      }
+      if (idle)
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+  }
+}
+
+// ================== esp_timer ==================
+struct NativeTimer
+{
+  esp_timer_cb_t callback;
+  void *arg;
+  std::mutex mutex;
+  std::condition_variable changed;
+  bool running = false;
+  bool oneShot = false;
+  uint64_t period = 0;
+  uint32_t generation = 0; // bumped by every start/stop so a sleeping thread notices
+};
+
+static void timerThread(NativeTimer *timer)
+{
+  std::unique_lock<std::mutex> lock(timer->mutex);
+  for (;;)
+  {
+    timer->changed.wait(lock, [timer]() { return timer->running; });
+
+    uint32_t generation = timer->generation;
+    auto next = std::chrono::steady_clock::now() + std::chrono::microseconds(timer->period);
+    while (timer->running && timer->generation == generation)
+    {
+      if (timer->changed.wait_until(lock, next, [timer, generation]() { return timer->generation != generation; }))
+        break;
+
+      // Absolute deadlines, like the real periodic timer: no drift from callback time.
+      // A one-shot timer is disarmed before its callback, which may start it again.
+      if (timer->oneShot)
+        timer->running = false;
+      else
+        next += std::chrono::microseconds(timer->period);
+      lock.unlock();
+      timer->callback(timer->arg);
+      lock.lock();
+    }
+  }
+}
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *handle)
+{
+  NativeTimer *timer = new NativeTimer();
+  timer->callback = args->callback;
+  timer->arg = args->arg;
+  std::thread(timerThread, timer).detach();
+  *handle = timer;
+  return ESP_OK;
+}
+
+static esp_err_t startTimer(esp_timer_handle_t timer, uint64_t period, bool oneShot)
+{
+  std::lock_guard<std::mutex> lock(timer->mutex);
+  if (timer->running)
+    return ESP_ERR_INVALID_STATE;
+  timer->running = true;
+  timer->oneShot = oneShot;
+  timer->period = period;
+  timer->generation++;
+  timer->changed.notify_all();
+  return ESP_OK;
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period)
+{
+  return startTimer(timer, period, false);
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout)
+{
+  return startTimer(timer, timeout, true);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+  std::lock_guard<std::mutex> lock(timer->mutex);
+  if (!timer->running)
+    return ESP_ERR_INVALID_STATE;
+  timer->running = false;
+  timer->generation++;
+  timer->changed.notify_all();
+  return ESP_OK;
+}
+
+int64_t esp_timer_get_time()
+{
+  return (int64_t)micros();
+}
+
+// ================== FastLED ==================
+void CFastLED::show()
+{
+  showCount++;
+  if (showCallback != nullptr && leds != nullptr)
+    showCallback(leds, ledCount, brightness);
+}
+
+// ================== I2S ==================
+#define NATIVE_ADC_MIDSCALE 2048
+
+static std::atomic<NativeAudioSource> audioSource(nullptr);
+static uint32_t i2sSampleRate = 16000;
+static uint16_t i2sChannel = 0;
+static bool i2sRunning = false;
+static std::chrono::steady_clock::time_point i2sNextSample; // when the next sample is captured
+
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten)
+{
+  (void)channel;
+  (void)atten;
+  return ESP_OK;
+}
+
+esp_err_t i2s_driver_install(i2s_port_t port, const i2s_config_t *config, int queueSize, void *queue)
+{
+  (void)port;
+  (void)queueSize;
+  (void)queue;
+  i2sSampleRate = config->sample_rate;
+  return ESP_OK;
+}
+
+esp_err_t i2s_set_adc_mode(adc_unit_t unit, adc1_channel_t channel)
+{
+  (void)unit;
+  i2sChannel = (uint16_t)channel;
+  return ESP_OK;
+}
+
+esp_err_t i2s_adc_enable(i2s_port_t port)
+{
+  (void)port;
+  return ESP_OK;
+}
+
+esp_err_t i2s_adc_disable(i2s_port_t port)
+{
+  (void)port;
+  return ESP_OK;
+}
+
+esp_err_t i2s_start(i2s_port_t port)
+{
+  (void)port;
+  i2sRunning = true;
+  i2sNextSample = std::chrono::steady_clock::now();
+  return ESP_OK;
+}
+
+esp_err_t i2s_stop(i2s_port_t port)
+{
+  (void)port;
+  i2sRunning = false;
+  return ESP_OK;
+}
+
+esp_err_t i2s_zero_dma_buffer(i2s_port_t port)
+{
+  (void)port;
+  return ESP_OK;
+}
+
+esp_err_t i2s_read(i2s_port_t port, void *dest, size_t size, size_t *bytesRead, TickType_t ticksToWait)
+{
+  (void)port;
+  (void)ticksToWait;
+  size_t count = size / sizeof(uint16_t);
+  uint16_t *samples = (uint16_t *)dest;
+  *bytesRead = 0;
+  if (!i2sRunning)
+    return ESP_ERR_INVALID_STATE;
+
+  // Block until the DMA would have captured the last of these samples
+  i2sNextSample += std::chrono::microseconds((uint64_t)count * 1000000 / i2sSampleRate);
+  sleepUntil(i2sNextSample);
+
+  NativeAudioSource source = audioSource.load();
+  if (source != nullptr)
+    source(samples, count);
+  else
+  {
+    for (size_t i = 0; i < count; i++)
+      samples[i] = NATIVE_ADC_MIDSCALE;
+  }
+
+  for (size_t i = 0; i < count; i++)
+    samples[i] = (uint16_t)((i2sChannel << 12) | (samples[i] & 0x0FFF));
+  for (size_t i = 0; i + 1 < count; i += 2)
+    std::swap(samples[i], samples[i + 1]);
+
+  *bytesRead = count * sizeof(uint16_t);
+  return ESP_OK;
+}
+
+void nativeSetAudioSource(NativeAudioSource source)
+{
+  audioSource.store(source);
+}
@@ -0,0 +1,138 @@
+#include <BLEDevice.h>
+
+void BLECharacteristic::simulateWrite(const uint8_t *data, size_t length)
+{
+  value.assign((const char *)data, length);
+  if (callbacks != nullptr)
+    callbacks->onWrite(this);
+}
+
+BLECharacteristic *BLEService::createCharacteristic(const char *charUuid, uint32_t properties)
+{
+  BLECharacteristic *characteristic = new BLECharacteristic(charUuid, properties);
+  characteristics.push_back(characteristic);
+  return characteristic;
+}
+
+BLECharacteristic *BLEService::getCharacteristic(const char *charUuid)
+{
+  for (BLECharacteristic *characteristic : characteristics)
+  {
+    if (strcmp(characteristic->getUUIDString(), charUuid) == 0)
+      return characteristic;
+  }
+  return nullptr;
+}
+
+BLEService *BLEServer::createService(const char *uuid)
+{
+  BLEService *service = new BLEService(uuid);
+  services.push_back(service);
+  return service;
+}
+
+// The host has no attribute table, so the handle budget is not enforced
+BLEService *BLEServer::createService(BLEUUID uuid, uint32_t numHandles, uint8_t instId)
+{
+  (void)numHandles;
+  (void)instId;
+  return createService(uuid.toString().c_str());
+}
+
+BLECharacteristic *BLEServer::findCharacteristic(const char *charUuid)
+{
+  for (BLEService *service : services)
+  {
+    BLECharacteristic *characteristic = service->getCharacteristic(charUuid);
+    if (characteristic != nullptr)
+      return characteristic;
+  }
+  return nullptr;
+}
+
+static uint16_t localMtu = 23;
+static gap_event_handler customGapHandler = nullptr;
+
+void BLEServer::simulateConnect()
+{
+  connectedCount++;
+  advertising = false;
+  if (callbacks != nullptr)
+  {
+    // Same order as the ESP32 library: plain overload first, then with the GATT parameters
+    esp_ble_gatts_cb_param_t param = {};
+    param.connect.conn_id = 0;
+    for (int i = 0; i < 6; i++)
+      param.connect.remote_bda[i] = (uint8_t)(0x10 + i);
+    callbacks->onConnect(this);
+    callbacks->onConnect(this, &param);
+  }
+}
+
+void BLEServer::simulateMtu(uint16_t mtu)
+{
+  esp_ble_gatts_cb_param_t param = {};
+  param.mtu.mtu = mtu < localMtu ? mtu : localMtu;
+  if (callbacks != nullptr)
+    callbacks->onMtuChanged(this, &param);
+}
+
+void BLEServer::updateConnParams(esp_bd_addr_t remote_bda, uint16_t minInterval, uint16_t maxInterval,
+                                 uint16_t latency, uint16_t timeout)
+{
+  if (customGapHandler == nullptr)
+    return;
+
+  esp_ble_gap_cb_param_t param = {};
+  param.update_conn_params.status = ESP_BT_STATUS_SUCCESS;
+  memcpy(param.update_conn_params.bda, remote_bda, sizeof(esp_bd_addr_t));
+  param.update_conn_params.min_int = minInterval;
+  param.update_conn_params.max_int = maxInterval;
+  param.update_conn_params.latency = latency;
+  param.update_conn_params.conn_int = maxInterval;
+  param.update_conn_params.timeout = timeout;
+  customGapHandler(ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT, &param);
+}
+
+void BLEServer::simulateDisconnect()
+{
+  if (connectedCount > 0)
+    connectedCount--;
+  if (callbacks != nullptr)
+    callbacks->onDisconnect(this);
+}
+
+static BLEServer *nativeServer = nullptr;
+
+BLEServer *BLEDevice::createServer()
+{
+  nativeServer = new BLEServer();
+  return nativeServer;
+}
+
+BLEAdvertising *BLEDevice::getAdvertising()
+{
+  static BLEAdvertising advertising;
+  return &advertising;
+}
+
+void BLEDevice::setMTU(uint16_t mtu)
+{
+  localMtu = mtu;
+}
+
+uint16_t BLEDevice::getMTU()
+{
+  return localMtu;
+}
+
+void BLEDevice::setCustomGapHandler(gap_event_handler handler)
+{
+  customGapHandler = handler;
+}
+
+void BLEDevice::startAdvertising()
+{
+  if (nativeServer != nullptr)
+    nativeServer->startAdvertising();
+}
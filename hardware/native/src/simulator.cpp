@@ -0,0 +1,1431 @@
+// Fretboard simulator: runs the firmware's setup() on the host, feeds BLE writes
+// from a script on stdin and draws every LED push as a fretboard in the terminal.
+//
+// Usage: simulator [--serial] [--plain] [--ppm-dir DIR] < script
+//        simulator --power-report DIR [--budget MA]
+//        simulator --touch-trace FILE
+//        simulator --tuner-wav FILE [--expect HZ]
+//        simulator --chord-wav FILE [--chord ROOT:TYPE]
+//        simulator --click-bench
+//        simulator --voicings ROOT:TYPE|all [--tuning PRESET] [--capo FRET]
+//   --serial        echo the firmware's Serial output to stderr
+//   --plain         draw with letters instead of ANSI 24-bit colour
+//   --ppm-dir       also write every pushed frame as DIR/frame_NNNN.ppm
+//   --power-report  instead of running a script, draw every chord and scale in
+//                   DIR/chords.json and DIR/scales.json (the app's assets/data)
+//                   and print the estimated LED current of each as JSON, for
+//                   the FRETBOARD_* layout this was built for (led_power.h)
+//   --budget        milliamp budget for the report (default LED_POWER_BUDGET_MA)
+//   --touch-trace   instead of running a script, feed a sensor trace through the
+//                   touch scan processing and print every change of the pressed
+//                   mask and the time per scan (format below)
+//   --tuner-wav     instead of running a script, run a WAV file (16-bit PCM, any
+//                   rate, first channel) through the tuner's pitch analysis and
+//                   print every reading, the time per block and, with --expect,
+//                   the error against the true frequency in cents
+//   --chord-wav     instead of running a script, run a WAV file through the
+//                   chord listening analysis and print every strum's score and
+//                   the throughput in blocks per second
+//   --chord         chord to score against, note name and chordCatalogue name,
+//                   e.g. C:Major or "F#:Minor 7" (default: none, score 0)
+//   --click-bench   instead of running a script, run synthetic click tracks with
+//                   known onset times through the onset detector and print the
+//                   detection rate, timestamp error and jitter, and how long
+//                   after each onset it was detected
+//   --voicings      instead of running a script, solve the voicings of a chord
+//                   (as --chord) and print them with the search nodes and time,
+//                   or with "all" time a cold solve of every chord and a cached
+//                   lookup
+//   --tuning        TuningPreset for --voicings (default standard)
+//   --capo          capo fret for --voicings (default none)
+//
+// Script commands, one per line ('#' starts a comment):
+//   connect | disconnect        drive the BLE server callbacks
+//   mtu <bytes>                 central-initiated MTU exchange
+//   link                        print the link parameters characteristic
+//   chord <text>                write text to the chord characteristic, e.g. chord [-1, 3, 2, 0, 1, 0]
+//   scale <text>                write text to the scale characteristic, e.g. scale [[1, 3], [2, 0]]
+//   shape <root> <type> [<voicing>]
+//                               write a binary shape frame (type: ScaleId or 0x80 | ChordId)
+//   fast <seq> <op> <bytes ...> write a sequenced frame (hex opcode and payload) to the fast path
+//   seq <bytes ...>             write a sequencer frame (hex payload: op, args), see sequencer.h
+//   fx <bytes ...>              write an effects frame (hex payload: op, args), see effects.h
+//   listen <mode> [<argument>]  write an audio frame selecting an AudioMode, see audio_input.h
+//   tune <preset> <capo> [<midi> x6]
+//                               write a tuning frame: a TuningPreset, or 255 and the open-string
+//                               MIDI notes, see guitar_tuning.h
+//   audio [<file.wav>]          play a WAV file into the audio input; no argument: silence
+//   hex <uuid> <bytes ...>      write raw hex bytes to any characteristic
+//   wait <ms>                   let the board run for a while (sequencer playback)
+//   ppm <file>                  save the current strip as a PPM image
+//   stats                       print LED push counters
+//   status                      print the connection status LEDs and advertising state
+//   events                      wait for the next event batch and print every notified event
+//   touch [<cell>=<signal> ...] hold fingers on the touch pads (cell = fret * 6 + string); no
+//                               arguments lifts them all. Scanning runs while connected.
+//
+// Touch trace lines, one scan per "raw" line or several per "hold" line:
+//   raw <reading> ...           a recorded scan: one touch pad reading per cell
+//   hold <scans> [<cell>=<signal> ...]
+//                               synthetic scans: every cell reads the idle level plus noise and
+//                               drift, the listed ones <signal> lower
+//   noise <counts>              synthetic noise, uniform in +-counts (default 0)
+//   drift <counts>              idle level change per 1000 scans (default 0)
+//   seed <n>                    noise seed
+
+#include <Arduino.h>
+#include <FastLED.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <driver/i2s.h>
+#include <driver/touch_pad.h>
+#include "main.h"
+#include "bluetooth.h"
+#include "ble_protocol.h"
+#include "frame_buffer.h"
+#include "event_stream.h"
+#include "command_queue.h"
+#include "led_power.h"
+#include "pixel_mapping.h"
+#include "touch_sensing.h"
+#include "chord_check.h"
+#include "audio_input.h"
+#include "tuner.h"
+#include "chord_listen.h"
+#include "onset_detect.h"
+#include "chord_voicing.h"
+#include "guitar_tuning.h"
+#include "scale_and_chord_notes.h"
+
+void setup();
+
+#define PPM_CELL_PIXELS 16
+#define TOUCH_IDLE_READING 400 // untouched pad, as the native touch driver default
+
+static bool plainOutput = false;
+static const char *ppmDirectory = nullptr;
+static uint32_t frameNumber = 0;
+static std::atomic<int> touchSignal[FRETBOARD_CELLS]; // live "touch" command, read by the touch task
+
+static char colorLetter(const CRGB &color)
+{
+  if (color == CRGB(CRGB::Black))
+    return '.';
+  if (color == CRGB(CRGB::Red))
+    return 'R';
+  if (color == CRGB(CRGB::Green))
+    return 'G';
+  if (color == CRGB(CRGB::Blue))
+    return 'B';
+  if (color == CRGB(CRGB::Purple))
+    return 'P';
+  if (color == CRGB(CRGB::White))
+    return 'W';
+  if (color == CRGB(CHECK_COLOR_MISSING))
+    return 'O';
+  if (color == CRGB(TUNER_COLOR_CENTRE))
+    return ':';
+  return '*';
+}
+
+// Draw the neck with the nut at the top: one row per fret, one column per string
+static void printFretboard(const CRGB *strip)
+{
+  printf("     ");
+  for (int string = 0; string < NUM_STRINGS; string++)
+    printf(" S%d", string);
+  printf("\n");
+
+  for (int fret = 0; fret < FRETBOARD_FRETS; fret++)
+  {
+    printf("F%-3d ", fret);
+    for (int string = 0; string < NUM_STRINGS; string++)
+    {
+      const CRGB &color = strip[fretLEDs[fret * NUM_STRINGS + string]];
+      if (plainOutput)
+        printf("  %c", colorLetter(color));
+      else
+        printf(" \x1b[48;2;%d;%d;%dm  \x1b[0m", color.r, color.g, color.b);
+    }
+    printf("\n");
+  }
+  fflush(stdout);
+}
+
+static bool writePpm(const char *path, const CRGB *strip)
+{
+  FILE *file = fopen(path, "wb");
+  if (file == nullptr)
+  {
+    fprintf(stderr, "cannot write %s\n", path);
+    return false;
+  }
+
+  int width = NUM_STRINGS * PPM_CELL_PIXELS;
+  int height = FRETBOARD_FRETS * PPM_CELL_PIXELS;
+  fprintf(file, "P6\n%d %d\n255\n", width, height);
+  for (int y = 0; y < height; y++)
+  {
+    for (int x = 0; x < width; x++)
+    {
+      const CRGB &color = strip[fretLEDs[(y / PPM_CELL_PIXELS) * NUM_STRINGS + x / PPM_CELL_PIXELS]];
+      uint8_t pixel[3] = {color.r, color.g, color.b};
+      // One-pixel dark border between cells so the grid stays readable
+      if (x % PPM_CELL_PIXELS == 0 || y % PPM_CELL_PIXELS == 0)
+        pixel[0] = pixel[1] = pixel[2] = 24;
+      fwrite(pixel, 1, 3, file);
+    }
+  }
+  fclose(file);
+  return true;
+}
+
+static void onShow(const CRGB *strip, int count, uint8_t brightness)
+{
+  (void)count;
+  frameNumber++;
+  printf("-- frame %u (brightness %u) --\n", (unsigned)frameNumber, (unsigned)brightness);
+  printFretboard(strip);
+
+  if (ppmDirectory != nullptr)
+  {
+    char path[512];
+    snprintf(path, sizeof(path), "%s/frame_%04u.ppm", ppmDirectory, (unsigned)frameNumber);
+    writePpm(path, strip);
+  }
+}
+
+static void writeFrame(BLECharacteristic *characteristic, const uint8_t *payload, size_t length, uint8_t opcode)
+{
+  uint8_t frame[FRAME_OVERHEAD + FRAME_MAX_PAYLOAD];
+  frame[0] = FRAME_HEADER;
+  frame[1] = opcode;
+  frame[2] = (uint8_t)length;
+  memcpy(frame + 3, payload, length);
+  frame[3 + length] = frameCrc8(frame, 3 + length);
+  characteristic->simulateWrite(frame, length + FRAME_OVERHEAD);
+}
+
+static uint32_t readU32(const uint8_t *data)
+{
+  return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+// "C E G" for a pitch-class set, "-" if empty
+static std::string pitchClassNames(uint16_t set)
+{
+  std::string names;
+  for (int pitchClass = 0; pitchClass < 12; pitchClass++)
+  {
+    if (!pitchSetHas(set, pitchClass))
+      continue;
+    if (!names.empty())
+      names += ' ';
+    names += noteNames[pitchClass];
+  }
+  return names.empty() ? "-" : names;
+}
+
+// Decode every notification sent on the event characteristic since the last call
+static void printEvents()
+{
+  delay(2 * EVENT_BATCH_INTERVAL_MS);
+  nativeWaitForIdle();
+
+  for (const std::string &value : pEventCharacteristic->notifications)
+  {
+    FrameView frame;
+    if (!decodeFrame((const uint8_t *)value.data(), value.size(), &frame) || frame.opcode != FRAME_OP_EVENTS)
+    {
+      printf("event: bad frame (%u bytes)\n", (unsigned)value.size());
+      continue;
+    }
+
+    const uint8_t *event = frame.payload;
+    const uint8_t *end = frame.payload + frame.length;
+    while (event < end)
+    {
+      switch (event[0])
+      {
+      case EVENT_RENDER_COMPLETE:
+        printf("event: render complete, command %u, superseded %u, latency %u us\n", event[1], event[2],
+               (unsigned)readU32(event + 3));
+        event += 7;
+        break;
+      case EVENT_COMMAND_REJECTED:
+        printf("event: rejected, source %u, reason %u\n", event[1], event[2]);
+        event += 3;
+        break;
+      case EVENT_STATS:
+        printf("event: stats, heap %u, pushes/s %u, dropped %u, effects load %u.%02u%%\n",
+               (unsigned)readU32(event + 1), event[5] | (event[6] << 8), event[7] | (event[8] << 8),
+               (event[9] | (event[10] << 8)) / 100, (event[9] | (event[10] << 8)) % 100);
+        event += 11;
+        break;
+      case EVENT_TOUCH:
+        printf("event: touch, frets");
+        for (int string = 0; string < NUM_STRINGS; string++)
+        {
+          if (event[1 + string] == 0xFF)
+            printf(" x");
+          else
+            printf(" %u", event[1 + string]);
+        }
+        printf(", %u cells pressed\n", event[1 + NUM_STRINGS]);
+        event += 2 + NUM_STRINGS;
+        break;
+      case EVENT_SEQUENCE_APPLIED:
+        printf("event: sequence applied %u\n", event[1] | (event[2] << 8));
+        event += 3;
+        break;
+      case EVENT_SEQUENCE_STEP:
+        printf("event: sequence step %u\n", event[1] | (event[2] << 8));
+        event += 3;
+        break;
+      case EVENT_POWER:
+        printf("event: power mode %u, max wake-to-render %u us, LED peak %u mA, brightness %u\n", event[1],
+               (unsigned)readU32(event + 2), event[6] | (event[7] << 8), event[8]);
+        event += 9;
+        break;
+      case EVENT_TUNER:
+        if (event[1] == TUNER_NO_STRING)
+          printf("event: tuner, no note\n");
+        else
+          printf("event: tuner, string %u, %+d cents, %u.%u Hz, clarity %u%%\n", event[1],
+                 (int16_t)(event[2] | (event[3] << 8)), (event[4] | (event[5] << 8)) / 10,
+                 (event[4] | (event[5] << 8)) % 10, event[6]);
+        event += 7;
+        break;
+      case EVENT_CHORD_MATCH:
+        printf("event: chord match %u%%, heard %s, chord %s, %u ms\n", event[1],
+               pitchClassNames(event[2] | (event[3] << 8)).c_str(), pitchClassNames(event[4] | (event[5] << 8)).c_str(),
+               event[6]);
+        event += 7;
+        break;
+      case EVENT_STRUM_TIMING:
+        printf("event: strum on beat %u.%u, %+d ms\n", event[1] | (event[2] << 8), event[3],
+               (int16_t)(event[4] | (event[5] << 8)));
+        event += 6;
+        break;
+      case EVENT_CHORD_CHECK:
+        printf("event: chord check %s, %u/%u fingers, %u wrong, %u ms\n",
+               event[1] == CHECK_CORRECT ? "correct" : event[1] == CHECK_MISSED ? "missed" : "progress", event[2],
+               event[3], event[4], event[5] | (event[6] << 8));
+        event += 7;
+        break;
+      default:
+        printf("event: unknown type %u\n", event[0]);
+        event = end;
+        break;
+      }
+    }
+  }
+  pEventCharacteristic->notifications.clear();
+}
+
+// Read whitespace-separated hex bytes. Returns how many were stored.
+static size_t parseHex(const char *cursor, uint8_t *out, size_t capacity)
+{
+  size_t length = 0;
+  unsigned value;
+  int consumed;
+  while (length < capacity && sscanf(cursor, "%x%n", &value, &consumed) == 1)
+  {
+    out[length++] = (uint8_t)value;
+    cursor += consumed;
+  }
+  return length;
+}
+
+// Read "<cell>=<signal>" pairs into a per-cell signal array
+static bool parseTouchCells(std::istringstream &in, int *signal)
+{
+  std::string pair;
+  while (in >> pair)
+  {
+    int cell;
+    int value;
+    if (sscanf(pair.c_str(), "%d=%d", &cell, &value) != 2 || cell < 0 || cell >= FRETBOARD_CELLS)
+      return false;
+    signal[cell] = value;
+  }
+  return true;
+}
+
+// Touch measurements for the live simulation: the row comes from the mux address pins
+static uint16_t readTouchPad(touch_pad_t pad)
+{
+  static const uint8_t stringPads[NUM_STRINGS] = TOUCH_STRING_PADS;
+  static const uint8_t rowPins[TOUCH_ROW_BITS] = TOUCH_ROW_PINS;
+
+  int fret = 0;
+  for (int bit = 0; bit < TOUCH_ROW_BITS; bit++)
+    fret |= digitalRead(rowPins[bit]) << bit;
+  for (int string = 0; string < NUM_STRINGS; string++)
+  {
+    if (stringPads[string] == pad && fret < FRETBOARD_FRETS)
+      return (uint16_t)(TOUCH_IDLE_READING - touchSignal[fret * NUM_STRINGS + string].load());
+  }
+  return TOUCH_IDLE_READING;
+}
+
+// ================== Audio ==================
+// A WAV file as 12-bit signed samples at AUDIO_SAMPLE_RATE: first channel of
+// 16-bit PCM, resampled by linear interpolation if recorded at another rate
+static bool loadWav(const char *path, std::vector<int16_t> &samples)
+{
+  FILE *file = fopen(path, "rb");
+  if (file == nullptr)
+  {
+    fprintf(stderr, "cannot read %s\n", path);
+    return false;
+  }
+  std::vector<uint8_t> data;
+  uint8_t chunk[4096];
+  size_t got;
+  while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    data.insert(data.end(), chunk, chunk + got);
+  fclose(file);
+
+  auto u16 = [&](size_t at) { return (uint32_t)(data[at] | (data[at + 1] << 8)); };
+  auto u32 = [&](size_t at) { return u16(at) | (u16(at + 2) << 16); };
+  if (data.size() < 12 || memcmp(data.data(), "RIFF", 4) != 0 || memcmp(data.data() + 8, "WAVE", 4) != 0)
+  {
+    fprintf(stderr, "%s: not a WAV file\n", path);
+    return false;
+  }
+
+  uint32_t rate = 0;
+  uint32_t channels = 0;
+  uint32_t bits = 0;
+  for (size_t at = 12; at + 8 <= data.size();)
+  {
+    uint32_t size = u32(at + 4);
+    size_t body = at + 8;
+    if (memcmp(data.data() + at, "fmt ", 4) == 0 && size >= 16 && body + 16 <= data.size())
+    {
+      channels = u16(body + 2);
+      rate = u32(body + 4);
+      bits = u16(body + 14);
+      if (u16(body) != 1 || bits != 16 || channels == 0)
+      {
+        fprintf(stderr, "%s: only 16-bit PCM is supported\n", path);
+        return false;
+      }
+    }
+    else if (memcmp(data.data() + at, "data", 4) == 0 && rate != 0)
+    {
+      size_t frames = std::min<size_t>(size, data.size() - body) / (2 * channels);
+      std::vector<int16_t> input(frames);
+      for (size_t i = 0; i < frames; i++)
+        input[i] = (int16_t)u16(body + i * 2 * channels);
+
+      size_t count = (size_t)((uint64_t)frames * AUDIO_SAMPLE_RATE / rate);
+      samples.resize(count);
+      for (size_t i = 0; i < count; i++)
+      {
+        double position = (double)i * rate / AUDIO_SAMPLE_RATE;
+        size_t index = (size_t)position;
+        double fraction = position - index;
+        double next = index + 1 < frames ? input[index + 1] : input[index];
+        samples[i] = (int16_t)lround((input[index] * (1 - fraction) + next * fraction) / 16);
+      }
+      return true;
+    }
+    at = body + size + (size & 1);
+  }
+  fprintf(stderr, "%s: no audio data\n", path);
+  return false;
+}
+
+// What the native I2S driver reads while the "audio" command plays
+static std::mutex playbackMutex;
+static std::vector<int16_t> playback;
+static size_t playbackPosition = 0;
+
+static void readAudioInput(uint16_t *samples, size_t count)
+{
+  std::lock_guard<std::mutex> lock(playbackMutex);
+  for (size_t i = 0; i < count; i++, playbackPosition++)
+    samples[i] = (uint16_t)(2048 + (playbackPosition < playback.size() ? playback[playbackPosition] : 0));
+}
+
+static bool runCommand(const std::string &line)
+{
+  size_t split = line.find(' ');
+  std::string command = line.substr(0, split);
+  std::string argument = (split == std::string::npos) ? "" : line.substr(split + 1);
+
+  if (command == "connect")
+  {
+    pServer->simulateConnect();
+  }
+  else if (command == "disconnect")
+  {
+    pServer->simulateDisconnect();
+  }
+  else if (command == "chord")
+  {
+    pChordPixelCharacteristic->simulateWrite((const uint8_t *)argument.data(), argument.size());
+  }
+  else if (command == "scale")
+  {
+    pScalePixelCharacteristic->simulateWrite((const uint8_t *)argument.data(), argument.size());
+  }
+  else if (command == "shape")
+  {
+    unsigned root = 0;
+    unsigned type = 0;
+    unsigned voicing = 0;
+    int fields = sscanf(argument.c_str(), "%u %i %u", &root, &type, &voicing);
+    if (fields < 2)
+      return false;
+    uint8_t payload[3] = {(uint8_t)root, (uint8_t)type, (uint8_t)voicing};
+    writeFrame(pChordPixelCharacteristic, payload, fields, FRAME_OP_SHAPE);
+  }
+  else if (command == "fast")
+  {
+    const char *cursor = argument.c_str();
+    unsigned sequence;
+    unsigned opcode;
+    int consumed;
+    if (sscanf(cursor, "%u %x%n", &sequence, &opcode, &consumed) != 2)
+      return false;
+
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    size_t length = parseHex(cursor + consumed, payload, sizeof(payload));
+
+    uint8_t bytes[2 + FRAME_OVERHEAD + FRAME_MAX_PAYLOAD] = {(uint8_t)sequence, (uint8_t)(sequence >> 8)};
+    size_t frameLength = encodeFrame((uint8_t)opcode, payload, length, bytes + 2);
+    pFastPixelCharacteristic->simulateWrite(bytes, 2 + frameLength);
+  }
+  else if (command == "seq")
+  {
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    size_t length = parseHex(argument.c_str(), payload, sizeof(payload));
+    writeFrame(pSequenceCharacteristic, payload, length, FRAME_OP_SEQUENCE);
+  }
+  else if (command == "fx")
+  {
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+    size_t length = parseHex(argument.c_str(), payload, sizeof(payload));
+    writeFrame(pSequenceCharacteristic, payload, length, FRAME_OP_EFFECTS);
+  }
+  else if (command == "listen")
+  {
+    unsigned mode = 0;
+    unsigned modeArgument = 0;
+    int fields = sscanf(argument.c_str(), "%u %u", &mode, &modeArgument);
+    uint8_t payload[2] = {(uint8_t)mode, (uint8_t)modeArgument};
+    writeFrame(pSequenceCharacteristic, payload, fields == 2 ? 2 : 1, FRAME_OP_AUDIO);
+  }
+  else if (command == "tune")
+  {
+    unsigned values[2 + NUM_STRINGS];
+    int fields = sscanf(argument.c_str(), "%u %u %u %u %u %u %u %u", &values[0], &values[1], &values[2], &values[3],
+                        &values[4], &values[5], &values[6], &values[7]);
+    if (fields < 2)
+      return false;
+    uint8_t payload[2 + NUM_STRINGS];
+    for (int i = 0; i < fields; i++)
+      payload[i] = (uint8_t)values[i];
+    writeFrame(pSequenceCharacteristic, payload, fields, FRAME_OP_TUNING);
+  }
+  else if (command == "audio")
+  {
+    std::vector<int16_t> samples;
+    if (!argument.empty() && !loadWav(argument.c_str(), samples))
+      return false;
+    std::lock_guard<std::mutex> lock(playbackMutex);
+    playback.swap(samples);
+    playbackPosition = 0;
+  }
+  else if (command == "wait")
+  {
+    delay(atoi(argument.c_str()));
+  }
+  else if (command == "hex")
+  {
+    size_t uuidEnd = argument.find(' ');
+    BLECharacteristic *characteristic = pServer->findCharacteristic(argument.substr(0, uuidEnd).c_str());
+    if (characteristic == nullptr)
+      return false;
+
+    uint8_t bytes[512];
+    size_t length = parseHex((uuidEnd == std::string::npos) ? "" : argument.c_str() + uuidEnd, bytes, sizeof(bytes));
+    characteristic->simulateWrite(bytes, length);
+  }
+  else if (command == "ppm")
+  {
+    return writePpm(argument.c_str(), leds);
+  }
+  else if (command == "stats")
+  {
+    FrameStats stats = getFrameStats();
+    printf("pushes issued: %u, skipped: %u, dither refreshes: %u\n", (unsigned)stats.pushesIssued,
+           (unsigned)stats.pushesSkipped, (unsigned)stats.refreshes);
+  }
+  else if (command == "status")
+  {
+    printf("status: connected led %d, disconnected led %d, advertising %d\n", digitalRead(BL_CONNECTED_PIN),
+           digitalRead(BL_DISCONNECTED_PIN), pServer->isAdvertising() ? 1 : 0);
+  }
+  else if (command == "mtu")
+  {
+    pServer->simulateMtu((uint16_t)atoi(argument.c_str()));
+  }
+  else if (command == "link")
+  {
+    std::string value = pLinkCharacteristic->getValue();
+    FrameView frame;
+    if (!decodeFrame((const uint8_t *)value.data(), value.size(), &frame) || frame.opcode != FRAME_OP_LINK)
+      return false;
+    const uint8_t *p = frame.payload;
+    printf("link: mtu %u, interval %u, latency %u, timeout %u, phy %u/%u, %s\n", p[0] | (p[1] << 8),
+           p[2] | (p[3] << 8), p[4] | (p[5] << 8), p[6] | (p[7] << 8), p[8], p[9], p[10] ? "active" : "idle");
+  }
+  else if (command == "events")
+  {
+    printEvents();
+  }
+  else if (command == "touch")
+  {
+    int signal[FRETBOARD_CELLS] = {0};
+    std::istringstream in(argument);
+    if (!parseTouchCells(in, signal))
+      return false;
+    for (int cell = 0; cell < FRETBOARD_CELLS; cell++)
+      touchSignal[cell].store(signal[cell]);
+    // Long enough for calibration and debouncing at the scan rate
+    delay((TOUCH_DEBOUNCE_SCANS + 2) * TOUCH_SCAN_PERIOD_US / 1000);
+  }
+  else
+  {
+    return false;
+  }
+  return true;
+}
+
+// ================== Power Report ==================
+// Just enough JSON for the app's data files: objects keep their key order
+struct JsonValue
+{
+  enum Kind
+  {
+    NUMBER,
+    STRING,
+    ARRAY,
+    OBJECT,
+    LITERAL // true, false, null
+  } kind = LITERAL;
+  double number = 0;
+  std::string text;
+  std::vector<std::string> keys; // OBJECT: keys[i] names items[i]
+  std::vector<JsonValue> items;
+
+  const JsonValue *find(const char *key) const
+  {
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+      if (keys[i] == key)
+        return &items[i];
+    }
+    return nullptr;
+  }
+};
+
+static void skipSpace(const char *&cursor)
+{
+  while (*cursor == ' ' || *cursor == '\n' || *cursor == '\r' || *cursor == '\t')
+    cursor++;
+}
+
+static bool parseJson(const char *&cursor, JsonValue &value)
+{
+  skipSpace(cursor);
+  if (*cursor == '{' || *cursor == '[')
+  {
+    bool object = *cursor++ == '{';
+    value.kind = object ? JsonValue::OBJECT : JsonValue::ARRAY;
+    skipSpace(cursor);
+    if (*cursor == (object ? '}' : ']'))
+    {
+      cursor++;
+      return true;
+    }
+    for (;;)
+    {
+      if (object)
+      {
+        JsonValue key;
+        if (!parseJson(cursor, key) || key.kind != JsonValue::STRING)
+          return false;
+        skipSpace(cursor);
+        if (*cursor++ != ':')
+          return false;
+        value.keys.push_back(key.text);
+      }
+      value.items.emplace_back();
+      if (!parseJson(cursor, value.items.back()))
+        return false;
+      skipSpace(cursor);
+      if (*cursor == ',')
+        cursor++;
+      else
+        return *cursor++ == (object ? '}' : ']');
+    }
+  }
+  if (*cursor == '"')
+  {
+    value.kind = JsonValue::STRING;
+    for (cursor++; *cursor != '"'; cursor++)
+    {
+      if (*cursor == '\0')
+        return false;
+      if (*cursor == '\\' && cursor[1] != '\0')
+        cursor++; // names and notes only; keep escapes as the plain character
+      value.text += *cursor;
+    }
+    cursor++;
+    return true;
+  }
+
+  char *end;
+  value.number = strtod(cursor, &end);
+  if (end != cursor)
+  {
+    value.kind = JsonValue::NUMBER;
+    cursor = end;
+    return true;
+  }
+  const char *start = cursor;
+  while (*cursor >= 'a' && *cursor <= 'z')
+    cursor++;
+  return cursor != start;
+}
+
+static bool loadJson(const std::string &path, JsonValue &root)
+{
+  FILE *file = fopen(path.c_str(), "rb");
+  if (file == nullptr)
+  {
+    fprintf(stderr, "cannot read %s\n", path.c_str());
+    return false;
+  }
+  std::string text;
+  char chunk[4096];
+  size_t length;
+  while ((length = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    text.append(chunk, length);
+  fclose(file);
+
+  const char *cursor = text.c_str();
+  if (!parseJson(cursor, root) || root.kind != JsonValue::OBJECT)
+  {
+    fprintf(stderr, "%s: not a JSON object\n", path.c_str());
+    return false;
+  }
+  return true;
+}
+
+struct PowerFigure
+{
+  std::string name;
+  uint32_t fullMa; // at brightness 255, no budget
+  uint32_t activeMa; // at LED_BRIGHTNESS_ACTIVE, no budget
+  uint32_t ma; // as the board would push it
+  uint8_t brightness;
+};
+
+// Estimate the frame in backBuffer and print it as one report entry
+static PowerFigure measureFrame(const std::string &name, uint32_t budgetMa, bool first)
+{
+  PowerFigure figure;
+  figure.name = name;
+  figure.fullMa = estimateStripCurrent(backBuffer, 255);
+  figure.activeMa = estimateStripCurrent(backBuffer, LED_BRIGHTNESS_ACTIVE);
+  figure.brightness = fitBrightness(backBuffer, LED_BRIGHTNESS_ACTIVE, budgetMa);
+  figure.ma = estimateStripCurrent(backBuffer, figure.brightness);
+
+  int lit = 0;
+  for (int cell = 0; cell < VALID_LEDS; cell++)
+  {
+    if (backBuffer[fretLEDs[cell]] != CRGB(CRGB::Black))
+      lit++;
+  }
+  printf("%s\n    {\"name\": \"%s\", \"lit\": %d, \"full_ma\": %u, \"active_ma\": %u, \"ma\": %u, \"brightness\": %u}",
+         first ? "" : ",", name.c_str(), lit, (unsigned)figure.fullMa, (unsigned)figure.activeMa,
+         (unsigned)figure.ma, (unsigned)figure.brightness);
+  return figure;
+}
+
+// Draw every entry of one data file, as the converters would for the app's
+// commands. Tracks the entry that draws most at active brightness.
+static bool reportFile(const JsonValue &root, bool chords, uint32_t budgetMa, PowerFigure &worst)
+{
+  printf("  \"%s\": [", chords ? "chords" : "scales");
+  bool first = true;
+  for (size_t group = 0; group < root.items.size(); group++)
+  {
+    const JsonValue &entries = root.items[group];
+    for (size_t entry = 0; entry < entries.items.size(); entry++)
+    {
+      std::string name = root.keys[group] + "/" + entries.keys[entry];
+      const JsonValue *positions = entries.items[entry].find(chords ? "fret_num" : "positions");
+      if (positions == nullptr || positions->kind != JsonValue::ARRAY)
+      {
+        fprintf(stderr, "%s: no %s\n", name.c_str(), chords ? "fret_num" : "positions");
+        return false;
+      }
+
+      clearGrid();
+      if (chords)
+      {
+        int frets[6] = {0};
+        int pixels[6];
+        for (size_t i = 0; i < positions->items.size() && i < 6; i++)
+          frets[i] = (int)positions->items[i].number;
+        convertChordPositionsToPixels(frets, pixels);
+      }
+      else
+      {
+        int scaleData[MAX_SCALE_PAIRS][2];
+        int count = 0;
+        for (const JsonValue &pair : positions->items)
+        {
+          if (count == MAX_SCALE_PAIRS || pair.items.size() != 2)
+            break;
+          scaleData[count][0] = (int)pair.items[0].number;
+          scaleData[count][1] = (int)pair.items[1].number;
+          count++;
+        }
+        convertScalePositionsToPixels(scaleData, count);
+      }
+
+      PowerFigure figure = measureFrame(name, budgetMa, first);
+      if (figure.activeMa > worst.activeMa)
+      {
+        worst = figure;
+        worst.name = (chords ? "chord " : "scale ") + name;
+      }
+      first = false;
+    }
+  }
+  printf("\n  ],\n");
+  return true;
+}
+
+static int runPowerReport(const std::string &directory, uint32_t budgetMa)
+{
+  JsonValue chords;
+  JsonValue scales;
+  if (!loadJson(directory + "/chords.json", chords) || !loadJson(directory + "/scales.json", scales))
+    return 1;
+
+  printf("{\n  \"layout\": {\"frets\": %d, \"strings\": %d, \"leds\": %d},\n", FRETBOARD_FRETS, NUM_STRINGS, NUM_LEDS);
+  printf("  \"budget_ma\": %u,\n  \"active_brightness\": %d,\n", (unsigned)budgetMa, LED_BRIGHTNESS_ACTIVE);
+
+  PowerFigure worst = {"", 0, 0, 0, 0};
+  if (!reportFile(chords, true, budgetMa, worst) || !reportFile(scales, false, budgetMa, worst))
+    return 1;
+
+  printf("  \"worst\": {\"name\": \"%s\", \"active_ma\": %u, \"ma\": %u, \"brightness\": %u}\n}\n",
+         worst.name.c_str(), (unsigned)worst.activeMa, (unsigned)worst.ma, (unsigned)worst.brightness);
+  return 0;
+}
+
+// ================== Touch Trace ==================
+static void printPressed(uint32_t scan, const CellMask &pressed)
+{
+  printf("scan %u (%.1f ms): pressed", (unsigned)scan, scan * TOUCH_SCAN_PERIOD_US / 1000.0);
+  bool any = false;
+  for (int cell = 0; cell < FRETBOARD_CELLS; cell++)
+  {
+    if (cellMaskTest(pressed, cell))
+    {
+      printf(" %d (string %d, fret %d)", cell, cell % NUM_STRINGS, cell / NUM_STRINGS);
+      any = true;
+    }
+  }
+  printf("%s\n", any ? "" : " none");
+}
+
+static int runTouchTrace(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  if (file == nullptr)
+  {
+    fprintf(stderr, "cannot read %s\n", path);
+    return 1;
+  }
+
+  TouchScanner *scanner = new TouchScanner;
+  touchScannerReset(*scanner);
+  uint16_t readings[FRETBOARD_CELLS];
+  int noise = 0;
+  double drift = 0;
+  uint32_t random = 1;
+  uint32_t changes = 0;
+  std::chrono::nanoseconds busy(0);
+
+  auto feed = [&]() {
+    auto start = std::chrono::steady_clock::now();
+    bool changed = touchScannerUpdate(*scanner, readings);
+    busy += std::chrono::steady_clock::now() - start;
+    if (changed)
+    {
+      changes++;
+      printPressed(scanner->scans, scanner->pressed);
+    }
+  };
+
+  char buffer[4096];
+  int lineNumber = 0;
+  while (fgets(buffer, sizeof(buffer), file) != nullptr)
+  {
+    lineNumber++;
+    std::istringstream in(buffer);
+    std::string directive;
+    if (!(in >> directive) || directive[0] == '#')
+      continue;
+
+    bool ok = true;
+    if (directive == "raw")
+    {
+      for (int cell = 0; cell < FRETBOARD_CELLS && ok; cell++)
+      {
+        unsigned value;
+        ok = static_cast<bool>(in >> value);
+        readings[cell] = (uint16_t)value;
+      }
+      if (ok)
+        feed();
+    }
+    else if (directive == "hold")
+    {
+      int scans = 0;
+      int signal[FRETBOARD_CELLS] = {0};
+      ok = (in >> scans) && parseTouchCells(in, signal);
+      for (int i = 0; ok && i < scans; i++)
+      {
+        int idle = TOUCH_IDLE_READING + (int)(drift * scanner->scans / 1000);
+        for (int cell = 0; cell < FRETBOARD_CELLS; cell++)
+        {
+          random = random * 1103515245u + 12345u;
+          int jitter = noise > 0 ? (int)((random >> 16) % (2 * noise + 1)) - noise : 0;
+          readings[cell] = (uint16_t)(idle - signal[cell] + jitter);
+        }
+        feed();
+      }
+    }
+    else if (directive == "noise")
+      ok = static_cast<bool>(in >> noise);
+    else if (directive == "drift")
+      ok = static_cast<bool>(in >> drift);
+    else if (directive == "seed")
+      ok = static_cast<bool>(in >> random);
+    else
+      ok = false;
+
+    if (!ok)
+    {
+      fprintf(stderr, "%s:%d: bad line\n", path, lineNumber);
+      fclose(file);
+      return 1;
+    }
+  }
+  fclose(file);
+
+  uint32_t scans = scanner->scans;
+  printf("%u scans (%.1f s at %u Hz), %u mask changes, %.0f ns per scan\n", (unsigned)scans,
+         scans * TOUCH_SCAN_PERIOD_US / 1e6, (unsigned)(1000000 / TOUCH_SCAN_PERIOD_US), (unsigned)changes,
+         scans > 0 ? (double)busy.count() / scans : 0.0);
+  delete scanner;
+  return 0;
+}
+
+// ================== Tuner WAV ==================
+static int runTunerWav(const char *path, double expectHz)
+{
+  std::vector<int16_t> samples;
+  if (!loadWav(path, samples))
+    return 1;
+
+  TunerState *state = new TunerState;
+  tunerStateReset(*state);
+  uint32_t blocks = 0;
+  uint32_t readings = 0;
+  double errorSum = 0;
+  double errorMax = 0;
+  std::vector<double> errors;
+  std::chrono::nanoseconds busy(0);
+
+  for (size_t at = 0; at + AUDIO_BLOCK_SAMPLES <= samples.size(); at += AUDIO_BLOCK_SAMPLES)
+  {
+    TunerReading reading;
+    auto start = std::chrono::steady_clock::now();
+    bool voiced = tunerAnalyze(*state, samples.data() + at, &reading);
+    busy += std::chrono::steady_clock::now() - start;
+    blocks++;
+    if (!voiced)
+      continue;
+
+    readings++;
+    double hz = reading.centiHz / 100.0;
+    printf("%7.3f s: %8.2f Hz, string %u %+4d cents, aperiodicity %.3f", (double)(at + AUDIO_BLOCK_SAMPLES) / AUDIO_SAMPLE_RATE,
+           hz, reading.string, reading.cents, reading.aperiodicity / 32768.0);
+    if (expectHz > 0)
+    {
+      double error = 1200 * std::log2(hz / expectHz);
+      errors.push_back(std::fabs(error));
+      errorSum += std::fabs(error);
+      errorMax = std::max(errorMax, std::fabs(error));
+      printf(", error %+.2f cents", error);
+    }
+    printf("\n");
+  }
+
+  double seconds = (double)samples.size() / AUDIO_SAMPLE_RATE;
+  double perBlock = blocks > 0 ? (double)busy.count() / blocks : 0;
+  printf("%u blocks (%.2f s at %u Hz), %u voiced, %.0f ns per block (%.1f%% of real time)\n", (unsigned)blocks, seconds,
+         (unsigned)AUDIO_SAMPLE_RATE, (unsigned)readings, perBlock,
+         perBlock * 100 / (1e9 * AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE));
+  if (expectHz > 0 && !errors.empty())
+  {
+    std::sort(errors.begin(), errors.end());
+    printf("error vs %.2f Hz: mean %.2f cents, median %.2f, max %.2f\n", expectHz, errorSum / errors.size(),
+           errors[errors.size() / 2], errorMax);
+  }
+  delete state;
+  return 0;
+}
+
+// "C:Major", "F#:Minor 7": note name and chordCatalogue name
+static bool parseChordName(const char *chordName, int *root, int *type)
+{
+  std::string name = chordName;
+  size_t colon = name.find(':');
+  *root = -1;
+  for (int note = 0; note < 12 && colon != std::string::npos; note++)
+  {
+    if (name.compare(0, colon, noteNames[note]) == 0)
+      *root = note;
+  }
+  *type = colon == std::string::npos ? -1 : findChordIndex(name.c_str() + colon + 1);
+  if (*root < 0 || *type < 0)
+  {
+    fprintf(stderr, "unknown chord %s (e.g. C:Major, \"F#:Minor 7\")\n", chordName);
+    return false;
+  }
+  return true;
+}
+
+// ================== Chord WAV ==================
+static int runChordWav(const char *path, const char *chordName)
+{
+  std::vector<int16_t> samples;
+  if (!loadWav(path, samples))
+    return 1;
+
+  PitchClassSet chord = 0;
+  if (chordName != nullptr)
+  {
+    int root;
+    int type;
+    if (!parseChordName(chordName, &root, &type))
+      return 1;
+    chord = chordPitchSet(root, type);
+  }
+
+  ChordListenState *state = new ChordListenState;
+  chordListenStateReset(*state);
+  uint32_t blocks = 0;
+  uint32_t strums = 0;
+  uint32_t scoreSum = 0;
+  std::chrono::nanoseconds busy(0);
+  std::chrono::nanoseconds scoring(0);
+  std::chrono::nanoseconds scoringMax(0);
+
+  for (size_t at = 0; at + AUDIO_BLOCK_SAMPLES <= samples.size(); at += AUDIO_BLOCK_SAMPLES)
+  {
+    ChordMatch match;
+    auto start = std::chrono::steady_clock::now();
+    bool scored = chordListenAnalyze(*state, samples.data() + at, chord, &match);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    busy += elapsed;
+    blocks++;
+    if (!scored)
+      continue;
+
+    strums++;
+    scoreSum += match.score;
+    scoring += elapsed;
+    scoringMax = std::max(scoringMax, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+    double onset = (double)(at + AUDIO_BLOCK_SAMPLES - match.frameSamples) / AUDIO_SAMPLE_RATE;
+    printf("%7.3f s: score %3u%%, heard %s, chroma", onset, match.score, pitchClassNames(match.heard).c_str());
+    float strongest = *std::max_element(match.chroma, match.chroma + 12);
+    for (int pitchClass = 0; pitchClass < 12; pitchClass++)
+      printf(" %.2f", strongest > 0 ? match.chroma[pitchClass] / strongest : 0.0f);
+    printf("\n");
+  }
+
+  double seconds = (double)samples.size() / AUDIO_SAMPLE_RATE;
+  double busySeconds = busy.count() / 1e9;
+  printf("%u blocks (%.2f s at %u Hz), %u strums against %s, mean score %.1f%%\n", (unsigned)blocks, seconds,
+         (unsigned)AUDIO_SAMPLE_RATE, (unsigned)strums, pitchClassNames(chord).c_str(),
+         strums > 0 ? (double)scoreSum / strums : 0.0);
+  printf("%.0f blocks per second (real time: %.1f), scoring a strum %.1f us mean, %.1f us max\n",
+         busySeconds > 0 ? blocks / busySeconds : 0.0, (double)AUDIO_SAMPLE_RATE / AUDIO_BLOCK_SAMPLES,
+         strums > 0 ? scoring.count() / 1e3 / strums : 0.0, scoringMax.count() / 1e3);
+  delete state;
+  return 0;
+}
+
+// ================== Click Bench ==================
+// One synthetic track: 12-bit samples at AUDIO_SAMPLE_RATE and the true onsets
+struct ClickTrack
+{
+  const char *name;
+  std::vector<int16_t> samples;
+  std::vector<double> onsetsUs;
+};
+
+// Plucked string (Karplus-Strong) added into out from sample at
+static void addPluck(std::vector<double> &out, size_t at, double hz, double level, std::mt19937 &random)
+{
+  std::uniform_real_distribution<double> noise(-1, 1);
+  std::vector<double> line((size_t)(AUDIO_SAMPLE_RATE / hz));
+  for (double &value : line)
+    value = noise(random);
+  for (size_t i = 0; at + i < out.size() && i < (size_t)AUDIO_SAMPLE_RATE; i++)
+  {
+    size_t tap = i % line.size();
+    out[at + i] += level * line[tap];
+    line[tap] = 0.498 * (line[tap] + line[(tap + 1) % line.size()]);
+  }
+}
+
+// kind: 0 click, 1 single notes, 2 six-string strums; hits on a humanised
+// grid (up to +-humanMs off), white noise at noiseDb below full scale
+static ClickTrack makeClickTrack(const char *name, int kind, double bpm, double humanMs, double noiseDb)
+{
+  const double seconds = 30;
+  std::mt19937 random(7);
+  std::uniform_real_distribution<double> offset(-humanMs, humanMs);
+  std::normal_distribution<double> hiss(0, std::pow(10, noiseDb / 20));
+  std::vector<double> signal((size_t)(seconds * AUDIO_SAMPLE_RATE));
+  ClickTrack track;
+  track.name = name;
+
+  const double strings[6] = {82.41, 110.0, 146.83, 196.0, 246.94, 329.63};
+  double period = 60.0 / bpm;
+  for (double beat = 0.5; beat < seconds - 1; beat += period)
+  {
+    double at = beat + offset(random) / 1000;
+    size_t start = (size_t)std::lround(at * AUDIO_SAMPLE_RATE);
+    track.onsetsUs.push_back(start * 1e6 / AUDIO_SAMPLE_RATE);
+    if (kind == 0)
+    {
+      std::uniform_real_distribution<double> burst(-1, 1);
+      for (size_t i = 0; i < 480 && start + i < signal.size(); i++)
+        signal[start + i] += 0.5 * burst(random) * std::exp(-(double)i / 48);
+    }
+    else if (kind == 1)
+    {
+      addPluck(signal, start, strings[random() % 6] * (random() % 2 + 1), 0.4, random);
+    }
+    else
+    {
+      for (int string = 0; string < 6; string++) // downstroke over 40 ms
+        addPluck(signal, start + string * AUDIO_SAMPLE_RATE / 125, strings[string], 0.15, random);
+    }
+  }
+
+  for (double value : signal)
+  {
+    double sample = (value + hiss(random)) * AUDIO_SAMPLE_MAX;
+    track.samples.push_back((int16_t)std::max(-2047.0, std::min(2047.0, sample)));
+  }
+  return track;
+}
+
+static int runClickBench()
+{
+  const ClickTrack tracks[] = {
+      makeClickTrack("clicks 120 bpm", 0, 120, 0, -60),
+      makeClickTrack("clicks 120 bpm, noise", 0, 120, 0, -30),
+      makeClickTrack("notes 160 bpm, human", 1, 160, 30, -60),
+      makeClickTrack("notes 160 bpm, noise", 1, 160, 30, -40),
+      makeClickTrack("strums 90 bpm, human", 2, 90, 30, -60),
+      makeClickTrack("strums 200 bpm, human", 2, 200, 20, -60),
+  };
+  const double blockUs = 1e6 * AUDIO_BLOCK_SAMPLES / AUDIO_SAMPLE_RATE;
+
+  printf("%-24s %6s %6s %6s %10s %10s %9s %12s %12s\n", "track", "onsets", "found", "false", "error us",
+         "jitter us", "max us", "latency ms", "max ms");
+  std::chrono::nanoseconds busy(0);
+  uint64_t blocks = 0;
+  for (const ClickTrack &track : tracks)
+  {
+    OnsetDetector detector;
+    onsetDetectorReset(detector);
+    std::vector<std::pair<double, double>> detected; // onset, time it was known
+    for (size_t at = 0; at + AUDIO_BLOCK_SAMPLES <= track.samples.size(); at += AUDIO_BLOCK_SAMPLES)
+    {
+      int64_t onsets[ONSET_MAX_PER_BLOCK];
+      int64_t blockStart = (int64_t)(at * 1000000 / AUDIO_SAMPLE_RATE);
+      auto start = std::chrono::steady_clock::now();
+      int found = detectOnsets(detector, track.samples.data() + at, blockStart, onsets);
+      auto elapsed = std::chrono::steady_clock::now() - start;
+      busy += elapsed;
+      blocks++;
+      // The block is complete blockUs after its start; the analysis adds its own time
+      double knownAt = blockStart + blockUs + std::chrono::duration<double, std::micro>(elapsed).count();
+      for (int i = 0; i < found; i++)
+        detected.emplace_back((double)onsets[i], knownAt);
+    }
+
+    // Pair every true onset with the nearest detection within 30 ms
+    std::vector<bool> used(detected.size());
+    std::vector<double> errors;
+    double latencySum = 0;
+    double latencyMax = 0;
+    for (double truth : track.onsetsUs)
+    {
+      int best = -1;
+      for (size_t i = 0; i < detected.size(); i++)
+      {
+        double distance = std::fabs(detected[i].first - truth);
+        if (!used[i] && distance <= 30000 && (best < 0 || distance < std::fabs(detected[best].first - truth)))
+          best = (int)i;
+      }
+      if (best < 0)
+        continue;
+      used[best] = true;
+      errors.push_back(detected[best].first - truth);
+      double latency = (detected[best].second - truth) / 1000;
+      latencySum += latency;
+      latencyMax = std::max(latencyMax, latency);
+    }
+
+    double mean = 0;
+    double deviation = 0;
+    double worst = 0;
+    for (double error : errors)
+      mean += error / errors.size();
+    for (double error : errors)
+    {
+      deviation += (error - mean) * (error - mean) / errors.size();
+      worst = std::max(worst, std::fabs(error));
+    }
+    printf("%-24s %6zu %6zu %6zu %10.0f %10.0f %9.0f %12.1f %12.1f\n", track.name, track.onsetsUs.size(), errors.size(),
+           detected.size() - errors.size(), mean, std::sqrt(deviation), worst,
+           errors.empty() ? 0.0 : latencySum / errors.size(), latencyMax);
+  }
+  printf("%.0f ns per block (%.3f%% of real time)\n", blocks > 0 ? (double)busy.count() / blocks : 0.0,
+         blocks > 0 ? (double)busy.count() / blocks * 100 / (blockUs * 1000) : 0.0);
+  return 0;
+}
+
+// ================== Voicings ==================
+static void printVoicings(const VoicingSet &set)
+{
+  for (int i = 0; i < set.count; i++)
+  {
+    const ChordVoicing &voicing = set.voicings[i];
+    printf("  ");
+    for (int string = 0; string < NUM_STRINGS; string++)
+    {
+      if (voicing.frets[string] == VOICING_MUTED)
+        printf(" x");
+      else
+        printf(" %d", voicing.frets[string]);
+    }
+    printf("   cost %2u, %u fingers", voicing.cost, voicing.fingers);
+    if (voicing.barre != 0)
+      printf(", barre at fret %u", voicing.barre);
+    printf("\n");
+  }
+}
+
+// Best of a few runs of a cold solve, in nanoseconds
+static double timeSolve(PitchClassSet chord, int root, const uint8_t *openMidi, int capo, VoicingSet &set,
+                        uint32_t *nodes)
+{
+  double best = 1e18;
+  for (int run = 0; run < 5; run++)
+  {
+    auto start = std::chrono::steady_clock::now();
+    *nodes = solveVoicings(chord, root, openMidi, capo, set);
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+static int runVoicings(const char *chordName, int tuning, int capo)
+{
+  if (tuning < 0 || tuning >= TUNING_PRESET_COUNT || capo < 0 || capo > TUNING_MAX_CAPO)
+  {
+    fprintf(stderr, "tuning 0-%d, capo 0-%d\n", TUNING_PRESET_COUNT - 1, TUNING_MAX_CAPO);
+    return 1;
+  }
+  const uint8_t *openMidi = tuningPresetMidi[tuning];
+  VoicingSet set;
+  uint32_t nodes;
+
+  if (strcmp(chordName, "all") != 0)
+  {
+    int root;
+    int type;
+    if (!parseChordName(chordName, &root, &type))
+      return 1;
+    double ns = timeSolve(chordPitchSet(root, type), root, openMidi, capo, set, &nodes);
+    printf("%s, tuning %d, capo %d: %u voicings, %u nodes, %.1f us\n", chordName, tuning, capo, set.count,
+           (unsigned)nodes, ns / 1000);
+    printVoicings(set);
+    return 0;
+  }
+
+  // Every chord cold, then every chord again through the cache
+  retuneFretboard(openMidi, capo);
+  double total = 0;
+  double worst = 0;
+  uint32_t nodesMax = 0;
+  int empty = 0;
+  for (int root = 0; root < 12; root++)
+  {
+    for (int type = 0; type < CHORD_TYPE_COUNT; type++)
+    {
+      double ns = timeSolve(chordPitchSet(root, type), root, openMidi, capo, set, &nodes);
+      printf("%-2s %-18s %u voicings, %4u nodes, %6.1f us\n", noteNames[root], chordCatalogue[type].name, set.count,
+             (unsigned)nodes, ns / 1000);
+      total += ns;
+      worst = std::max(worst, ns);
+      nodesMax = std::max(nodesMax, nodes);
+      empty += set.count == 0;
+    }
+  }
+
+  const int chords = 12 * CHORD_TYPE_COUNT;
+  clearVoicingCache();
+  for (int type = 0; type < VOICING_CACHE_SIZE; type++)
+    chordVoicings(0, type);
+  const int lookups = 100000;
+  int found = 0;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < lookups; i++)
+    found += chordVoicings(0, i % VOICING_CACHE_SIZE).count > 0;
+  std::chrono::duration<double, std::nano> cached = std::chrono::steady_clock::now() - start;
+
+  printf("%d chords, %d without a voicing: cold solve mean %.1f us, max %.1f us, max %u nodes\n", chords, empty,
+         total / chords / 1000, worst / 1000, (unsigned)nodesMax);
+  printf("cached lookup %.0f ns (%d of %d found voicings)\n", cached.count() / lookups, found, lookups);
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  const char *powerReportDirectory = nullptr;
+  const char *touchTrace = nullptr;
+  const char *tunerWav = nullptr;
+  const char *chordWav = nullptr;
+  const char *chordName = nullptr;
+  bool clickBench = false;
+  const char *voicings = nullptr;
+  int tuning = TUNING_STANDARD;
+  int capo = 0;
+  double expectHz = 0;
+  uint32_t budgetMa = LED_POWER_BUDGET_MA;
+  for (int i = 1; i < argc; i++)
+  {
+    std::string option = argv[i];
+    if (option == "--serial")
+      Serial.setEcho(true);
+    else if (option == "--plain")
+      plainOutput = true;
+    else if (option == "--ppm-dir" && i + 1 < argc)
+      ppmDirectory = argv[++i];
+    else if (option == "--power-report" && i + 1 < argc)
+      powerReportDirectory = argv[++i];
+    else if (option == "--touch-trace" && i + 1 < argc)
+      touchTrace = argv[++i];
+    else if (option == "--tuner-wav" && i + 1 < argc)
+      tunerWav = argv[++i];
+    else if (option == "--chord-wav" && i + 1 < argc)
+      chordWav = argv[++i];
+    else if (option == "--chord" && i + 1 < argc)
+      chordName = argv[++i];
+    else if (option == "--click-bench")
+      clickBench = true;
+    else if (option == "--voicings" && i + 1 < argc)
+      voicings = argv[++i];
+    else if (option == "--tuning" && i + 1 < argc)
+      tuning = atoi(argv[++i]);
+    else if (option == "--capo" && i + 1 < argc)
+      capo = atoi(argv[++i]);
+    else if (option == "--expect" && i + 1 < argc)
+      expectHz = atof(argv[++i]);
+    else if (option == "--budget" && i + 1 < argc)
+      budgetMa = (uint32_t)atoi(argv[++i]);
+    else
+    {
+      fprintf(stderr, "usage: %s [--serial] [--plain] [--ppm-dir DIR] < script\n", argv[0]);
+      fprintf(stderr, "       %s --power-report DIR [--budget MA]\n", argv[0]);
+      fprintf(stderr, "       %s --touch-trace FILE\n", argv[0]);
+      fprintf(stderr, "       %s --tuner-wav FILE [--expect HZ]\n", argv[0]);
+      fprintf(stderr, "       %s --chord-wav FILE [--chord ROOT:TYPE]\n", argv[0]);
+      fprintf(stderr, "       %s --click-bench\n", argv[0]);
+      fprintf(stderr, "       %s --voicings ROOT:TYPE|all [--tuning PRESET] [--capo FRET]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  // Pure model: no setup(), no tasks; the converters only touch backBuffer
+  if (powerReportDirectory != nullptr)
+    return runPowerReport(powerReportDirectory, budgetMa);
+  if (touchTrace != nullptr)
+    return runTouchTrace(touchTrace);
+  if (tunerWav != nullptr)
+    return runTunerWav(tunerWav, expectHz);
+  if (chordWav != nullptr)
+    return runChordWav(chordWav, chordName);
+  if (clickBench)
+    return runClickBench();
+  if (voicings != nullptr)
+    return runVoicings(voicings, tuning, capo);
+
+  FastLED.setShowCallback(onShow);
+  nativeSetTouchReader(readTouchPad);
+  nativeSetAudioSource(readAudioInput);
+  setup();
+  nativeWaitForIdle();
+
+  char buffer[1024];
+  while (fgets(buffer, sizeof(buffer), stdin) != nullptr)
+  {
+    std::string line = buffer;
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+      line.pop_back();
+    if (line.empty() || line[0] == '#')
+      continue;
+
+    printf("> %s\n", line.c_str());
+    if (!runCommand(line))
+      fprintf(stderr, "bad command: %s\n", line.c_str());
+    nativeWaitForIdle();
+  }
+
+  // Firmware tasks never return; leave without running static destructors under them
+  fflush(stdout);
+  fflush(stderr);
+  _Exit(0);
+}
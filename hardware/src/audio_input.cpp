@@ -0,0 +1,205 @@
+#include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
+#include <driver/adc.h>
+#include <driver/i2s.h>
+#include "audio_input.h"
+#include "event_stream.h"
+#include "render_task.h"
+#include "supervisor.h"
+#include "tuner.h"
+#include "chord_listen.h"
+#include "rhythm.h"
+#include "trace_log.h"
+
+#define AUDIO_I2S_PORT I2S_NUM_0
+#define AUDIO_READ_TIMEOUT_MS 100
+
+static TaskHandle_t audioTaskHandle = nullptr;
+static std::atomic<uint8_t> requestedMode(AUDIO_MODE_OFF);
+static AudioStats audioStats = {};
+
+void audioConvertBlock(const uint16_t *raw, int16_t *samples, int count, int32_t &dcLevel)
+{
+  int32_t sum = 0;
+  for (int i = 0; i < count; i += 2)
+  {
+    int32_t first = raw[i + 1] & 0x0FFF;
+    int32_t second = raw[i] & 0x0FFF;
+    samples[i] = (int16_t)first;
+    samples[i + 1] = (int16_t)second;
+    sum += first + second;
+  }
+
+  // A fresh capture starts from the first block's mean
+  int32_t mean = (sum << 8) / count;
+  if (dcLevel < 0)
+    dcLevel = mean;
+  else
+    dcLevel += (mean - dcLevel) >> AUDIO_DC_SHIFT;
+
+  int32_t dc = dcLevel >> 8;
+  for (int i = 0; i < count; i++)
+  {
+    int32_t sample = samples[i] - dc;
+    samples[i] = (int16_t)(sample > AUDIO_SAMPLE_MAX ? AUDIO_SAMPLE_MAX
+                                                     : sample < -AUDIO_SAMPLE_MAX ? -AUDIO_SAMPLE_MAX : sample);
+  }
+}
+
+int64_t audioBlockStartUs(int64_t readAtUs, uint64_t samplesBefore, int64_t &offsetUs)
+{
+  int64_t sinceStart = (int64_t)((samplesBefore + AUDIO_BLOCK_SAMPLES) * 1000000 / AUDIO_SAMPLE_RATE);
+  int64_t observed = readAtUs - sinceStart;
+  if (offsetUs == INT64_MIN || observed < offsetUs + AUDIO_CLOCK_SLEW_US)
+    offsetUs = observed;
+  else
+    offsetUs += AUDIO_CLOCK_SLEW_US;
+  return offsetUs + (int64_t)(samplesBefore * 1000000 / AUDIO_SAMPLE_RATE);
+}
+
+static void startCapture(AudioMode mode)
+{
+  audioCaptureBegin();
+  if (mode == AUDIO_MODE_TUNER)
+    resetTuner();
+  else if (mode == AUDIO_MODE_CHORD)
+    resetChordListen();
+  else if (mode == AUDIO_MODE_RHYTHM)
+    resetRhythm();
+  i2s_zero_dma_buffer(AUDIO_I2S_PORT);
+  i2s_adc_enable(AUDIO_I2S_PORT);
+  i2s_start(AUDIO_I2S_PORT);
+}
+
+static void stopCapture(AudioMode mode)
+{
+  i2s_stop(AUDIO_I2S_PORT);
+  i2s_adc_disable(AUDIO_I2S_PORT);
+  audioCaptureEnd();
+  if (mode == AUDIO_MODE_TUNER)
+    requestClear(); // the needle; chord mode leaves the app's chord up
+  LOG_INFO(TRACE_AUDIO_STATS, (int)audioStats.blocks, (int)audioStats.shortReads, (int)audioStats.maxBlockMicros);
+}
+
+static void audioTask(void *parameter)
+{
+  (void)parameter;
+  static uint16_t raw[AUDIO_BLOCK_SAMPLES];
+  static int16_t samples[AUDIO_BLOCK_SAMPLES];
+  AudioMode mode = AUDIO_MODE_OFF;
+  int32_t dcLevel = -1;
+  uint64_t samplesCaptured = 0;
+  int64_t clockOffset = INT64_MIN;
+
+  for (;;)
+  {
+    AudioMode requested = (AudioMode)requestedMode.load();
+    if (requested != mode)
+    {
+      if (mode != AUDIO_MODE_OFF)
+        stopCapture(mode);
+      mode = requested;
+      dcLevel = -1;
+      samplesCaptured = 0;
+      clockOffset = INT64_MIN;
+      if (mode != AUDIO_MODE_OFF)
+        startCapture(mode);
+      LOG_INFO(TRACE_AUDIO_MODE, mode);
+    }
+
+    if (mode == AUDIO_MODE_OFF)
+    {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      continue;
+    }
+
+    // Blocks until the DMA has a full block; a mode change is seen on the next one
+    size_t bytesRead = 0;
+    i2s_read(AUDIO_I2S_PORT, raw, sizeof(raw), &bytesRead, pdMS_TO_TICKS(AUDIO_READ_TIMEOUT_MS));
+    int64_t readAt = esp_timer_get_time();
+    if (bytesRead != sizeof(raw))
+    {
+      audioStats.shortReads++;
+      samplesCaptured += bytesRead / sizeof(raw[0]);
+      continue;
+    }
+    int64_t blockStart = audioBlockStartUs(readAt, samplesCaptured, clockOffset);
+    samplesCaptured += AUDIO_BLOCK_SAMPLES;
+
+    uint32_t start = micros();
+    audioConvertBlock(raw, samples, AUDIO_BLOCK_SAMPLES, dcLevel);
+    switch (mode)
+    {
+    case AUDIO_MODE_TUNER:
+      tunerProcessBlock(samples);
+      break;
+    case AUDIO_MODE_CHORD:
+      chordListenProcessBlock(samples);
+      break;
+    case AUDIO_MODE_RHYTHM:
+      rhythmProcessBlock(samples, blockStart);
+      break;
+    default:
+      break;
+    }
+
+    uint32_t elapsed = micros() - start;
+    audioStats.blocks++;
+    if (elapsed > audioStats.maxBlockMicros)
+      audioStats.maxBlockMicros = elapsed;
+  }
+}
+
+void setupAudio()
+{
+  if (!AUDIO_ENABLED)
+    return;
+
+  i2s_config_t config = {};
+  config.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+  config.sample_rate = AUDIO_SAMPLE_RATE;
+  config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+  config.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+  config.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+  config.dma_buf_count = AUDIO_DMA_BUFFERS;
+  config.dma_buf_len = AUDIO_BLOCK_SAMPLES;
+  config.use_apll = false;
+  i2s_driver_install(AUDIO_I2S_PORT, &config, 0, nullptr);
+  i2s_set_adc_mode(ADC_UNIT_1, AUDIO_ADC_CHANNEL);
+  adc1_config_channel_atten(AUDIO_ADC_CHANNEL, ADC_ATTEN_DB_11);
+  i2s_stop(AUDIO_I2S_PORT);
+
+  xTaskCreatePinnedToCore(audioTask, "audio", AUDIO_TASK_STACK, nullptr,
+                          AUDIO_TASK_PRIORITY, &audioTaskHandle, AUDIO_TASK_CORE);
+}
+
+uint8_t audioHandleFrame(const FrameView &frame)
+{
+  if (frame.opcode != FRAME_OP_AUDIO || frame.length < 1 || frame.length > 2 || frame.payload[0] >= AUDIO_MODE_COUNT)
+    return REJECT_MALFORMED;
+  uint8_t mode = frame.payload[0];
+  uint8_t argument = frame.length == 2 ? frame.payload[1] : 1;
+  if (frame.length == 2 && mode != AUDIO_MODE_RHYTHM)
+    return REJECT_MALFORMED; // only rhythm takes an argument
+  if (audioTaskHandle == nullptr)
+    return REJECT_UNSUPPORTED;
+  if (mode == AUDIO_MODE_RHYTHM && !rhythmSetSubdivisions(argument))
+    return REJECT_MALFORMED;
+
+  requestedMode.store(mode);
+  xTaskNotifyGive(audioTaskHandle);
+  return 0;
+}
+
+void stopAudio()
+{
+  requestedMode.store(AUDIO_MODE_OFF);
+  if (audioTaskHandle != nullptr)
+    xTaskNotifyGive(audioTaskHandle);
+}
+
+AudioStats getAudioStats()
+{
+  return audioStats;
+}
@@ -0,0 +1,94 @@
+#include <Arduino.h>
+#include "ble_protocol.h"
+
+uint8_t frameCrc8(const uint8_t *data, size_t length)
+{
+  uint8_t crc = 0x00;
+  for (size_t i = 0; i < length; i++)
+  {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+    {
+      crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+size_t encodeFrame(uint8_t opcode, const uint8_t *payload, size_t length, uint8_t *out)
+{
+  if (length > FRAME_MAX_PAYLOAD)
+    return 0;
+
+  out[0] = FRAME_HEADER;
+  out[1] = opcode;
+  out[2] = (uint8_t)length;
+  memcpy(out + 3, payload, length);
+  out[3 + length] = frameCrc8(out, 3 + length);
+  return length + FRAME_OVERHEAD;
+}
+
+bool isBinaryFrame(const uint8_t *data, size_t length)
+{
+  return length >= FRAME_OVERHEAD && (data[0] & FRAME_MAGIC_MASK) == FRAME_MAGIC;
+}
+
+bool decodeFrame(const uint8_t *data, size_t length, FrameView *frame)
+{
+  if (!isBinaryFrame(data, length))
+    return false;
+
+  // Only version 1 exists so far; newer versions are rejected, not guessed at
+  if (data[0] != FRAME_HEADER)
+    return false;
+
+  uint8_t payloadLength = data[2];
+  if (payloadLength > FRAME_MAX_PAYLOAD || length != (size_t)payloadLength + FRAME_OVERHEAD)
+    return false;
+
+  if (frameCrc8(data, length - 1) != data[length - 1])
+    return false;
+
+  frame->opcode = data[1];
+  frame->length = payloadLength;
+  frame->payload = data + 3;
+  return true;
+}
+
+int decodeChordFrame(const FrameView &frame, int *tokens, int maxTokens)
+{
+  if (frame.opcode != FRAME_OP_CHORD || frame.length != CHORD_FRAME_PAYLOAD || maxTokens < 6)
+    return 0;
+
+  for (int string = 0; string < 6; string++)
+  {
+    uint8_t packed = frame.payload[string / 2];
+    uint8_t nibble = (string % 2 == 0) ? (packed >> 4) : (packed & 0x0F);
+    tokens[string] = (int)nibble - 1; // 0 = muted (-1), 1 = open (0), ...
+  }
+  return 6;
+}
+
+int decodeScaleFrame(const FrameView &frame, int scaleData[][2], int maxPairs)
+{
+  if (frame.opcode != FRAME_OP_SCALE || frame.length == 0 || frame.length > maxPairs)
+    return 0;
+
+  for (int i = 0; i < frame.length; i++)
+  {
+    scaleData[i][0] = frame.payload[i] >> 4;   // string
+    scaleData[i][1] = frame.payload[i] & 0x0F; // fret
+  }
+  return frame.length;
+}
+
+bool decodeShapeFrame(const FrameView &frame, int *root, int *type, int *voicing)
+{
+  if (frame.opcode != FRAME_OP_SHAPE || frame.length < 2 || frame.length > 3)
+    return false;
+
+  *root = frame.payload[0];
+  *type = frame.payload[1];
+  *voicing = frame.length == 3 ? frame.payload[2] : 0;
+  return true;
+}
@@ -4,61 +4,96 @@
 #include "scale_and_chord_notes.h"
 #include "pixel_mapping.h"
 #include "data_handling.h"
+#include "ble_protocol.h"
+#include "render_task.h"
+#include "shape_index.h"
+#include "trace_log.h"
+#include "event_stream.h"
+#include "link_tuning.h"
+#include "sequencer.h"
+#include "effects.h"
+#include "audio_input.h"
+#include "guitar_tuning.h"
+#include "supervisor.h"
 
 // Define globals here (once)
 BLEServer *pServer = nullptr;
 BLECharacteristic *pInitCharacteristic = nullptr;
 BLECharacteristic *pChordPixelCharacteristic = nullptr;
 BLECharacteristic *pScalePixelCharacteristic = nullptr;
+BLECharacteristic *pEventCharacteristic = nullptr;
+BLECharacteristic *pLinkCharacteristic = nullptr;
+BLECharacteristic *pFastPixelCharacteristic = nullptr;
+BLECharacteristic *pSequenceCharacteristic = nullptr;
+
+// Newest sequence number accepted on the fast path (BLE task only)
+static bool fastSequenceValid = false;
+static uint16_t fastSequence = 0;
 
 class InitCharacteristicCallbacks : public BLECharacteristicCallbacks
 {
   void onWrite(BLECharacteristic *pCharacteristic) override
   {
     String value = String(pCharacteristic->getValue().c_str());
-    Serial.println("Init service received: " + value);
+    LOG_INFO(TRACE_INIT_RECEIVED, (int)value.length());
     
     // Handle initialization messages from mobile app
     if (value == "Guitar-Pal") {
-      Serial.println("Mobile app connected and initialized");
+      LOG_INFO(TRACE_APP_INITIALIZED);
       pCharacteristic->setValue("ESP32 Ready");
     }
   }
 };
 
+// Both pixel characteristics also accept a 2-byte (root, type) shape frame
+static bool decodeShapeCommand(const FrameView &frame, PixelCommand &command)
+{
+  if (!decodeShapeFrame(frame, &command.root, &command.shapeType, &command.voicing))
+    return false;
+
+  // A shape frame is one (root, type) ID; unknown IDs are rejected like bad data
+  command.type = CMD_SHAPE;
+  command.count = isShapeId(command.root, command.shapeType, command.voicing) ? 1 : 0;
+  return true;
+}
+
+// The pixel callbacks run on the BLE stack's task: they only decode the write
+// into a PixelCommand and hand it to the render task, which does the LED work.
 class ChordPixelCharacteristicCallbacks : public BLECharacteristicCallbacks
 {
   void onWrite(BLECharacteristic *pCharacteristic) override
   {
-    String value = String(pCharacteristic->getValue().c_str());
-    Serial.println("Chord pixel service received: " + value);
+    const uint8_t *data = pCharacteristic->getData();
+    size_t length = pCharacteristic->getLength();
 
     // Handle chord data from mobile app
-    int tokens[6];
-    int tokenCount = parseChordCommand(value, tokens, 6);
+    linkNoteActivity();
 
-    if (tokenCount > 0)
+    PixelCommand command;
+    command.type = CMD_CHORD;
+    command.receivedAt = micros();
+    command.sequence = -1;
+    FrameView frame;
+    if (!decodeFrame(data, length, &frame))
+    {
+      // Legacy text format, e.g. "[-1, 3, 2, 0, 1, 0]"
+      command.count = parseChordCommand((const char *)data, length, command.frets, 6);
+    }
+    else if (!decodeShapeCommand(frame, command))
     {
-      Serial.print("[");
-      Serial.print(millis() / 1000);
-      Serial.print("s] Received chord data: ");
-      Serial.print(value);
+      // Binary frame: decoded in place, no String allocation
+      command.count = decodeChordFrame(frame, command.frets, 6);
+    }
 
-      // Process chord data (expecting 6 fret positions for chord)
-      if (tokenCount == 6)
-      {
-        Serial.println(" - Processing chord positions");
-        int pixels[6];
-        clearGrid();
-        convertChordPositionsToPixels(tokens, pixels);
-        FastLED.show();
-      }
-      else
-      {
-        Serial.println(" - Invalid chord data format (expected 6 positions)");
-      }
-      Serial.println();
+    // Process chord data (expecting 6 fret positions for chord)
+    if (command.type == CMD_SHAPE ? command.count <= 0 : command.count != 6)
+    {
+      LOG_WARN(TRACE_CHORD_INVALID);
+      eventCommandRejected(EVENT_SOURCE_CHORD, REJECT_MALFORMED);
+      return;
     }
+
+    submitCommand(command);
   }
 };
 
@@ -66,85 +101,155 @@ class ScalePixelCharacteristicCallbacks : public BLECharacteristicCallbacks
 {
   void onWrite(BLECharacteristic *pCharacteristic) override
   {
-    String value = String(pCharacteristic->getValue().c_str());
-    Serial.println("Scale pixel service received: " + value);
-
-    // tokens is a nested array of 2 integer element array: string and fret
-    int scaleData[20][2]; // Array to hold up to 20 string-fret pairs
-    int scaleCount = parseScaleCommand(value, scaleData, 20);
-    Serial.print("Parsed scale count: ");
-    Serial.println(scaleCount);
-    Serial.println("Scale data:");
-    for (int i = 0; i < scaleCount; i++)
+    const uint8_t *data = pCharacteristic->getData();
+    size_t length = pCharacteristic->getLength();
+
+    // scaleData is a nested array of 2 integer element array: string and fret
+    linkNoteActivity();
+
+    PixelCommand command;
+    command.type = CMD_SCALE;
+    command.receivedAt = micros();
+    command.sequence = -1;
+    FrameView frame;
+    if (!decodeFrame(data, length, &frame))
+    {
+      // Legacy text format, e.g. "[[1, 3], [2, 0], [2, 2]]"
+      command.count = parseScaleCommand((const char *)data, length, command.scaleData, MAX_SCALE_PAIRS);
+    }
+    else if (!decodeShapeCommand(frame, command))
+    {
+      // Binary frame: one packed byte per string/fret pair
+      command.count = decodeScaleFrame(frame, command.scaleData, MAX_SCALE_PAIRS);
+    }
+
+    if (command.count <= 0)
+    {
+      LOG_WARN(TRACE_SCALE_INVALID);
+      eventCommandRejected(EVENT_SOURCE_SCALE, REJECT_MALFORMED);
+      return;
+    }
+
+    submitCommand(command);
+  }
+};
+
+// Fast path: [sequence: u16 LE][binary chord, scale or shape frame], written
+// without response. Frames that are not newer than the last accepted one
+// (serial number arithmetic, so the counter may wrap) are dropped, and only
+// the newest accepted frame waiting for the render task is kept.
+class FastPixelCharacteristicCallbacks : public BLECharacteristicCallbacks
+{
+  void onWrite(BLECharacteristic *pCharacteristic) override
+  {
+    linkNoteActivity();
+
+    const uint8_t *data = pCharacteristic->getData();
+    size_t length = pCharacteristic->getLength();
+    if (length < 2)
+    {
+      LOG_WARN(TRACE_FAST_INVALID);
+      eventCommandRejected(EVENT_SOURCE_FAST, REJECT_MALFORMED);
+      return;
+    }
+
+    uint16_t sequence = (uint16_t)(data[0] | (data[1] << 8));
+    if (fastSequenceValid && (int16_t)(sequence - fastSequence) <= 0)
+    {
+      LOG_DEBUG(TRACE_FAST_STALE, sequence, fastSequence);
+      return;
+    }
+
+    PixelCommand command;
+    command.receivedAt = micros();
+    command.sequence = sequence;
+    command.count = 0;
+
+    FrameView frame;
+    if (decodeFrame(data + 2, length - 2, &frame) && !decodeShapeCommand(frame, command))
     {
-      int guitarString = scaleData[i][0];
-      int fretPosition = scaleData[i][1];
-      int gridPosition = fretPosition * 6 + guitarString; // Convert to grid position
-
-      Serial.print("Scale position ");
-      Serial.print(i);
-      Serial.print(": String ");
-      Serial.print(guitarString);
-      Serial.print(", Fret ");
-      Serial.print(fretPosition);
-      Serial.print(" -> Grid position ");
-      Serial.println(gridPosition);
-
-      // For debugging: print the corresponding LED index
-      if (gridPosition < VALID_LEDS)
+      if (frame.opcode == FRAME_OP_CHORD)
       {
-        Serial.print("LED Index: ");
-        Serial.println(fretLEDs[gridPosition]);
-        // clearGrid();
-        // FastLED.leds()[fretLEDs[gridPosition]] = CRGB::Blue; // Light up the corresponding LED in blue
-        // FastLED.show();
-        // delay(200); // Briefly show each LED for debugging
+        command.type = CMD_CHORD;
+        command.count = decodeChordFrame(frame, command.frets, 6) == 6 ? 6 : 0;
       }
       else
       {
-        Serial.println("Grid position exceeds valid LED range");
+        command.type = CMD_SCALE;
+        command.count = decodeScaleFrame(frame, command.scaleData, MAX_SCALE_PAIRS);
       }
-
-      // For debugging: print the corresponding LED index
     }
 
-    if (scaleCount > 0)
+    if (command.count <= 0)
     {
-      Serial.print("[");
-      Serial.print(millis() / 1000);
-      Serial.print("s] Received scale data: ");
-      Serial.print(value);
-      Serial.print(" - Processing ");
-      Serial.print(scaleCount);
-      Serial.println(" scale positions");
-
-      // Process scale data
-      clearGrid();
-      convertScalePositionsToPixels(scaleData, scaleCount);
-      // FastLED.show();
+      LOG_WARN(TRACE_FAST_INVALID);
+      eventCommandRejected(EVENT_SOURCE_FAST, REJECT_MALFORMED);
+      return;
     }
-    else
+
+    fastSequenceValid = true;
+    fastSequence = sequence;
+    submitLatestCommand(command);
+  }
+};
+
+// Sequencer uploads and transport controls, effect settings, the audio mode or
+// the tuning; one frame per write
+class SequenceCharacteristicCallbacks : public BLECharacteristicCallbacks
+{
+  void onWrite(BLECharacteristic *pCharacteristic) override
+  {
+    linkNoteActivity();
+
+    FrameView frame;
+    uint8_t reason = REJECT_MALFORMED;
+    if (decodeFrame(pCharacteristic->getData(), pCharacteristic->getLength(), &frame))
     {
-      Serial.println(" - Invalid scale data format");
+      switch (frame.opcode)
+      {
+      case FRAME_OP_EFFECTS:
+        reason = effectsHandleFrame(frame);
+        break;
+      case FRAME_OP_AUDIO:
+        reason = audioHandleFrame(frame);
+        break;
+      case FRAME_OP_TUNING:
+        reason = tuningHandleFrame(frame);
+        break;
+      default:
+        reason = sequencerHandleFrame(frame);
+        break;
+      }
     }
 
-
+    if (reason != 0)
+    {
+      LOG_WARN(TRACE_SEQUENCE_REJECTED, reason);
+      eventCommandRejected(EVENT_SOURCE_SEQUENCE, reason);
+    }
   }
 };
 
 // Server callback class to handle connection events
 class MyServerCallbacks : public BLEServerCallbacks {
-  void onConnect(BLEServer* pServer) override {
-    Serial.println("Client connected");
-    digitalWrite(BL_CONNECTED_PIN, HIGH);
-    digitalWrite(BL_DISCONNECTED_PIN, LOW);
+  void onConnect(BLEServer*) override {
+    fastSequenceValid = false; // a new session starts its own numbering
   }
 
-  void onDisconnect(BLEServer* pServer) override {
-    Serial.println("Client disconnected - Restarting advertising");
-    delay(500); // Give some time for cleanup
-    pServer->startAdvertising(); // Restart advertising
-    Serial.println("BLE Advertising restarted - Ready for new connection");
+  // Called right after onConnect(BLEServer*) with the peer's address. The
+  // supervisor task does the rest; BLE callbacks must return quickly.
+  void onConnect(BLEServer*, esp_ble_gatts_cb_param_t* param) override {
+    linkConnected(param->connect.remote_bda);
+    postSystemEvent(SYSTEM_CONNECTED); // after linkConnected(), so the idle timeout is armed
+  }
+
+  void onMtuChanged(BLEServer*, esp_ble_gatts_cb_param_t* param) override {
+    linkMtuChanged(param->mtu.mtu);
+  }
+
+  void onDisconnect(BLEServer*) override {
+    linkDisconnected();
+    postSystemEvent(SYSTEM_DISCONNECTED); // blanks the grid and restarts advertising
   }
 };
 
@@ -154,6 +259,7 @@ void setupBluetooth()
 
   // Initialize BLE
   BLEDevice::init("ESP32_Isurika");
+  setupLinkTuning();
 
   // Print BLE MAC Address
   // uint8_t *mac = *BLEDevice::getAddress().getNative();
@@ -186,7 +292,7 @@ void setupBluetooth()
   pInitCharacteristic->setValue("ESP32 Init Ready");
 
   // Create Pixel Service
-  BLEService *pPixelService = pServer->createService(PIXEL_SERVICE_UUID);
+  BLEService *pPixelService = pServer->createService(BLEUUID(PIXEL_SERVICE_UUID), PIXEL_SERVICE_HANDLES);
   
   // Create Chord Pixel Characteristic
   pChordPixelCharacteristic = pPixelService->createCharacteristic(
@@ -204,6 +310,30 @@ void setupBluetooth()
   pScalePixelCharacteristic->setCallbacks(new ScalePixelCharacteristicCallbacks());
   pScalePixelCharacteristic->setValue("Scale Pixel Ready");
 
+  // Create Event Characteristic: render acks, rejections and stats pushed to the app
+  pEventCharacteristic = pPixelService->createCharacteristic(
+      EVENT_CHAR_UUID,
+      BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
+  pEventCharacteristic->addDescriptor(new BLE2902());
+
+  // Create Fast Pixel Characteristic: sequenced frames, write without response
+  pFastPixelCharacteristic = pPixelService->createCharacteristic(
+      FAST_PIXEL_CHAR_UUID,
+      BLECharacteristic::PROPERTY_WRITE_NR);
+  pFastPixelCharacteristic->setCallbacks(new FastPixelCharacteristicCallbacks());
+
+  // Create Sequence Characteristic: lesson upload, play/pause/tempo
+  pSequenceCharacteristic = pPixelService->createCharacteristic(
+      SEQUENCE_CHAR_UUID,
+      BLECharacteristic::PROPERTY_WRITE);
+  pSequenceCharacteristic->setCallbacks(new SequenceCharacteristicCallbacks());
+
+  // Create Link Characteristic: MTU, connection interval and PHY the phone granted
+  pLinkCharacteristic = pPixelService->createCharacteristic(
+      LINK_CHAR_UUID,
+      BLECharacteristic::PROPERTY_READ | BLECharacteristic::PROPERTY_NOTIFY);
+  pLinkCharacteristic->addDescriptor(new BLE2902());
+
   // Start both services
   pInitService->start();
   pPixelService->start();
@@ -0,0 +1,239 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include <atomic>
+#include "chord_check.h"
+#include "main.h"
+#include "pixel_mapping.h"
+#include "render_task.h"
+#include "shape_index.h"
+#include "event_stream.h"
+
+// One EVENT_CHORD_CHECK, worked out under the lock and queued after it
+struct CheckReport
+{
+  bool send;
+  uint8_t state;
+  uint8_t correct;
+  uint8_t fingers;
+  uint8_t wrong;
+  uint16_t elapsedMs;
+};
+
+// Shared by the render task (target) and the touch task (pressed)
+static portMUX_TYPE checkLock = portMUX_INITIALIZER_UNLOCKED;
+static bool hasTarget = false;
+static ChordTarget target;
+static CellMask lastPressed = {};
+static uint32_t shownAt = 0; // millis() when the target was drawn
+static bool touched = false; // a finger went down since then
+static bool solved = false;
+static uint8_t reportedCorrect = 0;
+static uint8_t reportedWrong = 0;
+static CellMask feedbackMissing = {};
+static CellMask feedbackWrong = {};
+static std::atomic<bool> feedbackChanged(false);
+
+static bool sameMask(const CellMask &a, const CellMask &b)
+{
+  for (int word = 0; word < CELL_MASK_WORDS; word++)
+  {
+    if (a.words[word] != b.words[word])
+      return false;
+  }
+  return true;
+}
+
+void chordTargetFromFrets(ChordTarget &target, const int *frets)
+{
+  cellMaskClear(target.fingers);
+  cellMaskClear(target.allowed);
+  target.fingerCount = 0;
+
+  for (int string = 0; string < NUM_STRINGS; string++)
+  {
+    cellMaskSet(target.allowed, string); // nut row
+    int fret = frets[string];
+    if (fret <= 0 || fret >= FRETBOARD_FRETS)
+      continue;
+
+    cellMaskSet(target.fingers, fret * NUM_STRINGS + string);
+    for (int behind = 1; behind <= fret; behind++)
+      cellMaskSet(target.allowed, behind * NUM_STRINGS + string);
+    target.fingerCount++;
+  }
+}
+
+void chordCheckCompare(const ChordTarget &target, const CellMask &pressed, ChordCheckResult &result)
+{
+  int correct = 0;
+  int wrong = 0;
+  for (int word = 0; word < CELL_MASK_WORDS; word++)
+  {
+    result.missing.words[word] = target.fingers.words[word] & ~pressed.words[word];
+    result.wrong.words[word] = pressed.words[word] & ~target.allowed.words[word];
+    correct += __builtin_popcountll(target.fingers.words[word] & pressed.words[word]);
+    wrong += __builtin_popcountll(result.wrong.words[word]);
+  }
+  result.correct = (uint8_t)correct;
+  result.wrongCount = (uint8_t)wrong;
+}
+
+// Chord shapes light one cell per string at most, so the lit row is the fret
+static bool chordFrets(const PixelCommand &command, int *frets)
+{
+  if (command.type == CMD_CHORD)
+  {
+    for (int string = 0; string < NUM_STRINGS; string++)
+      frets[string] = command.frets[string];
+    return true;
+  }
+  if (command.type != CMD_SHAPE || !isChordShape(command.shapeType))
+    return false;
+  if (command.voicing >= 0)
+  {
+    for (int string = 0; string < NUM_STRINGS; string++)
+      frets[string] = command.frets[string];
+    return true;
+  }
+
+  const CellMask *shape = getShapeMask(command.root, command.shapeType);
+  if (shape == nullptr)
+    return false;
+  for (int string = 0; string < NUM_STRINGS; string++)
+  {
+    frets[string] = -1;
+    for (int fret = 0; fret < FRETBOARD_FRETS; fret++)
+    {
+      if (cellMaskTest(*shape, fret * NUM_STRINGS + string))
+      {
+        frets[string] = fret;
+        break;
+      }
+    }
+  }
+  return true;
+}
+
+static uint16_t elapsedSinceShown(uint32_t now)
+{
+  uint32_t elapsed = now - shownAt;
+  return (uint16_t)(elapsed > 0xFFFF ? 0xFFFF : elapsed);
+}
+
+// Compare lastPressed with the target and update the feedback (checkLock held)
+static void evaluate(uint32_t now, CheckReport &report)
+{
+  report.send = false;
+
+  CellMask missing = {};
+  CellMask wrong = {};
+  if (hasTarget)
+  {
+    ChordCheckResult result;
+    chordCheckCompare(target, lastPressed, result);
+
+    bool anyDown = !cellMaskEmpty(lastPressed);
+    touched |= anyDown;
+    if (anyDown)
+    {
+      missing = result.missing;
+      wrong = result.wrong;
+    }
+
+    bool correct = result.correct == target.fingerCount && result.wrongCount == 0;
+    if ((correct && !solved) || result.correct != reportedCorrect || result.wrongCount != reportedWrong)
+    {
+      report.send = true;
+      report.state = (correct && !solved) ? CHECK_CORRECT : CHECK_PROGRESS;
+      report.correct = result.correct;
+      report.fingers = target.fingerCount;
+      report.wrong = result.wrongCount;
+      report.elapsedMs = elapsedSinceShown(now);
+      solved |= correct;
+      reportedCorrect = result.correct;
+      reportedWrong = result.wrongCount;
+    }
+  }
+
+  if (!sameMask(missing, feedbackMissing) || !sameMask(wrong, feedbackWrong))
+  {
+    feedbackMissing = missing;
+    feedbackWrong = wrong;
+    feedbackChanged.store(true);
+  }
+}
+
+static void sendReport(const CheckReport &report)
+{
+  if (report.send)
+    eventChordCheck(report.state, report.correct, report.fingers, report.wrong, report.elapsedMs);
+}
+
+void chordCheckNewTarget(const PixelCommand *command)
+{
+  int frets[NUM_STRINGS];
+  ChordTarget next;
+  bool chord = command != nullptr && chordFrets(*command, frets);
+  if (chord)
+    chordTargetFromFrets(next, frets);
+
+  uint32_t now = millis();
+  CheckReport missed = {};
+  CheckReport report;
+
+  portENTER_CRITICAL(&checkLock);
+  if (hasTarget && touched && !solved)
+  {
+    missed.send = true;
+    missed.state = CHECK_MISSED;
+    missed.correct = reportedCorrect;
+    missed.fingers = target.fingerCount;
+    missed.wrong = reportedWrong;
+    missed.elapsedMs = elapsedSinceShown(now);
+  }
+
+  // A chord with only open strings has nothing to press
+  hasTarget = chord && next.fingerCount > 0;
+  if (hasTarget)
+    target = next;
+  shownAt = now;
+  touched = false;
+  solved = false;
+  reportedCorrect = 0;
+  reportedWrong = 0;
+  evaluate(now, report);
+  portEXIT_CRITICAL(&checkLock);
+
+  sendReport(missed);
+  sendReport(report);
+}
+
+void chordCheckTouch(const CellMask &pressed)
+{
+  CheckReport report;
+
+  portENTER_CRITICAL(&checkLock);
+  lastPressed = pressed;
+  evaluate(millis(), report);
+  portEXIT_CRITICAL(&checkLock);
+
+  sendReport(report);
+  if (feedbackChanged.load())
+    requestFrame();
+}
+
+bool chordCheckFeedbackChanged()
+{
+  return feedbackChanged.exchange(false);
+}
+
+void chordCheckPaint()
+{
+  portENTER_CRITICAL(&checkLock);
+  CellMask missing = feedbackMissing;
+  CellMask wrong = feedbackWrong;
+  portEXIT_CRITICAL(&checkLock);
+
+  convertMaskToPixels(missing, CHECK_COLOR_MISSING);
+  convertMaskToPixels(wrong, CHECK_COLOR_WRONG);
+}
@@ -0,0 +1,359 @@
+#include <Arduino.h>
+#include <atomic>
+#include <math.h>
+#include <string.h>
+#include "chord_listen.h"
+#include "main.h"
+#include "shape_index.h"
+#include "event_stream.h"
+
+static_assert(CHORD_FRAME_SAMPLES <= FFT_SIZE, "the chord frame must fit the FFT");
+static_assert(AUDIO_BLOCK_SAMPLES % CHORD_ONSET_CHUNK == 0, "onset chunks must tile a block");
+static_assert(CHORD_MIN_BIN >= 1 && CHORD_FIT_BINS < FFT_BINS, "fit range outside the spectrum");
+static_assert(CHORD_FIT_BINS <= 256, "fit bins are stored in a byte");
+static_assert(2 * FFT_SIZE < CHORD_MIN_FRAME_SAMPLES * (CHORD_LOBE_BINS / 2 - 1),
+              "the shortest frame's main lobe must fit CHORD_LOBE_BINS");
+
+#define CHORD_MAX_PARTIALS 400 // harmonics below CHORD_MAX_HZ of every note: 381
+
+// Chord on the LEDs, written by the render task
+static std::atomic<PitchClassSet> targetChord(0);
+
+// Audio task only
+static ChordListenState listenState;
+
+// The notes' harmonic series and the noise bumps, which do not depend on
+// the frame length
+struct ChordTemplates
+{
+  uint16_t firstPartial[CHORD_NOTES + 1];
+  uint8_t bin[CHORD_MAX_PARTIALS];   // first lobe bin
+  uint8_t phase[CHORD_MAX_PARTIALS]; // lobe shape, by the partial's position within its bin
+  float weight[CHORD_MAX_PARTIALS];  // 1/h
+  float noise[CHORD_NOISE_ATOMS][CHORD_FIT_BINS];
+
+  ChordTemplates()
+  {
+    const double binHz = (double)AUDIO_SAMPLE_RATE / FFT_SIZE;
+    int partials = 0;
+    for (int note = 0; note < CHORD_NOTES; note++)
+    {
+      firstPartial[note] = (uint16_t)partials;
+      double fundamental = 440.0 * pow(2.0, (CHORD_LOW_NOTE + note - 69) / 12.0);
+      for (int harmonic = 1; harmonic * fundamental <= CHORD_MAX_HZ && partials < CHORD_MAX_PARTIALS; harmonic++)
+      {
+        double position = harmonic * fundamental / binHz;
+        int whole = (int)floor(position);
+        int step = (int)lround((position - whole) * CHORD_LOBE_PHASES);
+        if (step == CHORD_LOBE_PHASES)
+        {
+          whole++;
+          step = 0;
+        }
+        bin[partials] = (uint8_t)(whole - (CHORD_LOBE_BINS / 2 - 1));
+        phase[partials] = (uint8_t)step;
+        weight[partials] = 1.0f / harmonic;
+        partials++;
+      }
+    }
+    firstPartial[CHORD_NOTES] = (uint16_t)partials;
+
+    // Gaussian bumps evenly spaced in log frequency, each summing to 1
+    double low = log((double)CHORD_MIN_HZ);
+    double width = (log((double)CHORD_MAX_HZ) - low) / CHORD_NOISE_ATOMS;
+    for (int atom = 0; atom < CHORD_NOISE_ATOMS; atom++)
+    {
+      double centre = low + (atom + 0.5) * width;
+      double sum = 0;
+      for (int k = 0; k < CHORD_FIT_BINS; k++)
+      {
+        double x = k >= CHORD_MIN_BIN && k <= CHORD_MAX_BIN ? (log(k * binHz) - centre) / width : 1e3;
+        noise[atom][k] = (float)exp(-x * x);
+        sum += noise[atom][k];
+      }
+      for (int k = 0; k < CHORD_FIT_BINS; k++)
+        noise[atom][k] = (float)(noise[atom][k] / sum);
+    }
+  }
+};
+
+static const ChordTemplates &chordTemplates()
+{
+  static const ChordTemplates templates;
+  return templates;
+}
+
+void chordListenStateReset(ChordListenState &state)
+{
+  memset(state.history, 0, sizeof(state.history));
+  state.level = 0;
+  state.pending = -1;
+  state.refractory = 0;
+}
+
+// Magnitude of a Hann window's transform at distance bins (of a frame as
+// long as the window), 1 at the centre; only the main lobe is kept
+static float hannLobe(float distance)
+{
+  float x = fabsf(distance);
+  if (x >= 2)
+    return 0;
+  if (x < 1e-4f)
+    return 1;
+  if (fabsf(x - 1) < 1e-4f)
+    return 0.5f;
+  return fabsf(sinf((float)M_PI * x) / ((float)M_PI * x) / (1 - x * x));
+}
+
+// Main lobe per partial position for a samples-long frame zero-padded to
+// FFT_SIZE, and each note's template sum within the fit range
+static void buildLobes(ChordListenState &state, const ChordTemplates &templates, int samples)
+{
+  float binsPerBin = (float)samples / FFT_SIZE;
+  for (int step = 0; step < CHORD_LOBE_PHASES; step++)
+  {
+    for (int j = 0; j < CHORD_LOBE_BINS; j++)
+    {
+      float distance = j - (CHORD_LOBE_BINS / 2 - 1) - (float)step / CHORD_LOBE_PHASES;
+      state.lobe[step][j] = hannLobe(distance * binsPerBin);
+    }
+  }
+
+  for (int note = 0; note < CHORD_NOTES; note++)
+  {
+    float sum = 0;
+    for (int p = templates.firstPartial[note]; p < templates.firstPartial[note + 1]; p++)
+    {
+      for (int j = 0; j < CHORD_LOBE_BINS; j++)
+      {
+        int k = templates.bin[p] + j;
+        if (k >= CHORD_MIN_BIN && k <= CHORD_MAX_BIN)
+          sum += templates.weight[p] * state.lobe[templates.phase[p]][j];
+      }
+    }
+    state.noteNorm[note] = sum > 0 ? sum : 1;
+  }
+}
+
+void chordChroma(ChordListenState &state, const int16_t *frame, int samples, float *chroma)
+{
+  // Hann window over this frame's length
+  float step = 2 * (float)M_PI / samples;
+  for (int i = 0; i < samples; i++)
+    state.spectrum[i] = frame[i] * (0.5f - 0.5f * cosf(step * i));
+  for (int i = samples; i < FFT_SIZE; i++)
+    state.spectrum[i] = 0;
+  realFft(state.spectrum);
+  fftPower(state.spectrum, state.power);
+
+  for (int pitchClass = 0; pitchClass < 12; pitchClass++)
+    chroma[pitchClass] = 0;
+
+  // Magnitude within the fit range, zero past it so lobes reaching out of
+  // the range do not count
+  float *magnitude = state.power;
+  float total = 0;
+  for (int k = 0; k < CHORD_FIT_BINS; k++)
+  {
+    magnitude[k] = k >= CHORD_MIN_BIN && k <= CHORD_MAX_BIN ? sqrtf(magnitude[k]) : 0;
+    total += magnitude[k];
+  }
+  if (total <= 0)
+    return;
+
+  const ChordTemplates &templates = chordTemplates();
+  buildLobes(state, templates, samples);
+  const int atoms = CHORD_NOTES + CHORD_NOISE_ATOMS;
+  for (int atom = 0; atom < atoms; atom++)
+    state.activation[atom] = total / atoms;
+
+  // Templates are normalised to sum 1, so each KL update is the activation
+  // times its template's correlation with data / fit
+  float *model = state.model;
+  for (int iteration = 0; iteration < CHORD_FIT_ITERATIONS; iteration++)
+  {
+    for (int k = 0; k < CHORD_FIT_BINS; k++)
+      model[k] = 1e-9f;
+    for (int note = 0; note < CHORD_NOTES; note++)
+    {
+      float scale = state.activation[note] / state.noteNorm[note];
+      for (int p = templates.firstPartial[note]; p < templates.firstPartial[note + 1]; p++)
+      {
+        const float *lobe = state.lobe[templates.phase[p]];
+        float *out = model + templates.bin[p];
+        float amount = scale * templates.weight[p];
+        for (int j = 0; j < CHORD_LOBE_BINS; j++)
+          out[j] += amount * lobe[j];
+      }
+    }
+    for (int atom = 0; atom < CHORD_NOISE_ATOMS; atom++)
+    {
+      float amount = state.activation[CHORD_NOTES + atom];
+      for (int k = CHORD_MIN_BIN; k <= CHORD_MAX_BIN; k++)
+        model[k] += amount * templates.noise[atom][k];
+    }
+
+    for (int k = 0; k < CHORD_FIT_BINS; k++)
+      model[k] = magnitude[k] / model[k];
+
+    for (int note = 0; note < CHORD_NOTES; note++)
+    {
+      float correlation = 0;
+      for (int p = templates.firstPartial[note]; p < templates.firstPartial[note + 1]; p++)
+      {
+        const float *lobe = state.lobe[templates.phase[p]];
+        const float *ratio = model + templates.bin[p];
+        float sum = 0;
+        for (int j = 0; j < CHORD_LOBE_BINS; j++)
+          sum += lobe[j] * ratio[j];
+        correlation += templates.weight[p] * sum;
+      }
+      float gain = correlation / state.noteNorm[note];
+      state.activation[note] *= gain * gain;
+    }
+    for (int atom = 0; atom < CHORD_NOISE_ATOMS; atom++)
+    {
+      float correlation = 0;
+      for (int k = CHORD_MIN_BIN; k <= CHORD_MAX_BIN; k++)
+        correlation += templates.noise[atom][k] * model[k];
+      state.activation[CHORD_NOTES + atom] *= correlation * correlation;
+    }
+  }
+
+  for (int note = 0; note < CHORD_NOTES; note++)
+    chroma[(CHORD_LOW_NOTE + note) % 12] += state.activation[note];
+}
+
+uint8_t chordMatchScore(const float *chroma, PitchClassSet chord)
+{
+  float inChord = 0;
+  float total = 0;
+  float strongest = 0;
+  for (int pitchClass = 0; pitchClass < 12; pitchClass++)
+  {
+    total += chroma[pitchClass] * chroma[pitchClass];
+    strongest = chroma[pitchClass] > strongest ? chroma[pitchClass] : strongest;
+    if (pitchSetHas(chord, pitchClass))
+      inChord += chroma[pitchClass];
+  }
+  int notes = pitchSetSize(chord);
+  if (total <= 0 || notes == 0)
+    return 0;
+
+  float covered = 0;
+  for (int pitchClass = 0; pitchClass < 12; pitchClass++)
+  {
+    if (pitchSetHas(chord, pitchClass))
+      covered += fminf(1.0f, chroma[pitchClass] / (strongest * CHORD_HEARD_RATIO));
+  }
+  float cosine = inChord / sqrtf(total * notes);
+  return (uint8_t)lroundf(cosine * covered / notes * 100);
+}
+
+static uint32_t blockEnergy(const int16_t *samples, int count)
+{
+  uint32_t energy = 0;
+  for (int i = 0; i < count; i++)
+    energy += (uint32_t)(samples[i] * samples[i]); // 256 x 2047^2 fits 32 bits
+  return energy;
+}
+
+// Samples into the onset block where the strum starts: the first chunk
+// whose energy jumps CHORD_ONSET_RATIO over the block before's, per chunk
+static int strumStart(const int16_t *before, const int16_t *onsetBlock)
+{
+  const int chunks = AUDIO_BLOCK_SAMPLES / CHORD_ONSET_CHUNK;
+  uint64_t level = blockEnergy(before, AUDIO_BLOCK_SAMPLES) / chunks;
+  uint64_t quietest = (uint64_t)CHORD_MIN_RMS * CHORD_MIN_RMS * CHORD_ONSET_CHUNK / 4;
+  for (int chunk = 0; chunk < chunks; chunk++)
+  {
+    uint32_t energy = blockEnergy(onsetBlock + chunk * CHORD_ONSET_CHUNK, CHORD_ONSET_CHUNK);
+    if (energy >= level * CHORD_ONSET_RATIO + quietest)
+      return chunk * CHORD_ONSET_CHUNK;
+  }
+  return 0;
+}
+
+bool chordListenAnalyze(ChordListenState &state, const int16_t *block, PitchClassSet chord, ChordMatch *match)
+{
+  const int keep = CHORD_HISTORY_SAMPLES - AUDIO_BLOCK_SAMPLES;
+  memmove(state.history, state.history + AUDIO_BLOCK_SAMPLES, keep * sizeof(int16_t));
+  memcpy(state.history + keep, block, AUDIO_BLOCK_SAMPLES * sizeof(int16_t));
+
+  uint32_t energy = blockEnergy(block, AUDIO_BLOCK_SAMPLES);
+  bool onset = state.refractory == 0 && energy >= (uint32_t)CHORD_MIN_RMS * CHORD_MIN_RMS * AUDIO_BLOCK_SAMPLES &&
+               energy >= (uint64_t)state.level * CHORD_ONSET_RATIO;
+  state.level += ((int32_t)energy - (int32_t)state.level) >> CHORD_LEVEL_SHIFT;
+  if (state.refractory > 0)
+    state.refractory--;
+
+  if (onset)
+  {
+    state.pending = CHORD_DECIDE_BLOCKS;
+    state.refractory = CHORD_REFRACTORY_BLOCKS;
+  }
+  else if (state.pending > 0)
+  {
+    state.pending--;
+  }
+  if (state.pending != 0)
+    return false;
+  state.pending = -1;
+
+  // history: the block before the onset block, the onset block, the rest
+  const int16_t *onsetBlock = state.history + AUDIO_BLOCK_SAMPLES;
+  int start = strumStart(state.history, onsetBlock);
+  match->frameSamples = (uint16_t)(CHORD_FRAME_SAMPLES - start);
+  chordChroma(state, onsetBlock + start, match->frameSamples, match->chroma);
+
+  float strongest = 0;
+  for (int pitchClass = 0; pitchClass < 12; pitchClass++)
+    strongest = match->chroma[pitchClass] > strongest ? match->chroma[pitchClass] : strongest;
+  match->heard = 0;
+  for (int pitchClass = 0; pitchClass < 12; pitchClass++)
+  {
+    if (strongest > 0 && match->chroma[pitchClass] >= strongest * CHORD_HEARD_RATIO)
+      match->heard |= (PitchClassSet)(1u << pitchClass);
+  }
+  match->score = chordMatchScore(match->chroma, chord);
+  return true;
+}
+
+PitchClassSet chordCommandPitchSet(const PixelCommand &command)
+{
+  if (command.type == CMD_SHAPE && isChordShape(command.shapeType))
+    return chordPitchSet(command.root, command.shapeType & ~SHAPE_CHORD_FLAG);
+  if (command.type != CMD_CHORD)
+    return 0;
+
+  PitchClassSet set = 0;
+  for (int string = 0; string < NUM_STRINGS; string++)
+  {
+    if (command.frets[string] >= 0)
+      set |= (PitchClassSet)(1u << ((guitarStrings[string] + command.frets[string]) % 12));
+  }
+  return set;
+}
+
+void chordListenNewTarget(const PixelCommand *command)
+{
+  targetChord.store(command != nullptr ? chordCommandPitchSet(*command) : 0);
+}
+
+void resetChordListen()
+{
+  chordListenStateReset(listenState);
+}
+
+void chordListenProcessBlock(const int16_t *block)
+{
+  // The block was complete when the read returned
+  uint32_t blockEnd = millis();
+  PitchClassSet chord = targetChord.load();
+  ChordMatch match;
+  if (!chordListenAnalyze(listenState, block, chord, &match))
+    return;
+
+  uint32_t latency = millis() - blockEnd + match.frameSamples * 1000u / AUDIO_SAMPLE_RATE;
+  eventChordMatch(match.score, match.heard, chord, (uint8_t)(latency > 255 ? 255 : latency));
+}
@@ -0,0 +1,262 @@
+#include <Arduino.h>
+#include <string.h>
+#include "chord_voicing.h"
+#include "main.h"
+#include "guitar_tuning.h"
+
+struct VoicingSearch
+{
+  PitchClassSet chord;
+  PitchClassSet required; // tones every voicing must have
+  int root;
+  int minStrings;
+  int capo;
+  const uint8_t *openMidi;
+  int8_t frets[NUM_STRINGS]; // the path being searched
+  VoicingSet *set;
+  uint32_t nodes;
+};
+
+// What the strings below the current one add up to
+struct PartialVoicing
+{
+  int sounding;
+  int muted;
+  bool closed; // a string was muted above the sounding ones: the rest are muted too
+  PitchClassSet tones;
+  int lowFret;       // fretted notes only, those above the capo
+  int highFret;
+  uint32_t fretsUsed; // bit per fret with a fretted note: each takes a finger or the barre
+};
+
+struct VoicingCacheEntry
+{
+  uint32_t lastUsed; // 0: empty
+  uint8_t root;
+  uint8_t chordId;
+  uint8_t capo;
+  uint8_t openMidi[NUM_STRINGS];
+  VoicingSet set;
+};
+
+static VoicingCacheEntry voicingCache[VOICING_CACHE_SIZE];
+static uint32_t voicingClock = 0;
+static const VoicingSet noVoicings = {};
+
+static int bitCount(uint32_t bits)
+{
+  return __builtin_popcount(bits);
+}
+
+// No voicing completing this one costs less; every term only grows
+static int costLowerBound(const VoicingSearch &search, const PartialVoicing &partial, int stringsLeft)
+{
+  int cost = 2 * partial.muted + bitCount(partial.fretsUsed);
+  if (partial.closed)
+    cost += 2 * stringsLeft + 2 * pitchSetSize(search.chord & ~partial.tones);
+  if (partial.fretsUsed != 0)
+  {
+    int lowest = partial.highFret - VOICING_MAX_SPAN; // where the hand can reach down to
+    cost += (partial.highFret - partial.lowFret) + (lowest > search.capo ? lowest - search.capo : 0);
+  }
+  return cost;
+}
+
+static int worstKept(const VoicingSet &set)
+{
+  return set.count < VOICING_MAX_RESULTS ? 0x7FFFFFFF : set.voicings[VOICING_MAX_RESULTS - 1].cost;
+}
+
+// Check a complete voicing and keep it if it is among the easiest so far
+static void finishVoicing(VoicingSearch &search, const PartialVoicing &partial)
+{
+  if ((search.required & ~partial.tones) != 0 || partial.sounding < search.minStrings)
+    return;
+
+  // Root in the bass: the lowest pitch, which on close tunings need not be
+  // the lowest string
+  int bass = 0x7FFFFFFF;
+  int fretted = 0;
+  int aboveLowest = 0;
+  for (int string = 0; string < NUM_STRINGS; string++)
+  {
+    int fret = search.frets[string];
+    if (fret == VOICING_MUTED)
+      continue;
+    int pitch = search.openMidi[string] + fret;
+    bass = pitch < bass ? pitch : bass;
+    if (fret > search.capo)
+    {
+      fretted++;
+      aboveLowest += fret > partial.lowFret;
+    }
+  }
+  if (bass % 12 != search.root)
+    return;
+
+  // More fretted notes than fingers: the lowest fret has to be barred, from
+  // its first string to its last with no open string in between
+  int barre = 0;
+  int fingers = fretted;
+  if (fretted > VOICING_MAX_FINGERS)
+  {
+    int first = -1;
+    int last = -1;
+    for (int string = 0; string < NUM_STRINGS; string++)
+    {
+      if (search.frets[string] == partial.lowFret)
+      {
+        first = first < 0 ? string : first;
+        last = string;
+      }
+    }
+    for (int string = first; string <= last; string++)
+    {
+      if (search.frets[string] == search.capo)
+        return; // an open string under the barre
+    }
+    barre = partial.lowFret;
+    fingers = 1 + aboveLowest;
+    if (first == last || fingers > VOICING_MAX_FINGERS)
+      return;
+  }
+
+  int cost = 2 * partial.muted + 2 * pitchSetSize(search.chord & ~partial.tones) + fingers + (barre != 0 ? 2 : 0);
+  if (fretted > 0)
+    cost += (partial.lowFret - search.capo) + (partial.highFret - partial.lowFret);
+  cost = cost > 255 ? 255 : cost;
+  if (cost >= worstKept(*search.set))
+    return;
+
+  // Insert after the voicings that cost the same: the search tries lower frets first
+  VoicingSet &set = *search.set;
+  int at = set.count < VOICING_MAX_RESULTS ? set.count : VOICING_MAX_RESULTS - 1;
+  while (at > 0 && set.voicings[at - 1].cost > cost)
+  {
+    set.voicings[at] = set.voicings[at - 1];
+    at--;
+  }
+  ChordVoicing &voicing = set.voicings[at];
+  memcpy(voicing.frets, search.frets, sizeof(voicing.frets));
+  voicing.barre = (uint8_t)barre;
+  voicing.fingers = (uint8_t)fingers;
+  voicing.cost = (uint8_t)cost;
+  if (set.count < VOICING_MAX_RESULTS)
+    set.count++;
+}
+
+static void searchString(VoicingSearch &search, int string, const PartialVoicing &partial)
+{
+  search.nodes++;
+  int stringsLeft = NUM_STRINGS - string;
+  if (costLowerBound(search, partial, stringsLeft) >= worstKept(*search.set))
+    return;
+  if (stringsLeft == 0)
+  {
+    finishVoicing(search, partial);
+    return;
+  }
+
+  int playable = partial.closed ? 0 : stringsLeft;
+  if (pitchSetSize(search.required & ~partial.tones) > playable || partial.sounding + playable < search.minStrings)
+    return;
+
+  for (int fret = search.capo; fret < FRETBOARD_FRETS && !partial.closed; fret++)
+  {
+    int pitchClass = (search.openMidi[string] + fret) % 12;
+    if (!pitchSetHas(search.chord, pitchClass))
+      continue;
+    if (partial.sounding == 0 && pitchClass != search.root)
+      continue; // the lowest string sounding carries the root
+
+    PartialVoicing next = partial;
+    if (fret > search.capo)
+    {
+      next.lowFret = partial.fretsUsed == 0 || fret < partial.lowFret ? fret : partial.lowFret;
+      next.highFret = partial.fretsUsed == 0 || fret > partial.highFret ? fret : partial.highFret;
+      next.fretsUsed |= 1u << fret;
+      if (next.highFret - next.lowFret > VOICING_MAX_SPAN)
+      {
+        if (fret > next.lowFret)
+          break; // higher frets only stretch further
+        continue;
+      }
+      if (bitCount(next.fretsUsed) > VOICING_MAX_FINGERS)
+        continue;
+    }
+    next.sounding++;
+    next.tones |= (PitchClassSet)(1u << pitchClass);
+    search.frets[string] = (int8_t)fret;
+    searchString(search, string + 1, next);
+  }
+
+  PartialVoicing next = partial;
+  next.muted++;
+  next.closed = partial.sounding > 0;
+  search.frets[string] = VOICING_MUTED;
+  searchString(search, string + 1, next);
+}
+
+uint32_t solveVoicings(PitchClassSet chord, int root, const uint8_t *openMidi, int capo, VoicingSet &set)
+{
+  set.count = 0;
+
+  VoicingSearch search;
+  search.chord = chord;
+  search.required = chord;
+  int size = pitchSetSize(chord);
+  PitchClassSet fifth = (PitchClassSet)(1u << ((root + 7) % 12));
+  if (size >= 4 && (chord & fifth) != 0)
+    search.required &= ~fifth;
+  search.root = root;
+  search.minStrings = size + 1 < VOICING_MIN_STRINGS ? size + 1 : VOICING_MIN_STRINGS;
+  search.capo = capo;
+  search.openMidi = openMidi;
+  search.set = &set;
+  search.nodes = 0;
+  if (!pitchSetHas(chord, root))
+    return 0;
+
+  PartialVoicing start = {};
+  searchString(search, 0, start);
+  return search.nodes;
+}
+
+const VoicingSet &chordVoicings(int root, int chordId)
+{
+  if (root < 0 || root >= 12 || chordId < 0 || chordId >= CHORD_TYPE_COUNT)
+    return noVoicings;
+
+  uint8_t openMidi[NUM_STRINGS];
+  for (int string = 0; string < NUM_STRINGS; string++)
+    openMidi[string] = (uint8_t)openStringMidi[string];
+  int capo = tuningCapo();
+
+  // Hit, or the least recently used entry to replace
+  VoicingCacheEntry *victim = &voicingCache[0];
+  for (VoicingCacheEntry &entry : voicingCache)
+  {
+    if (entry.lastUsed != 0 && entry.root == root && entry.chordId == chordId && entry.capo == capo &&
+        memcmp(entry.openMidi, openMidi, sizeof(openMidi)) == 0)
+    {
+      entry.lastUsed = ++voicingClock;
+      return entry.set;
+    }
+    if (entry.lastUsed < victim->lastUsed)
+      victim = &entry;
+  }
+
+  victim->root = (uint8_t)root;
+  victim->chordId = (uint8_t)chordId;
+  victim->capo = (uint8_t)capo;
+  memcpy(victim->openMidi, openMidi, sizeof(openMidi));
+  solveVoicings(chordPitchSet(root, chordId), root, openMidi, capo, victim->set);
+  victim->lastUsed = ++voicingClock;
+  return victim->set;
+}
+
+void clearVoicingCache()
+{
+  for (VoicingCacheEntry &entry : voicingCache)
+    entry.lastUsed = 0;
+}
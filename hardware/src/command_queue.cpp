@@ -0,0 +1,30 @@
+#include <atomic>
+#include "command_queue.h"
+
+// Three slots: one owned by the producer, one by the consumer, and one in the
+// middle holding the newest finished command. Swaps go through `middle`,
+// whose MAILBOX_FRESH bit says the middle slot has not been taken yet.
+#define MAILBOX_FRESH 0x4
+
+void commandMailboxPut(CommandMailbox &mailbox, const PixelCommand &command)
+{
+  mailbox.slots[mailbox.back] = command;
+  // Publish the filled slot and take back whatever was in the middle
+  uint8_t previous = mailbox.middle.exchange(mailbox.back | MAILBOX_FRESH, std::memory_order_acq_rel);
+  mailbox.back = previous & ~MAILBOX_FRESH;
+  if ((previous & MAILBOX_FRESH) != 0)
+    mailbox.replaced.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool commandMailboxTake(CommandMailbox &mailbox, PixelCommand *command, int *replaced)
+{
+  if ((mailbox.middle.load(std::memory_order_relaxed) & MAILBOX_FRESH) == 0)
+    return false;
+
+  // A put racing with this take may count its replacement one take late
+  *replaced = mailbox.replaced.exchange(0, std::memory_order_relaxed);
+  uint8_t latest = mailbox.middle.exchange(mailbox.front, std::memory_order_acq_rel);
+  mailbox.front = latest & ~MAILBOX_FRESH;
+  *command = mailbox.slots[mailbox.front];
+  return true;
+}
@@ -1,143 +1,254 @@
 #include <Arduino.h>
 #include "data_handling.h"
+#include "trace_log.h"
 
-// Helper function to parse string (simple tokenizer)
-// Parse a comma-separated string into tokens, handling optional [ ] brackets
-// tokens: pre-allocated String array to store tokens
-// maxTokens: maximum number of tokens the array can hold
-// tokenCount: pointer to integer to store the number of tokens found
-int parseChordCommand(String value, int *tokens, int maxTokens)
+// Largest magnitude accepted for a single number; frets and strings are far smaller
+#define MAX_NUMBER_DIGITS 4
+
+// States of the tokenizer shared by the chord and scale parsers
+enum TokenizerState
+{
+    STATE_START,         // nothing read yet
+    STATE_FIRST_BRACKET, // read the first '[' - outer list or first pair
+    STATE_GROUP_OPEN,    // expecting the '[' that opens a pair
+    STATE_VALUE,         // expecting the first character of a number
+    STATE_NUMBER,        // inside a number
+    STATE_AFTER_VALUE,   // expecting ',' or ']' after a number
+    STATE_AFTER_GROUP,   // expecting ',' or the outer ']' after a pair
+    STATE_END            // list closed, only whitespace may follow
+};
+
+static bool isSpace(char c)
 {
-    // Initialize token count
-    int tokenCount = 0;
-    Serial.print(value);
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
 
-    // Check for empty or invalid input
-    if (value.length() == 0)
-    {
-        // Serial.println(" - Empty command");
-        return 0;
-    }
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
 
-    int start = 0;
-    int end = value.indexOf(',');
+// Number being accumulated by the tokenizer
+struct NumberToken
+{
+    int value;
+    int digits;
+    bool negative;
+};
 
-    // Skip opening bracket if present
-    if (value.startsWith("["))
-    {
-        // Serial.println(" - Skipping opening bracket");
-        start = 1;
-    }
+static void beginNumber(NumberToken &number, char c)
+{
+    number.negative = (c == '-');
+    number.value = number.negative ? 0 : (c - '0');
+    number.digits = number.negative ? 0 : 1;
+}
 
-    while (end != -1 && tokenCount < maxTokens)
-    {
-        String temp = value.substring(start, end);
-        temp.trim();
-        tokens[tokenCount] = temp.toInt();
-        // Serial.print(" - Found token: ");
-        // Serial.println(temp);
-        tokenCount++;
-        start = end + 1;
-        end = value.indexOf(',', start);
-    }
+// Store a finished number; fails on a lone '-' or when the output is full
+static bool storeNumber(const NumberToken &number, int *out, int maxValues, int &count)
+{
+    if (number.digits == 0 || count >= maxValues)
+        return false;
+    out[count++] = number.negative ? -number.value : number.value;
+    return true;
+}
+
+// Single-pass state machine over a list of integers.
+// grouped = false: "[a, b, c]" or "a, b, c"
+// grouped = true:  "[[a, b], [c, d]]" or "[a, b], [c, d]" (pairs of two non-negative values)
+// Values are written to `out` in order. Returns the number of values, or -1 if
+// the input is malformed or holds more than maxValues values.
+static int tokenizeIntegers(const char *value, size_t length, int *out, int maxValues, bool grouped)
+{
+    TokenizerState state = STATE_START;
+    bool outerOpen = false; // an outer '[' has to be matched by a final ']'
+    int count = 0;
+    int groupFill = 0; // values read inside the current pair
+    NumberToken number = {0, 0, false};
 
-    // Add the last token if there's space
-    if (tokenCount < maxTokens)
+    for (size_t i = 0; i < length && value[i] != '\0'; i++)
     {
-        String lastToken = value.substring(start);
-        lastToken.trim();
-        // Remove closing bracket if present
-        // Serial.println(" - Found last token: " + lastToken + (lastToken.endsWith("]") ? " (with closing bracket)" : ""));
-        if (lastToken.endsWith("]"))
+        char c = value[i];
+
+        if (state == STATE_NUMBER)
         {
-            lastToken = lastToken.substring(0, lastToken.length() - 1);
-            lastToken.trim();
+            if (isDigit(c))
+            {
+                if (++number.digits > MAX_NUMBER_DIGITS)
+                    return -1;
+                number.value = number.value * 10 + (c - '0');
+                continue;
+            }
+            if (!storeNumber(number, out, maxValues, count))
+                return -1;
+            groupFill++;
+            state = STATE_AFTER_VALUE; // c is handled below in the new state
+        }
+
+        if (isSpace(c))
+            continue;
+
+        // Scale pairs are a string and a fret, never negative
+        bool numberStart = isDigit(c) || (c == '-' && !grouped);
+        switch (state)
+        {
+        case STATE_START:
+            if (c == '[')
+            {
+                state = STATE_FIRST_BRACKET;
+            }
+            else if (numberStart && !grouped)
+            {
+                beginNumber(number, c);
+                state = STATE_NUMBER;
+            }
+            else
+            {
+                return -1;
+            }
+            break;
+
+        case STATE_FIRST_BRACKET:
+            if (c == ']')
+            {
+                // "[]" - empty list
+                outerOpen = true;
+                state = STATE_END;
+            }
+            else if (grouped && c == '[')
+            {
+                outerOpen = true;
+                groupFill = 0;
+                state = STATE_VALUE;
+            }
+            else if (numberStart)
+            {
+                // Ungrouped: the bracket was the outer list. Grouped: it opened the first pair.
+                outerOpen = !grouped;
+                groupFill = 0;
+                beginNumber(number, c);
+                state = STATE_NUMBER;
+            }
+            else
+            {
+                return -1;
+            }
+            break;
+
+        case STATE_GROUP_OPEN:
+            if (c != '[')
+                return -1;
+            groupFill = 0;
+            state = STATE_VALUE;
+            break;
+
+        case STATE_VALUE:
+            if (!numberStart)
+                return -1;
+            beginNumber(number, c);
+            state = STATE_NUMBER;
+            break;
+
+        case STATE_AFTER_VALUE:
+            if (c == ',')
+            {
+                if (grouped && groupFill >= 2)
+                    return -1;
+                state = STATE_VALUE;
+            }
+            else if (c == ']' && grouped)
+            {
+                if (groupFill != 2)
+                    return -1;
+                state = STATE_AFTER_GROUP;
+            }
+            else if (c == ']' && outerOpen)
+            {
+                state = STATE_END;
+            }
+            else
+            {
+                return -1;
+            }
+            break;
+
+        case STATE_AFTER_GROUP:
+            if (c == ',')
+                state = STATE_GROUP_OPEN;
+            else if (c == ']' && outerOpen)
+                state = STATE_END;
+            else
+                return -1;
+            break;
+
+        default:
+            // Anything but whitespace after the closing bracket
+            return -1;
         }
-        tokens[tokenCount] = lastToken.toInt();
-        // Serial.print(" - Found last token: ");
-        // Serial.println(lastToken);
-        tokenCount++;
     }
 
-    Serial.print("Parsed tokens: ");
-    for (int i = 0; i < tokenCount; i++)
+    // End of input: close a pending number, then check the list was complete
+    if (state == STATE_NUMBER)
     {
-        Serial.print(tokens[i]);
-        if (i < tokenCount - 1)
-            Serial.print(", ");
+        if (!storeNumber(number, out, maxValues, count))
+            return -1;
+        groupFill++;
+        state = STATE_AFTER_VALUE;
     }
-    Serial.println();
 
-    return tokenCount; // Return the actual token count
+    if (state == STATE_END)
+        return count;
+    if (!outerOpen && !grouped && state == STATE_AFTER_VALUE)
+        return count;
+    if (!outerOpen && grouped && state == STATE_AFTER_GROUP)
+        return count;
+    return -1;
 }
 
-int parseScaleCommand(String value, int scaleData[][2], int maxPairs)
+// Parse a comma-separated string into tokens, handling optional [ ] brackets
+// tokens: pre-allocated int array to store tokens
+// maxTokens: maximum number of tokens the array can hold
+// Returns the number of tokens found
+int parseChordCommand(const char *value, size_t length, int *tokens, int maxTokens)
 {
-    int pairCount = 0;
-    Serial.print("Parsing scale command: ");
-    Serial.println(value);
-
     // Check for empty or invalid input
-    if (value.length() == 0)
+    if (value == nullptr || length == 0)
     {
-        Serial.println(" - Empty scale command");
         return 0;
     }
 
-    // Remove outer brackets if present
-    String cleanValue = value;
-    cleanValue.trim();
-    if (cleanValue.startsWith("[") && cleanValue.endsWith("]"))
+    int tokenCount = tokenizeIntegers(value, length, tokens, maxTokens, false);
+    if (tokenCount < 0)
     {
-        cleanValue = cleanValue.substring(1, cleanValue.length() - 1);
-        cleanValue.trim();
+        LOG_WARN(TRACE_CHORD_MALFORMED);
+        return 0;
     }
 
-    // Parse nested arrays like [5, 5], [5, 7], [5, 9]
-    int start = 0;
-    while (start < cleanValue.length() && pairCount < maxPairs)
+    if (tokenCount == 6)
     {
-        // Find start of next pair
-        int pairStart = cleanValue.indexOf('[', start);
-        if (pairStart == -1)
-            break;
-
-        // Find end of current pair
-        int pairEnd = cleanValue.indexOf(']', pairStart);
-        if (pairEnd == -1)
-            break;
+        LOG_DEBUG(TRACE_CHORD_PARSED, tokens[0], tokens[1], tokens[2], tokens[3], tokens[4], tokens[5]);
+    }
 
-        // Extract pair content
-        String pairContent = cleanValue.substring(pairStart + 1, pairEnd);
-        pairContent.trim();
+    return tokenCount; // Return the actual token count
+}
 
-        // Parse the two integers in the pair
-        int commaPos = pairContent.indexOf(',');
-        if (commaPos != -1)
-        {
-            String firstNum = pairContent.substring(0, commaPos);
-            String secondNum = pairContent.substring(commaPos + 1);
-            firstNum.trim();
-            secondNum.trim();
-
-            scaleData[pairCount][0] = firstNum.toInt();  // string
-            scaleData[pairCount][1] = secondNum.toInt(); // fret
-
-            Serial.print("Parsed pair ");
-            Serial.print(pairCount);
-            Serial.print(": [");
-            Serial.print(scaleData[pairCount][0]);
-            Serial.print(", ");
-            Serial.print(scaleData[pairCount][1]);
-            Serial.println("]");
-
-            pairCount++;
-        }
+int parseScaleCommand(const char *value, size_t length, int scaleData[][2], int maxPairs)
+{
+    // Check for empty or invalid input
+    if (value == nullptr || length == 0)
+    {
+        LOG_WARN(TRACE_SCALE_EMPTY);
+        return 0;
+    }
 
-        start = pairEnd + 1;
+    // scaleData rows are contiguous, so the pairs can be filled as a flat array
+    int valueCount = tokenizeIntegers(value, length, &scaleData[0][0], maxPairs * 2, true);
+    if (valueCount < 0)
+    {
+        LOG_WARN(TRACE_SCALE_MALFORMED);
+        return 0;
     }
 
-    Serial.print("Total parsed scale pairs: ");
-    Serial.println(pairCount);
+    int pairCount = valueCount / 2;
+    LOG_DEBUG(TRACE_SCALE_PARSED, pairCount);
     return pairCount;
 }
@@ -0,0 +1,292 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include <atomic>
+#include <esp_timer.h>
+#include "effects.h"
+#include "main.h"
+#include "frame_buffer.h"
+#include "render_task.h"
+#include "shape_index.h"
+#include "tempo_clock.h"
+#include "event_stream.h"
+#include "trace_log.h"
+
+#define NOT_REVEALED 0xFF
+
+// Settings: written by the BLE task, picked up by the render task on its next frame
+static std::atomic<uint16_t> fadeMs(0);
+static std::atomic<uint16_t> revealMs(0);
+static std::atomic<uint16_t> pulseMs(0); // the metronome's tempo lives in the tempo clock
+static std::atomic<uint32_t> settingsVersion(0);
+static std::atomic<uint16_t> loadPeak(0);
+
+// Everything below belongs to the render task
+static esp_timer_handle_t frameTimer = nullptr;
+static bool timerRunning = false;
+static uint32_t appliedVersion = 0;
+static bool composedLast = false; // backBuffer holds an animated frame, not the target
+
+// Transition to the current target, timed from its arrival
+static CRGB target[VALID_LEDS]; // by fret cell
+static CRGB from[VALID_LEDS];   // what the LEDs showed when the target arrived
+static uint8_t revealRank[VALID_LEDS];
+static int revealCount = 0;
+static int64_t targetStart = 0;
+static int64_t fadeDuration = 0; // us, 0 = not fading
+static int64_t revealStep = 0;   // us, 0 = not revealing
+
+// Running effects
+static int64_t pulsePeriod = 0; // us, 0 = off
+static int64_t pulseStart = 0;
+static int64_t beatPeriod = 0;  // us, 0 = off
+static int64_t metronomeStart = 0;
+static uint8_t barLength = 4;
+
+static uint16_t readU16(const uint8_t *data)
+{
+  return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+static void onFrameTimer(void *arg)
+{
+  (void)arg;
+  requestFrame();
+}
+
+void setupEffects()
+{
+  esp_timer_create_args_t args = {};
+  args.callback = onFrameTimer;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "effects";
+  args.skip_unhandled_events = true;
+  esp_timer_create(&args, &frameTimer);
+}
+
+static void settingsChanged()
+{
+  settingsVersion.fetch_add(1);
+  LOG_INFO(TRACE_EFFECTS_SETTINGS, fadeMs.load(), revealMs.load(), pulseMs.load(), tempoClockGrid().bpm,
+           tempoClockGrid().beatsPerBar);
+  requestFrame();
+}
+
+uint8_t effectsHandleFrame(const FrameView &frame)
+{
+  if (frame.opcode != FRAME_OP_EFFECTS || frame.length == 0)
+    return REJECT_MALFORMED;
+
+  const uint8_t *args = frame.payload + 1;
+  size_t argLength = frame.length - 1;
+
+  switch (frame.payload[0])
+  {
+  case EFFECT_OP_TRANSITIONS:
+  {
+    if (argLength != 4)
+      return REJECT_MALFORMED;
+    uint16_t fade = readU16(args);
+    uint16_t reveal = readU16(args + 2);
+    if (fade > EFFECT_MAX_FADE_MS || reveal > EFFECT_MAX_REVEAL_MS)
+      return REJECT_MALFORMED;
+    fadeMs.store(fade);
+    revealMs.store(reveal);
+    break;
+  }
+  case EFFECT_OP_PULSE:
+  {
+    if (argLength != 2)
+      return REJECT_MALFORMED;
+    uint16_t period = readU16(args);
+    if (period != 0 && (period < EFFECT_MIN_PULSE_MS || period > EFFECT_MAX_PULSE_MS))
+      return REJECT_MALFORMED;
+    pulseMs.store(period);
+    break;
+  }
+  case EFFECT_OP_METRONOME:
+  {
+    if (argLength != 3)
+      return REJECT_MALFORMED;
+    uint16_t bpm = readU16(args);
+    if ((bpm != 0 && (bpm < EFFECT_MIN_BPM || bpm > EFFECT_MAX_BPM)) || args[2] == 0 ||
+        args[2] > EFFECT_MAX_BEATS_PER_BAR)
+      return REJECT_MALFORMED;
+    tempoClockSet(bpm, args[2]);
+    break;
+  }
+  default:
+    return REJECT_MALFORMED;
+  }
+
+  settingsChanged();
+  return 0;
+}
+
+void resetEffects()
+{
+  fadeMs.store(0);
+  revealMs.store(0);
+  pulseMs.store(0);
+  tempoClockSet(0, 4);
+  settingsChanged();
+}
+
+// The pulse restarts its phase whenever the settings change; the metronome
+// follows the tempo clock's grid
+static void applySettings(int64_t now)
+{
+  uint32_t version = settingsVersion.load();
+  if (version == appliedVersion)
+    return;
+  appliedVersion = version;
+
+  pulsePeriod = (int64_t)pulseMs.load() * 1000;
+  pulseStart = now;
+  TempoGrid grid = tempoClockGrid();
+  beatPeriod = grid.periodUs;
+  barLength = grid.beatsPerBar;
+  metronomeStart = grid.anchorUs;
+}
+
+// Scales appear in the order they were sent; shapes string by string from
+// the nut, which is the order their notes rise in pitch
+static void rankReveal(const PixelCommand &command)
+{
+  if (command.type == CMD_SCALE)
+  {
+    for (int i = 0; i < command.count; i++)
+    {
+      int cell = command.scaleData[i][1] * NUM_STRINGS + command.scaleData[i][0];
+      if (cell >= 0 && cell < VALID_LEDS && revealRank[cell] == NOT_REVEALED &&
+          target[cell] != CRGB(CRGB::Black))
+        revealRank[cell] = (uint8_t)revealCount++;
+    }
+  }
+  else if (command.type == CMD_SHAPE && !isChordShape(command.shapeType))
+  {
+    for (int string = 0; string < NUM_STRINGS; string++)
+    {
+      for (int cell = string; cell < VALID_LEDS; cell += NUM_STRINGS)
+      {
+        if (target[cell] != CRGB(CRGB::Black))
+          revealRank[cell] = (uint8_t)revealCount++;
+      }
+    }
+  }
+}
+
+void effectsNewTarget(const PixelCommand *command)
+{
+  bool changed = false;
+  for (int cell = 0; cell < VALID_LEDS; cell++)
+  {
+    from[cell] = leds[fretLEDs[cell]];
+    target[cell] = backBuffer[fretLEDs[cell]];
+    revealRank[cell] = NOT_REVEALED;
+    changed |= from[cell] != target[cell];
+  }
+
+  targetStart = esp_timer_get_time();
+  fadeDuration = changed ? (int64_t)fadeMs.load() * 1000 : 0;
+  revealStep = (int64_t)revealMs.load() * 1000;
+  revealCount = 0;
+  if (revealStep > 0 && command != nullptr)
+    rankReveal(*command);
+  if (revealCount == 0)
+    revealStep = 0;
+}
+
+bool effectsCompose(bool redraw)
+{
+  int64_t now = esp_timer_get_time();
+  applySettings(now);
+
+  bool animating = fadeDuration > 0 || revealStep > 0 || pulsePeriod > 0 || beatPeriod > 0;
+  if (!animating && !composedLast && !redraw)
+    return false; // backBuffer already holds the target
+
+  // Work out this frame's levels once; the cell loop is blends and scales only
+  int64_t elapsed = now - targetStart;
+  uint8_t fadeAmount = 255;
+  if (fadeDuration > 0)
+  {
+    if (elapsed >= fadeDuration)
+      fadeDuration = 0; // this frame shows the target
+    else
+      fadeAmount = ease8InOutQuad((uint8_t)(elapsed * 256 / fadeDuration));
+  }
+
+  int revealed = VALID_LEDS;
+  uint8_t revealAmount = 255;
+  if (revealStep > 0)
+  {
+    revealed = (int)(elapsed / revealStep);
+    revealAmount = (uint8_t)(elapsed % revealStep * 256 / revealStep);
+    if (revealed >= revealCount)
+      revealStep = 0;
+  }
+
+  uint8_t pulseLevel = 255;
+  if (pulsePeriod > 0)
+  {
+    uint8_t phase = (uint8_t)((now - pulseStart) * 256 / pulsePeriod);
+    pulseLevel = EFFECT_PULSE_FLOOR + scale8(quadwave8(phase), 255 - EFFECT_PULSE_FLOOR);
+  }
+
+  CRGB flash = CRGB::Black;
+  if (beatPeriod > 0)
+  {
+    int64_t sinceStart = now - metronomeStart;
+    int64_t inBeat = sinceStart % beatPeriod;
+    if (inBeat < EFFECT_FLASH_MS * 1000LL)
+    {
+      bool accent = (sinceStart / beatPeriod) % barLength == 0;
+      flash = accent ? CRGB(EFFECT_FLASH_ACCENT) : CRGB(EFFECT_FLASH_BEAT);
+      flash.nscale8_video((uint8_t)(255 - inBeat * 255 / (EFFECT_FLASH_MS * 1000LL)));
+    }
+  }
+
+  for (int cell = 0; cell < VALID_LEDS; cell++)
+  {
+    CRGB color = target[cell];
+    uint8_t rank = revealRank[cell];
+    if (rank != NOT_REVEALED && rank >= revealed)
+      color = (rank == revealed) ? blend(CRGB(CRGB::Black), color, revealAmount) : CRGB(CRGB::Black);
+    if (pulseLevel != 255)
+      color.nscale8_video(pulseLevel);
+    if (fadeAmount != 255)
+      color = blend(from[cell], color, fadeAmount);
+    if (cell < NUM_STRINGS && color == CRGB(CRGB::Black))
+      color = flash;
+    backBuffer[fretLEDs[cell]] = color;
+  }
+
+  composedLast = fadeDuration > 0 || revealStep > 0 || pulsePeriod > 0 || beatPeriod > 0;
+  return composedLast;
+}
+
+void effectsFrameDone(bool animating, uint32_t frameMicros)
+{
+  if (animating)
+  {
+    uint32_t load = frameMicros * 10000u / EFFECT_FRAME_PERIOD_US;
+    if (load > loadPeak.load(std::memory_order_relaxed))
+      loadPeak.store(load > 0xFFFF ? 0xFFFF : (uint16_t)load, std::memory_order_relaxed);
+  }
+
+  if (animating && !timerRunning)
+  {
+    esp_timer_start_periodic(frameTimer, EFFECT_FRAME_PERIOD_US);
+    timerRunning = true;
+  }
+  else if (!animating && timerRunning)
+  {
+    esp_timer_stop(frameTimer);
+    timerRunning = false;
+  }
+}
+
+uint16_t takeEffectsLoadPeak()
+{
+  return loadPeak.exchange(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,274 @@
+#include <Arduino.h>
+#include <atomic>
+#include "event_stream.h"
+#include "ble_protocol.h"
+#include "bluetooth.h"
+#include "frame_buffer.h"
+#include "render_task.h"
+#include "led_power.h"
+#include "effects.h"
+#include "supervisor.h"
+
+// One queued event: type byte plus its fixed-size body
+struct StreamEvent
+{
+  uint8_t type;
+  uint8_t length;
+  uint8_t body[EVENT_MAX_BODY];
+};
+
+static QueueHandle_t eventQueue = nullptr;
+static TaskHandle_t eventTaskHandle = nullptr;
+static std::atomic<size_t> packetLimit(EVENT_DEFAULT_PACKET);
+static std::atomic<uint16_t> eventsDropped(0);
+static std::atomic<bool> flushNow(false); // an urgent event is queued: skip the batch interval
+
+static void queueEvent(const StreamEvent &event, bool urgent = false)
+{
+  if (eventQueue == nullptr || xQueueSend(eventQueue, &event, 0) != pdTRUE)
+  {
+    eventsDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if (urgent)
+    flushNow.store(true);
+  xTaskNotifyGive(eventTaskHandle);
+}
+
+void eventRenderComplete(uint8_t commandType, int superseded, uint32_t latencyMicros)
+{
+  StreamEvent event;
+  event.type = EVENT_RENDER_COMPLETE;
+  event.length = 6;
+  event.body[0] = commandType;
+  event.body[1] = (uint8_t)(superseded > 255 ? 255 : superseded);
+  frameStoreU32(event.body + 2, latencyMicros);
+  queueEvent(event);
+}
+
+void eventCommandRejected(uint8_t source, uint8_t reason)
+{
+  StreamEvent event;
+  event.type = EVENT_COMMAND_REJECTED;
+  event.length = 2;
+  event.body[0] = source;
+  event.body[1] = reason;
+  queueEvent(event);
+}
+
+void eventSequenceApplied(uint16_t sequence)
+{
+  StreamEvent event;
+  event.type = EVENT_SEQUENCE_APPLIED;
+  event.length = 2;
+  frameStoreU16(event.body, sequence);
+  queueEvent(event);
+}
+
+void eventSequenceStep(uint16_t step)
+{
+  StreamEvent event;
+  event.type = EVENT_SEQUENCE_STEP;
+  event.length = 2;
+  frameStoreU16(event.body, step);
+  queueEvent(event);
+}
+
+void eventTouch(const CellMask &pressed)
+{
+  StreamEvent event;
+  event.type = EVENT_TOUCH;
+  event.length = FRETBOARD_STRINGS + 1;
+  uint8_t count = 0;
+  for (int string = 0; string < FRETBOARD_STRINGS; string++)
+  {
+    event.body[string] = 0xFF;
+    for (int fret = 0; fret < FRETBOARD_FRETS; fret++)
+    {
+      if (cellMaskTest(pressed, fret * FRETBOARD_STRINGS + string))
+      {
+        event.body[string] = (uint8_t)fret; // the highest one sounds
+        count++;
+      }
+    }
+  }
+  event.body[FRETBOARD_STRINGS] = count;
+  queueEvent(event);
+}
+
+void eventChordCheck(uint8_t state, uint8_t correct, uint8_t fingers, uint8_t wrong, uint16_t elapsedMs)
+{
+  StreamEvent event;
+  event.type = EVENT_CHORD_CHECK;
+  event.length = 6;
+  event.body[0] = state;
+  event.body[1] = correct;
+  event.body[2] = fingers;
+  event.body[3] = wrong;
+  frameStoreU16(event.body + 4, elapsedMs);
+  queueEvent(event);
+}
+
+void eventTuner(uint8_t string, int16_t cents, uint16_t deciHz, uint8_t clarity)
+{
+  StreamEvent event;
+  event.type = EVENT_TUNER;
+  event.length = 6;
+  event.body[0] = string;
+  frameStoreU16(event.body + 1, (uint16_t)cents);
+  frameStoreU16(event.body + 3, deciHz);
+  event.body[5] = clarity;
+  queueEvent(event);
+}
+
+void eventChordMatch(uint8_t score, uint16_t heard, uint16_t chord, uint8_t latencyMs)
+{
+  StreamEvent event;
+  event.type = EVENT_CHORD_MATCH;
+  event.length = 6;
+  event.body[0] = score;
+  frameStoreU16(event.body + 1, heard);
+  frameStoreU16(event.body + 3, chord);
+  event.body[5] = latencyMs;
+  queueEvent(event, true);
+}
+
+void eventStrumTiming(uint16_t beat, uint8_t part, int16_t errorMs)
+{
+  StreamEvent event;
+  event.type = EVENT_STRUM_TIMING;
+  event.length = 5;
+  frameStoreU16(event.body, beat);
+  event.body[2] = part;
+  frameStoreU16(event.body + 3, (uint16_t)errorMs);
+  queueEvent(event);
+}
+
+static void queueStats(uint32_t pushesPerSecond)
+{
+  StreamEvent event;
+  event.type = EVENT_STATS;
+  event.length = 10;
+  frameStoreU32(event.body, ESP.getFreeHeap());
+  frameStoreU16(event.body + 4, (uint16_t)(pushesPerSecond > 0xFFFF ? 0xFFFF : pushesPerSecond));
+  frameStoreU16(event.body + 6, eventsDropped.exchange(0, std::memory_order_relaxed));
+  frameStoreU16(event.body + 8, takeEffectsLoadPeak());
+  queueEvent(event);
+
+  event.type = EVENT_POWER;
+  event.length = 8;
+  event.body[0] = getPowerMode();
+  frameStoreU32(event.body + 1, takeWakeLatencyMax());
+  frameStoreU16(event.body + 5, takeLedCurrentPeak());
+  event.body[7] = getLedBrightness();
+  queueEvent(event);
+}
+
+void eventStreamConnected()
+{
+  if (eventTaskHandle != nullptr)
+    xTaskNotifyGive(eventTaskHandle);
+}
+
+// The largest event must always fit in one frame
+static_assert(1 + EVENT_MAX_BODY <= EVENT_DEFAULT_PACKET - FRAME_OVERHEAD, "event larger than a minimum-MTU frame");
+
+void setEventPacketLimit(size_t bytes)
+{
+  if (bytes < EVENT_DEFAULT_PACKET)
+    bytes = EVENT_DEFAULT_PACKET;
+  packetLimit.store(bytes, std::memory_order_relaxed);
+}
+
+static void notifyBatch(const uint8_t *payload, size_t length)
+{
+  uint8_t frame[FRAME_MAX_PAYLOAD + FRAME_OVERHEAD];
+  size_t frameLength = encodeFrame(FRAME_OP_EVENTS, payload, length, frame);
+  pEventCharacteristic->setValue(frame, frameLength);
+  pEventCharacteristic->notify();
+}
+
+// Send everything queued since the last interval, as few notifications as fit
+static void flushEvents()
+{
+  bool connected = pServer != nullptr && pServer->getConnectedCount() > 0 && pEventCharacteristic != nullptr;
+
+  size_t budget = packetLimit.load(std::memory_order_relaxed) - FRAME_OVERHEAD;
+  if (budget > FRAME_MAX_PAYLOAD)
+    budget = FRAME_MAX_PAYLOAD;
+
+  uint8_t payload[FRAME_MAX_PAYLOAD];
+  size_t used = 0;
+  StreamEvent event;
+  while (xQueueReceive(eventQueue, &event, 0) == pdTRUE)
+  {
+    if (!connected)
+      continue; // nobody to tell; stale events are not replayed on reconnect
+
+    size_t size = 1 + event.length;
+    if (used + size > budget)
+    {
+      notifyBatch(payload, used);
+      used = 0;
+    }
+    payload[used] = event.type;
+    memcpy(payload + used + 1, event.body, event.length);
+    used += size;
+  }
+
+  if (used > 0)
+    notifyBatch(payload, used);
+}
+
+static void eventTask(void *parameter)
+{
+  (void)parameter;
+  TickType_t lastStats = xTaskGetTickCount();
+  uint32_t lastPushes = getFrameStats().pushesIssued;
+
+  for (;;)
+  {
+    // Sleep until an event is queued or, while connected, stats are due
+    bool connected = pServer != nullptr && pServer->getConnectedCount() > 0;
+    TickType_t wait = portMAX_DELAY;
+    if (connected)
+    {
+      TickType_t elapsed = xTaskGetTickCount() - lastStats;
+      TickType_t interval = pdMS_TO_TICKS(EVENT_STATS_INTERVAL_MS);
+      wait = elapsed >= interval ? 0 : interval - elapsed;
+    }
+
+    // Give the rest of this connection interval's events a chance to join
+    // the batch, unless one of them is urgent
+    if (ulTaskNotifyTake(pdTRUE, wait) > 0 && uxQueueMessagesWaiting(eventQueue) > 0)
+    {
+      TickType_t batchStart = xTaskGetTickCount();
+      TickType_t batch = pdMS_TO_TICKS(EVENT_BATCH_INTERVAL_MS);
+      while (!flushNow.exchange(false))
+      {
+        TickType_t waited = xTaskGetTickCount() - batchStart;
+        if (waited >= batch)
+          break;
+        ulTaskNotifyTake(pdTRUE, batch - waited);
+      }
+    }
+
+    TickType_t now = xTaskGetTickCount();
+    if (connected && now - lastStats >= pdMS_TO_TICKS(EVENT_STATS_INTERVAL_MS))
+    {
+      uint32_t pushes = getFrameStats().pushesIssued;
+      queueStats((pushes - lastPushes) * 1000 / ((now - lastStats) * portTICK_PERIOD_MS));
+      lastPushes = pushes;
+      lastStats = now;
+    }
+
+    flushEvents();
+  }
+}
+
+void startEventTask()
+{
+  eventQueue = xQueueCreate(EVENT_QUEUE_SIZE, sizeof(StreamEvent));
+  xTaskCreatePinnedToCore(eventTask, "events", EVENT_TASK_STACK, nullptr,
+                          EVENT_TASK_PRIORITY, &eventTaskHandle, EVENT_TASK_CORE);
+}
@@ -0,0 +1,102 @@
+#include <math.h>
+#include <utility>
+#include "fft.h"
+
+#define FFT_HALF (FFT_SIZE / 2)
+
+static_assert((FFT_SIZE & (FFT_SIZE - 1)) == 0, "FFT_SIZE must be a power of two");
+
+// exp(-2 pi i j / FFT_SIZE) for j < FFT_SIZE / 2. The complex transform of
+// FFT_HALF points uses every other entry, the real split all of them.
+struct FftTwiddles
+{
+  float re[FFT_HALF];
+  float im[FFT_HALF];
+
+  FftTwiddles()
+  {
+    for (int j = 0; j < FFT_HALF; j++)
+    {
+      double angle = -2.0 * M_PI * j / FFT_SIZE;
+      re[j] = (float)cos(angle);
+      im[j] = (float)sin(angle);
+    }
+  }
+};
+
+static const FftTwiddles &twiddles()
+{
+  static const FftTwiddles table;
+  return table;
+}
+
+// Complex FFT of FFT_HALF interleaved values
+static void complexFft(float *data, const FftTwiddles &w)
+{
+  for (int i = 1, j = 0; i < FFT_HALF; i++)
+  {
+    int bit = FFT_HALF >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j |= bit;
+    if (i < j)
+    {
+      std::swap(data[2 * i], data[2 * j]);
+      std::swap(data[2 * i + 1], data[2 * j + 1]);
+    }
+  }
+
+  for (int span = 1, stride = FFT_HALF; span < FFT_HALF; span <<= 1, stride >>= 1)
+  {
+    for (int start = 0; start < FFT_HALF; start += 2 * span)
+    {
+      for (int k = 0; k < span; k++)
+      {
+        float wr = w.re[k * stride];
+        float wi = w.im[k * stride];
+        float *a = data + 2 * (start + k);
+        float *b = a + 2 * span;
+        float tr = b[0] * wr - b[1] * wi;
+        float ti = b[0] * wi + b[1] * wr;
+        b[0] = a[0] - tr;
+        b[1] = a[1] - ti;
+        a[0] += tr;
+        a[1] += ti;
+      }
+    }
+  }
+}
+
+void realFft(float *data)
+{
+  const FftTwiddles &w = twiddles();
+  complexFft(data, w);
+
+  // Z = FFT(even + i odd): X[k] = (Z[k] + conj Z[M-k]) / 2 - i w^k (Z[k] - conj Z[M-k]) / 2
+  float dc = data[0];
+  data[0] = dc + data[1];
+  data[1] = dc - data[1];
+  for (int k = 1; k <= FFT_HALF / 2; k++)
+  {
+    float *zk = data + 2 * k;
+    float *zm = data + 2 * (FFT_HALF - k);
+    float evenRe = 0.5f * (zk[0] + zm[0]);
+    float evenIm = 0.5f * (zk[1] - zm[1]);
+    float oddRe = 0.5f * (zk[1] + zm[1]);
+    float oddIm = -0.5f * (zk[0] - zm[0]);
+    float tr = oddRe * w.re[k] - oddIm * w.im[k];
+    float ti = oddRe * w.im[k] + oddIm * w.re[k];
+    zk[0] = evenRe + tr;
+    zk[1] = evenIm + ti;
+    zm[0] = evenRe - tr; // X[M-k] = conj(even) - conj(w^k odd)
+    zm[1] = ti - evenIm;
+  }
+}
+
+void fftPower(const float *spectrum, float *power)
+{
+  power[0] = spectrum[0] * spectrum[0];
+  power[FFT_HALF] = spectrum[1] * spectrum[1];
+  for (int k = 1; k < FFT_HALF; k++)
+    power[k] = spectrum[2 * k] * spectrum[2 * k] + spectrum[2 * k + 1] * spectrum[2 * k + 1];
+}
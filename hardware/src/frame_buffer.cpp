@@ -0,0 +1,50 @@
+#include <Arduino.h>
+#include <FastLED.h>
+#include "frame_buffer.h"
+#include "led_power.h"
+
+CRGB backBuffer[NUM_LEDS];
+
+static FrameStats frameStats = {};
+
+bool presentFrame()
+{
+  // Only fret cells are ever drawn, so they are the only ones worth diffing
+  CellMask dirtyMask;
+  cellMaskClear(dirtyMask);
+  for (int cell = 0; cell < VALID_LEDS; cell++)
+  {
+    int led = fretLEDs[cell];
+    if (backBuffer[led] != leds[led])
+    {
+      leds[led] = backBuffer[led];
+      cellMaskSet(dirtyMask, cell);
+    }
+  }
+
+  // Nothing changed since the last push - keep the data line idle
+  uint8_t brightness = ledPowerBrightness(leds);
+  if (cellMaskEmpty(dirtyMask) && brightness == FastLED.getBrightness())
+  {
+    frameStats.pushesSkipped++;
+    return false;
+  }
+
+  FastLED.setBrightness(brightness);
+  FastLED.setDither(ledPowerDithering() ? BINARY_DITHER : DISABLE_DITHER);
+  FastLED.show();
+  frameStats.pushesIssued++;
+  frameStats.lastDirtyMask = dirtyMask;
+  return true;
+}
+
+void refreshFrame()
+{
+  FastLED.show();
+  frameStats.refreshes++;
+}
+
+FrameStats getFrameStats()
+{
+  return frameStats;
+}
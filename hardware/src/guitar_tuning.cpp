@@ -0,0 +1,200 @@
+#include <Arduino.h>
+#include <atomic>
+#include <string.h>
+#include "guitar_tuning.h"
+#include "main.h"
+#include "shape_index.h"
+#include "chord_voicing.h"
+#include "scale_and_chord_notes.h"
+#include "render_task.h"
+#include "event_stream.h"
+#include "trace_log.h"
+
+struct Tuning
+{
+  uint8_t preset; // TuningPreset or TUNING_CUSTOM
+  uint8_t capo;
+  uint8_t midi[6];
+};
+
+uint8_t cellPitchClass[FRETBOARD_CELLS];
+
+// What the tables were built for (render task)
+static Tuning current = {TUNING_STANDARD, 0, {0}};
+static bool tablesBuilt = false;
+static uint32_t retuneMicros = 0; // last rebuild
+
+// Accepted by the BLE task, applied by the render task
+static portMUX_TYPE pendingLock = portMUX_INITIALIZER_UNLOCKED;
+static Tuning pending;
+static std::atomic<bool> pendingValid(false);
+
+bool retuneFretboard(const uint8_t *openMidi, int capo)
+{
+  // Only strings whose open note moved to another pitch class need new
+  // columns; a capo moves every string
+  uint32_t strings = 0;
+  for (int string = 0; string < NUM_STRINGS; string++)
+  {
+    if (!tablesBuilt || capo != current.capo || openMidi[string] % 12 != current.midi[string] % 12)
+      strings |= 1u << string;
+  }
+  bool changed = strings != 0 || memcmp(openMidi, current.midi, sizeof(current.midi)) != 0;
+
+  uint8_t openPitch[6];
+  for (int string = 0; string < NUM_STRINGS; string++)
+  {
+    openPitch[string] = openMidi[string] % 12;
+    guitarStrings[string] = openPitch[string];
+    openStringMidi[string] = openMidi[string]; // the tuner may read a mix for one block
+    if (((strings >> string) & 1) == 0)
+      continue;
+    for (int fret = 0; fret < FRETBOARD_FRETS; fret++)
+      cellPitchClass[fret * NUM_STRINGS + string] = fret < capo ? CELL_BEHIND_CAPO : (uint8_t)((openPitch[string] + fret) % 12);
+  }
+  retuneShapeIndex(openPitch, capo, strings);
+
+  memcpy(current.midi, openMidi, sizeof(current.midi));
+  current.capo = (uint8_t)capo;
+  tablesBuilt = true;
+  return changed;
+}
+
+void setupGuitarTuning()
+{
+  retuneFretboard(tuningPresetMidi[TUNING_STANDARD], 0);
+}
+
+uint8_t tuningHandleFrame(const FrameView &frame)
+{
+  if (frame.opcode != FRAME_OP_TUNING || frame.length < 2)
+    return REJECT_MALFORMED;
+
+  Tuning next;
+  next.preset = frame.payload[0];
+  next.capo = frame.payload[1];
+  if (next.capo > TUNING_MAX_CAPO || next.capo >= FRETBOARD_FRETS)
+    return REJECT_MALFORMED;
+
+  if (next.preset == TUNING_CUSTOM)
+  {
+    if (frame.length != 2 + NUM_STRINGS)
+      return REJECT_MALFORMED;
+    for (int string = 0; string < NUM_STRINGS; string++)
+    {
+      next.midi[string] = frame.payload[2 + string];
+      if (next.midi[string] < TUNING_MIN_MIDI || next.midi[string] > TUNING_MAX_MIDI)
+        return REJECT_MALFORMED;
+    }
+  }
+  else
+  {
+    if (frame.length != 2 || next.preset >= TUNING_PRESET_COUNT)
+      return REJECT_MALFORMED;
+    memcpy(next.midi, tuningPresetMidi[next.preset], sizeof(next.midi));
+  }
+
+  portENTER_CRITICAL(&pendingLock);
+  pending = next;
+  portEXIT_CRITICAL(&pendingLock);
+  pendingValid.store(true);
+  requestFrame();
+  return 0;
+}
+
+bool applyPendingTuning()
+{
+  if (!pendingValid.exchange(false))
+    return false;
+
+  portENTER_CRITICAL(&pendingLock);
+  Tuning next = pending;
+  portEXIT_CRITICAL(&pendingLock);
+
+  uint32_t start = micros();
+  bool changed = retuneFretboard(next.midi, next.capo);
+  retuneMicros = micros() - start;
+  current.preset = next.preset;
+  LOG_INFO(TRACE_TUNING, next.preset, next.capo, (int)retuneMicros);
+  return changed;
+}
+
+int tuningCapo()
+{
+  return current.capo;
+}
+
+// Fret on the same string that sounds what the app placed at `fret` in
+// standard tuning, an octave away if it fell behind the capo or off the grid;
+// -1 if neither fits. Frets already past the grid in standard tuning keep
+// their note, so standard tuning without a capo changes nothing.
+static int retunedFret(int string, int fret)
+{
+  int moved = fret + tuningPresetMidi[TUNING_STANDARD][string] - current.midi[string];
+  if (moved < current.capo)
+    moved += 12;
+  if (moved >= FRETBOARD_FRETS && fret < FRETBOARD_FRETS && moved - 12 >= current.capo)
+    moved -= 12;
+  if (moved < current.capo || (moved >= FRETBOARD_FRETS && fret < FRETBOARD_FRETS))
+    return -1;
+  return moved;
+}
+
+// Lowest fret at or past the capo on a string whose note is in the set, -1 if none
+static int lowestFretIn(int string, PitchClassSet notes)
+{
+  for (int fret = current.capo; fret < FRETBOARD_FRETS; fret++)
+  {
+    if (pitchSetHas(notes, cellPitchClass[fret * NUM_STRINGS + string]))
+      return fret;
+  }
+  return -1;
+}
+
+void fitCommandToTuning(PixelCommand &command)
+{
+  if (command.type == CMD_CHORD)
+  {
+    PitchClassSet chord = 0;
+    for (int string = 0; string < NUM_STRINGS; string++)
+    {
+      if (command.frets[string] >= 0)
+        chord |= (PitchClassSet)(1u << ((tuningPresetMidi[TUNING_STANDARD][string] + command.frets[string]) % 12));
+    }
+
+    for (int string = 0; string < NUM_STRINGS; string++)
+    {
+      if (command.frets[string] < 0)
+        continue; // muted stays muted
+      int fret = retunedFret(string, command.frets[string]);
+      command.frets[string] = fret >= 0 ? fret : lowestFretIn(string, chord);
+    }
+  }
+  else if (command.type == CMD_SCALE)
+  {
+    int kept = 0;
+    for (int i = 0; i < command.count; i++)
+    {
+      int string = command.scaleData[i][0];
+      int fret = (string >= 0 && string < NUM_STRINGS) ? retunedFret(string, command.scaleData[i][1]) : command.scaleData[i][1];
+      if (fret < 0)
+        continue;
+      command.scaleData[kept][0] = string;
+      command.scaleData[kept][1] = fret;
+      kept++;
+    }
+    command.count = kept;
+  }
+  else if (command.type == CMD_SHAPE && isChordShape(command.shapeType))
+  {
+    // Voicings are solved for this neck; without one the shape mask is drawn
+    const VoicingSet &voicings = chordVoicings(command.root, command.shapeType & ~SHAPE_CHORD_FLAG);
+    if (command.voicing < 0 || command.voicing >= voicings.count)
+    {
+      command.voicing = -1;
+      return;
+    }
+    for (int string = 0; string < NUM_STRINGS; string++)
+      command.frets[string] = voicings.voicings[command.voicing].frets[string];
+  }
+}
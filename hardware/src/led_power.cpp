@@ -0,0 +1,104 @@
+#include <Arduino.h>
+#include <atomic>
+#include "led_power.h"
+
+// A channel value v shown at brightness b is driven at about v * b / 256 of 255
+#define DRIVE_SCALE (255u * 256u)
+
+static uint32_t lastActivity = 0; // millis() of the last new command
+static bool idle = false;
+static bool litFrame = false;     // the frame last pushed has a lit cell
+static std::atomic<uint8_t> lastBrightness(0);
+static std::atomic<uint16_t> currentPeak(0);
+
+// Sum of channel value x full-drive current over the fret cells; the only
+// cells that are ever lit
+static uint32_t frameLoad(const CRGB *strip)
+{
+  uint32_t load = 0;
+  for (int cell = 0; cell < VALID_LEDS; cell++)
+  {
+    const CRGB &color = strip[fretLEDs[cell]];
+    load += color.r * LED_MA_RED + color.g * LED_MA_GREEN + color.b * LED_MA_BLUE;
+  }
+  return load;
+}
+
+static uint32_t loadCurrent(uint32_t load, uint8_t brightness)
+{
+  return NUM_LEDS * LED_MA_QUIESCENT + (uint32_t)(((uint64_t)load * brightness + DRIVE_SCALE - 1) / DRIVE_SCALE);
+}
+
+static uint8_t fitLoad(uint32_t load, uint8_t target, uint32_t budgetMa)
+{
+  if (load == 0)
+    return target;
+
+  uint32_t quiescent = NUM_LEDS * LED_MA_QUIESCENT;
+  if (budgetMa <= quiescent)
+    return 0;
+  uint64_t fit = (uint64_t)(budgetMa - quiescent) * DRIVE_SCALE / load;
+  return fit < target ? (uint8_t)fit : target;
+}
+
+uint32_t estimateStripCurrent(const CRGB *strip, uint8_t brightness)
+{
+  return loadCurrent(frameLoad(strip), brightness);
+}
+
+uint8_t fitBrightness(const CRGB *strip, uint8_t target, uint32_t budgetMa)
+{
+  return fitLoad(frameLoad(strip), target, budgetMa);
+}
+
+void ledPowerActivity()
+{
+  lastActivity = millis();
+  idle = false;
+}
+
+uint8_t ledPowerBrightness(const CRGB *strip)
+{
+  if (!idle && millis() - lastActivity >= LED_IDLE_AFTER_MS)
+    idle = true;
+
+  uint32_t load = frameLoad(strip);
+  uint8_t brightness = fitLoad(load, idle ? LED_BRIGHTNESS_IDLE : LED_BRIGHTNESS_ACTIVE, LED_POWER_BUDGET_MA);
+  litFrame = load > 0 && brightness > 0;
+
+  uint32_t current = loadCurrent(load, brightness);
+  if (current > currentPeak.load(std::memory_order_relaxed))
+    currentPeak.store(current > 0xFFFF ? 0xFFFF : (uint16_t)current, std::memory_order_relaxed);
+  lastBrightness.store(brightness, std::memory_order_relaxed);
+  return brightness;
+}
+
+bool ledPowerDithering()
+{
+  // Idle trades the finer colours for no refresh wake-ups
+  return litFrame && !idle && lastBrightness.load(std::memory_order_relaxed) < LED_DITHER_BELOW;
+}
+
+uint32_t ledPowerWaitMs()
+{
+  // A blank strip looks the same at any brightness; nothing to time
+  if (!litFrame)
+    return LED_POWER_NO_DEADLINE;
+  if (ledPowerDithering())
+    return LED_DITHER_PERIOD_MS;
+  if (idle)
+    return LED_POWER_NO_DEADLINE;
+
+  uint32_t elapsed = millis() - lastActivity;
+  return elapsed >= LED_IDLE_AFTER_MS ? 0 : LED_IDLE_AFTER_MS - elapsed;
+}
+
+uint16_t takeLedCurrentPeak()
+{
+  return currentPeak.exchange(0, std::memory_order_relaxed);
+}
+
+uint8_t getLedBrightness()
+{
+  return lastBrightness.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,165 @@
+#include <Arduino.h>
+#include <atomic>
+#include "link_tuning.h"
+#include "bluetooth.h"
+#include "ble_protocol.h"
+#include "event_stream.h"
+#include "trace_log.h"
+#include "supervisor.h"
+
+// The 2M PHY needs a Bluetooth 5 controller (ESP32-S3/C3, not the original
+// ESP32) and the BLE 5 API enabled in the SDK build
+#if __has_include("soc/soc_caps.h")
+#include "soc/soc_caps.h"
+#endif
+#if defined(SOC_BLE_50_SUPPORTED) && SOC_BLE_50_SUPPORTED && defined(CONFIG_BT_BLE_50_FEATURES_SUPPORTED)
+#define LINK_HAS_2M_PHY 1
+#else
+#define LINK_HAS_2M_PHY 0
+#endif
+
+#define DEFAULT_ATT_MTU 23
+
+static esp_bd_addr_t peerAddress;
+static std::atomic<bool> linkUp(false);
+static std::atomic<bool> activeMode(false);
+static std::atomic<uint32_t> lastActivity(0);
+static LinkParams linkParams; // written on the BLE task only
+
+static void publishLinkParams()
+{
+  if (pLinkCharacteristic == nullptr)
+    return;
+
+  uint8_t payload[LINK_PARAMS_PAYLOAD];
+  frameStoreU16(payload, linkParams.mtu);
+  frameStoreU16(payload + 2, linkParams.interval);
+  frameStoreU16(payload + 4, linkParams.latency);
+  frameStoreU16(payload + 6, linkParams.timeout);
+  payload[8] = linkParams.txPhy;
+  payload[9] = linkParams.rxPhy;
+  payload[10] = linkParams.active ? 1 : 0;
+
+  uint8_t frame[LINK_PARAMS_PAYLOAD + FRAME_OVERHEAD];
+  size_t length = encodeFrame(FRAME_OP_LINK, payload, sizeof(payload), frame);
+  pLinkCharacteristic->setValue(frame, length);
+  if (linkUp.load())
+    pLinkCharacteristic->notify();
+}
+
+static void requestConnParams(bool active)
+{
+  if (!linkUp.load() || pServer == nullptr)
+    return;
+
+  if (active)
+    pServer->updateConnParams(peerAddress, LINK_ACTIVE_MIN_INTERVAL, LINK_ACTIVE_MAX_INTERVAL,
+                              LINK_ACTIVE_LATENCY, LINK_ACTIVE_TIMEOUT);
+  else
+    pServer->updateConnParams(peerAddress, LINK_IDLE_MIN_INTERVAL, LINK_IDLE_MAX_INTERVAL,
+                              LINK_IDLE_LATENCY, LINK_IDLE_TIMEOUT);
+}
+
+// Record what the central actually granted
+static void linkGapHandler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param)
+{
+  switch (event)
+  {
+  case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+    if (param->update_conn_params.status != ESP_BT_STATUS_SUCCESS)
+      break;
+    linkParams.interval = param->update_conn_params.conn_int;
+    linkParams.latency = param->update_conn_params.latency;
+    linkParams.timeout = param->update_conn_params.timeout;
+    linkParams.active = activeMode.load();
+    LOG_INFO(TRACE_LINK_PARAMS, linkParams.interval, linkParams.latency, linkParams.timeout);
+    publishLinkParams();
+    break;
+#if LINK_HAS_2M_PHY
+  case ESP_GAP_BLE_PHY_UPDATE_COMPLETE_EVT:
+    if (param->phy_update.status != ESP_BT_STATUS_SUCCESS)
+      break;
+    linkParams.txPhy = param->phy_update.tx_phy;
+    linkParams.rxPhy = param->phy_update.rx_phy;
+    LOG_INFO(TRACE_LINK_PHY, linkParams.txPhy, linkParams.rxPhy);
+    publishLinkParams();
+    break;
+#endif
+  default:
+    break;
+  }
+}
+
+void setupLinkTuning()
+{
+  // Local limit only; the central starts the exchange and the smaller MTU wins
+  BLEDevice::setMTU(LINK_MTU);
+  BLEDevice::setCustomGapHandler(linkGapHandler);
+}
+
+void linkConnected(const esp_bd_addr_t address)
+{
+  memcpy(peerAddress, address, sizeof(peerAddress));
+  linkParams.mtu = DEFAULT_ATT_MTU;
+  linkParams.interval = 0; // unknown until the first update completes
+  linkParams.latency = 0;
+  linkParams.timeout = 0;
+  linkParams.txPhy = LINK_PHY_1M;
+  linkParams.rxPhy = LINK_PHY_1M;
+  linkParams.active = true;
+  lastActivity.store(millis());
+  activeMode.store(true);
+  linkUp.store(true);
+
+  // A fresh connection usually means a lesson is starting
+  requestConnParams(true);
+#if LINK_HAS_2M_PHY
+  esp_ble_gap_set_preferred_phy(peerAddress, 0, ESP_BLE_GAP_PHY_2M_PREF_MASK, ESP_BLE_GAP_PHY_2M_PREF_MASK,
+                                ESP_BLE_GAP_PHY_OPTIONS_NO_PREF);
+#endif
+  publishLinkParams();
+}
+
+void linkDisconnected()
+{
+  linkUp.store(false);
+  activeMode.store(false);
+  setEventPacketLimit(EVENT_DEFAULT_PACKET);
+}
+
+void linkMtuChanged(uint16_t mtu)
+{
+  linkParams.mtu = mtu;
+  setEventPacketLimit(mtu - 3); // ATT notification header
+  LOG_INFO(TRACE_LINK_MTU, mtu);
+  publishLinkParams();
+}
+
+void linkNoteActivity()
+{
+  lastActivity.store(millis());
+  if (linkUp.load() && !activeMode.exchange(true))
+  {
+    requestConnParams(true);
+    postSystemEvent(SYSTEM_LINK_ACTIVE);
+  }
+}
+
+uint32_t updateLinkMode()
+{
+  if (!linkUp.load() || !activeMode.load())
+    return LINK_NO_DEADLINE;
+
+  uint32_t quiet = millis() - lastActivity.load();
+  if (quiet < LINK_IDLE_AFTER_MS)
+    return LINK_IDLE_AFTER_MS - quiet;
+
+  if (activeMode.exchange(false))
+    requestConnParams(false);
+  return LINK_NO_DEADLINE;
+}
+
+LinkParams getLinkParams()
+{
+  return linkParams;
+}
@@ -1,81 +1,68 @@
 #include "scale_and_chord_notes.h"
 #include "bluetooth.h"
 #include "main.h"
+#include "frame_buffer.h"
+#include "led_power.h"
+#include "render_task.h"
+#include "trace_log.h"
+#include "event_stream.h"
+#include "sequencer.h"
+#include "effects.h"
+#include "tempo_clock.h"
+#include "guitar_tuning.h"
+#include "touch_sensing.h"
+#include "audio_input.h"
+#include "supervisor.h"
+#ifdef GUITARPAL_BENCH
+#include "benchmarks.h"
+#endif
 
 CRGB leds[NUM_LEDS];
-int fretLEDs[VALID_LEDS];
 
+// Standard tuning until the app picks another (guitar_tuning.h)
 int guitarStrings[6] = {4, 9, 2, 7, 11, 4};
-
-// for grid board setup;
-void setGridPixeltoFrets()
-{
-  int fretLEDcount = 0;
-  for (int i = 0; i < NUM_LEDS; i++)
-  {
-    if (i % 8 < 6)
-    {
-      fretLEDs[fretLEDcount] = i;
-      fretLEDcount++;
-    }
-  }
-}
+int openStringMidi[6] = {40, 45, 50, 55, 59, 64}; // E2 A2 D3 G3 B3 E4: guitarStrings with their octave
 
 void setGridColor(int* sequence, int count, CRGB color)
 {
   for (int i = 0; i < count; i++)
   {
-    leds[fretLEDs[sequence[i]]] = color;
+    backBuffer[fretLEDs[sequence[i]]] = color;
   }
-  FastLED.show();
 }
 
 void clearGrid()
 {
   for (int i = 0; i < VALID_LEDS; i++)
   {
-    leds[fretLEDs[i]] = CRGB::Black;
+    backBuffer[fretLEDs[i]] = CRGB::Black;
   }
-  FastLED.show();
 }
 
 int pixelCalculator(const int* chordNotes, int noteCount, int* pixels)
 {
-  Serial.println("Calculating pixels for chord notes...");
+  LOG_DEBUG(TRACE_PIXELS_CALCULATE, noteCount);
   int pixelCount = 0;
-  
-  for (int i = 0; i < 6; i++)
+
+  // Chord notes as a pitch-class set: membership becomes a single AND
+  PitchClassSet chordSet = 0;
+  for (int j = 0; j < noteCount; j++)
+  {
+    chordSet |= (PitchClassSet)(1u << chordNotes[j]);
+  }
+
+  for (int i = 0; i < NUM_STRINGS; i++)
   {
-    int currentStringNote = guitarStrings[i];
-    int ledPixelIndex = i;
-    
-    while (ledPixelIndex < VALID_LEDS)
+    // Up the string from the nut; cells behind the capo never match
+    for (int ledPixelIndex = i; ledPixelIndex < VALID_LEDS; ledPixelIndex += NUM_STRINGS)
     {
       // Check if current note is in chord
-      bool noteFound = false;
-      for (int j = 0; j < noteCount; j++) {
-        if (chordNotes[j] == currentStringNote) {
-          noteFound = true;
-          break;
-        }
-      }
-      
-      if (noteFound)
+      if (cellPitchClass[ledPixelIndex] != CELL_BEHIND_CAPO && pitchSetHas(chordSet, cellPitchClass[ledPixelIndex]))
       {
-        Serial.print("String: ");
-        Serial.println(i);
-        Serial.print(" Fret: ");
-        Serial.println(ledPixelIndex);
+        LOG_DEBUG(TRACE_PIXELS_FOUND, i, ledPixelIndex);
         pixels[pixelCount++] = ledPixelIndex;
         break;
       }
-      
-      Serial.print("String: ");
-      Serial.println(i);
-      Serial.print(" Fret: ");
-      Serial.println(ledPixelIndex);
-      currentStringNote = (currentStringNote + 1) % 12; // Move to the next fret
-      ledPixelIndex += 6;
     }
   }
   
@@ -85,31 +72,51 @@ int pixelCalculator(const int* chordNotes, int noteCount, int* pixels)
 void setup()
 {
   FastLED.addLeds<WS2812B, DATA_PIN, GRB>(leds, NUM_LEDS);
-  FastLED.setBrightness(20); // Low brightness (~1.28 A)
+  FastLED.setBrightness(LED_BRIGHTNESS_ACTIVE); // presentFrame() fits each frame to LED_POWER_BUDGET_MA
   Serial.begin(115200);
-  setGridPixeltoFrets(); // Initialize the grid with valid LED positions
-  Serial.println("Testing WS2812B 8x8 LED Grid (64 LEDs)");
+  Serial.print("Testing WS2812B LED Grid (");
+  Serial.print(NUM_LEDS);
+  Serial.println(" LEDs)");
   pinMode(BL_CONNECTED_PIN, OUTPUT);
   pinMode(BL_DISCONNECTED_PIN, OUTPUT);
   digitalWrite(BL_CONNECTED_PIN, LOW);
   digitalWrite(BL_DISCONNECTED_PIN, HIGH);
 
+  clearGrid();
+  FastLED.show(); // blank the strip once; leds[] and backBuffer now agree
+
+  // Pitch of every cell and the shape masks, for standard tuning
+  setupGuitarTuning();
+
+#ifdef GUITARPAL_BENCH
+  // Bench builds time the pipeline stages directly; no render task, no BLE
+  runBenchmarks();
+  return;
+#endif
+
+  // Log records from the hot paths are printed by the trace task
+  startTraceTask();
+
+  // LED work runs on the render task and acks leave from the event task;
+  // start both before BLE can queue commands
+  startRenderTask();
+  startEventTask();
+  setupSequencer();
+  setupTempoClock();
+  setupEffects();
+  setupTouch();
+  setupAudio();
+
+  // Connection events, status LEDs and power management
+  startSupervisor();
+
   // Initialize Bluetooth
   setupBluetooth();
-  clearGrid();
 }
 
 void loop()
 {
-  // Check if we need to restart advertising (additional safety check)
-  if (pServer != nullptr && !pServer->getConnectedCount()) {
-    // If no clients connected, restart advertising
-    clearGrid();
-    digitalWrite(BL_CONNECTED_PIN, LOW);
-    digitalWrite(BL_DISCONNECTED_PIN, HIGH);
-    Serial.println("No connection detected - Restarting advertising");
-    BLEDevice::startAdvertising();
-  }
-  
-  delay(2000); // Wait before repeating
+  // Everything runs on event-driven tasks (see supervisor.h); the Arduino
+  // loop task would only keep the CPU from sleeping
+  vTaskDelete(nullptr);
 }
\ No newline at end of file
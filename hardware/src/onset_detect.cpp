@@ -0,0 +1,69 @@
+#include "onset_detect.h"
+
+#define SAMPLE_PERIOD_NUM 1000000LL // us per AUDIO_SAMPLE_RATE samples
+
+void onsetDetectorReset(OnsetDetector &detector)
+{
+  detector.previous = 0;
+  detector.background = 0;
+  detector.lastOnsetUs = INT64_MIN / 2;
+  detector.primed = false;
+}
+
+int detectOnsets(OnsetDetector &detector, const int16_t *block, int64_t blockStartUs, int64_t *onsetsUs)
+{
+  const uint32_t minEnergy = (uint32_t)ONSET_MIN_RMS * ONSET_MIN_RMS * ONSET_HOP;
+  int found = 0;
+  int16_t previous = detector.previous;
+
+  for (int hop = 0; hop < AUDIO_BLOCK_SAMPLES; hop += ONSET_HOP)
+  {
+    // Differences of 12-bit samples: 32 x 4094^2 fits 32 bits
+    uint32_t energy = 0;
+    int32_t first = previous;
+    for (int i = hop; i < hop + ONSET_HOP; i++)
+    {
+      int32_t delta = block[i] - first;
+      energy += (uint32_t)(delta * delta);
+      first = block[i];
+    }
+
+    if (!detector.primed)
+    {
+      detector.background = energy;
+      detector.primed = true;
+    }
+
+    uint32_t background = detector.background;
+    if (energy >= minEnergy && energy >= (uint64_t)background * ONSET_RATIO && found < ONSET_MAX_PER_BLOCK)
+    {
+      // First sample in the hop that is itself that far above the background
+      uint32_t perSample = (uint32_t)((uint64_t)background * ONSET_RATIO / ONSET_HOP);
+      int at = hop;
+      int32_t last = previous;
+      for (int i = hop; i < hop + ONSET_HOP; i++)
+      {
+        int32_t delta = block[i] - last;
+        last = block[i];
+        if ((uint32_t)(delta * delta) > perSample)
+        {
+          at = i;
+          break;
+        }
+      }
+
+      int64_t onset = blockStartUs + at * SAMPLE_PERIOD_NUM / AUDIO_SAMPLE_RATE;
+      if (onset - detector.lastOnsetUs >= ONSET_REFRACTORY_US)
+      {
+        onsetsUs[found++] = onset;
+        detector.lastOnsetUs = onset;
+      }
+    }
+
+    detector.background += ((int32_t)energy - (int32_t)background) >> ONSET_BACKGROUND_SHIFT;
+    previous = block[hop + ONSET_HOP - 1];
+  }
+
+  detector.previous = previous;
+  return found;
+}
@@ -0,0 +1,85 @@
+#include "pitch_detect.h"
+
+#define Q15_ONE 32768u
+
+// Sum of squared halved differences between the window and the window tau later
+static uint32_t lagDifference(const int16_t *frame, int tau)
+{
+  const int16_t *shifted = frame + tau;
+  uint32_t sum = 0;
+  for (int j = 0; j < PITCH_WINDOW; j++)
+  {
+    int32_t delta = (frame[j] - shifted[j]) >> 1;
+    sum += (uint32_t)(delta * delta);
+  }
+  return sum;
+}
+
+bool estimatePitch(const int16_t *frame, PitchEstimate *estimate)
+{
+  estimate->voiced = false;
+  estimate->periodQ8 = 0;
+  estimate->aperiodicity = Q15_ONE - 1;
+
+  uint32_t energy = 0;
+  for (int j = 0; j < PITCH_WINDOW; j++)
+  {
+    int32_t half = frame[j] >> 1;
+    energy += (uint32_t)(half * half);
+  }
+  if (energy < (uint32_t)(PITCH_MIN_RMS / 2) * (PITCH_MIN_RMS / 2) * PITCH_WINDOW)
+    return false;
+
+  // Cumulative mean normalised difference (Q15) picks the dip; the raw
+  // differences around it are kept for the interpolation
+  uint64_t running = 0;
+  uint32_t previous = 0;
+  int dip = -1;
+  uint32_t dipNormalised = Q15_ONE;
+  int64_t before = 0;
+  int64_t at = 0;
+  int64_t after = -1;
+
+  for (int tau = 1; tau <= PITCH_MAX_LAG; tau++)
+  {
+    uint32_t difference = lagDifference(frame, tau);
+    running += difference;
+    uint32_t normalised = running == 0 ? Q15_ONE : (uint32_t)(((uint64_t)difference * tau << 15) / running);
+
+    if (dip < 0 ? (tau >= PITCH_MIN_LAG && normalised < PITCH_THRESHOLD_Q15) : normalised < dipNormalised)
+    {
+      dip = tau;
+      dipNormalised = normalised;
+      before = previous;
+      at = difference;
+    }
+    else if (dip >= 0)
+    {
+      after = difference; // past the bottom of the dip
+      break;
+    }
+    previous = difference;
+  }
+  if (dip < 0)
+    return false;
+
+  // Parabola through the raw differences at the dip and its neighbours (the
+  // normalisation tilts the curve); the offset is in 1/256 sample
+  int32_t offset = 0;
+  int64_t curvature = before - 2 * at + after;
+  if (after >= 0 && curvature > 0)
+  {
+    offset = (int32_t)((before - after) * 128 / curvature);
+    offset = offset > 128 ? 128 : offset < -128 ? -128 : offset;
+  }
+
+  estimate->voiced = true;
+  estimate->periodQ8 = (uint32_t)(dip * 256 + offset);
+  estimate->aperiodicity = (uint16_t)dipNormalised;
+  return true;
+}
+
+uint32_t pitchCentiHz(uint32_t periodQ8)
+{
+  return periodQ8 == 0 ? 0 : (uint32_t)((uint64_t)AUDIO_SAMPLE_RATE * 256 * 100 / periodQ8);
+}
@@ -1,12 +1,17 @@
 #include <Arduino.h>
 #include <FastLED.h>
 #include "main.h"
+#include "frame_buffer.h"
+#include "shape_index.h"
+#include "tuner.h"
+#include "guitar_tuning.h"
+#include "trace_log.h"
 
 void convertChordPositionsToPixels(int *stringPositions, int *pixels)
 {
   int pixelCount = 0;
 
-  for (int string = 0; string < 6; string++)
+  for (int string = 0; string < NUM_STRINGS; string++)
   {
     int fretPosition = stringPositions[string];
 
@@ -15,18 +20,16 @@ void convertChordPositionsToPixels(int *stringPositions, int *pixels)
     {
       if (fretPosition < 0)
       {
-        Serial.print("Don't strum string: ");
-        Serial.println(string);
+        LOG_DEBUG(TRACE_CHORD_MUTED, string);
         pixels[pixelCount] = string;                    // Indicate no strum for this string
-        leds[fretLEDs[pixels[pixelCount]]] = CRGB::Red; // Use red for muted strings
+        backBuffer[fretLEDs[pixels[pixelCount]]] = CRGB::Red; // Use red for muted strings
         pixelCount++;
       }
       else if (fretPosition == 0)
       {
-        Serial.print("Open string: ");
-        Serial.println(string);
+        LOG_DEBUG(TRACE_CHORD_OPEN, string);
         pixels[pixelCount] = string;                      // Indicate open string for this string
-        leds[fretLEDs[pixels[pixelCount]]] = CRGB::Green; // Use green for open strings
+        backBuffer[fretLEDs[pixels[pixelCount]]] = CRGB::Green; // Use green for open strings
         pixelCount++;
       }
       continue;
@@ -34,22 +37,18 @@ void convertChordPositionsToPixels(int *stringPositions, int *pixels)
 
     // Convert to grid position
     // fretPosition 1 = fret 0 (open string) = LED indices 0-5
-    // fretPosition 2 = fret 1 = LED indices 6-11, etc.
-    int gridPosition = (fretPosition) * 6 + string;
+    // fretPosition 2 = fret 1 = LED indices 6-11, etc. (NUM_STRINGS per fret row)
+    int gridPosition = (fretPosition) * NUM_STRINGS + string;
 
     // Make sure we don't exceed the valid LED range
     if (gridPosition < VALID_LEDS)
     {
       pixels[pixelCount] = gridPosition;
-      leds[fretLEDs[gridPosition]] = CRGB::Blue; // Use blue for normal strummed strings
+      // Strings played at the capo are open strings too
+      backBuffer[fretLEDs[gridPosition]] = fretPosition == tuningCapo() ? CRGB::Green : CRGB::Blue;
       pixelCount++;
 
-      Serial.print("String ");
-      Serial.print(string);
-      Serial.print(", Position ");
-      Serial.print(fretPosition);
-      Serial.print(" -> Grid position ");
-      Serial.println(gridPosition);
+      LOG_DEBUG(TRACE_CHORD_FRETTED, string, fretPosition, gridPosition);
     }
   }
 
@@ -58,53 +57,93 @@ void convertChordPositionsToPixels(int *stringPositions, int *pixels)
 
 void convertScalePositionsToPixels(int scaleData[][2], int scaleCount)
 {
-  Serial.println("Converting scale positions to pixels...");
+  LOG_DEBUG(TRACE_SCALE_CONVERT, scaleCount);
 
   for (int i = 0; i < scaleCount; i++)
   {
     int guitarString = scaleData[i][0];
     int fretPosition = scaleData[i][1];
 
-    Serial.print("Scale position ");
-    Serial.print(i);
-    Serial.print(": String ");
-    Serial.print(guitarString);
-    Serial.print(", Fret ");
-    Serial.println(fretPosition);
-
     // Convert string and fret to grid position
     // fretPosition corresponds directly to the fret number
     // guitarString corresponds to the string (0-5)
-    if (guitarString >= 0 && guitarString < 6)
+    if (guitarString >= 0 && guitarString < NUM_STRINGS)
     {
-      int gridPosition = fretPosition * 6 + guitarString;
+      int gridPosition = fretPosition * NUM_STRINGS + guitarString;
 
-      // Make sure we don't exceed the valid LED range
-      if (gridPosition < VALID_LEDS)
+      // Make sure we stay inside the valid LED range
+      if (fretPosition >= 0 && gridPosition < VALID_LEDS)
       {
-        // clearGrid();
-        leds[fretLEDs[gridPosition]] = CRGB::Purple; // Use purple for scale notes
-        FastLED.show();
-        delay(200); // Briefly show each LED for debugging
-
-        Serial.print("String ");
-        Serial.print(guitarString);
-        Serial.print(", Fret ");
-        Serial.print(fretPosition);
-        Serial.print(" -> Grid position ");
-        Serial.println(gridPosition);
+        backBuffer[fretLEDs[gridPosition]] = CRGB::Purple; // Use purple for scale notes
+        LOG_DEBUG(TRACE_SCALE_NOTE, guitarString, fretPosition, gridPosition);
       }
       else
       {
-        Serial.print("Grid position ");
-        Serial.print(gridPosition);
-        Serial.println(" exceeds valid LED range");
+        LOG_WARN(TRACE_SCALE_OUT_OF_RANGE, gridPosition);
       }
     }
     else
     {
-      Serial.print("Invalid string number: ");
-      Serial.println(guitarString);
+      LOG_WARN(TRACE_SCALE_BAD_STRING, guitarString);
     }
   }
 }
+
+void convertShapeToPixels(int root, int type)
+{
+  const CellMask *mask = getShapeMask(root, type);
+  if (mask == nullptr)
+  {
+    LOG_WARN(TRACE_SHAPE_UNKNOWN, root, type);
+    return;
+  }
+
+  bool chord = isChordShape(type);
+  int capo = tuningCapo();
+
+  // Walk the set bits only; each one is a fret cell to light
+  for (int word = 0; word < CELL_MASK_WORDS; word++)
+  {
+    uint64_t bits = mask->words[word];
+    while (bits != 0)
+    {
+      int cell = word * 64 + __builtin_ctzll(bits);
+      bits &= bits - 1;
+
+      if (!chord)
+        backBuffer[fretLEDs[cell]] = CRGB::Purple; // Use purple for scale notes
+      else if (cell / NUM_STRINGS == capo)
+        backBuffer[fretLEDs[cell]] = CRGB::Green; // Use green for open strings (at the capo)
+      else
+        backBuffer[fretLEDs[cell]] = CRGB::Blue; // Use blue for fretted chord notes
+    }
+  }
+}
+
+void convertMaskToPixels(const CellMask &mask, uint32_t color)
+{
+  for (int word = 0; word < CELL_MASK_WORDS; word++)
+  {
+    uint64_t bits = mask.words[word];
+    while (bits != 0)
+    {
+      int cell = word * 64 + __builtin_ctzll(bits);
+      bits &= bits - 1;
+      if (cell < VALID_LEDS)
+        backBuffer[fretLEDs[cell]] = CRGB(color);
+    }
+  }
+}
+
+void convertTunerToPixels(int string, int cents)
+{
+  if (string < 0 || string >= NUM_STRINGS)
+    return;
+
+  int row = tunerNeedleRow(cents);
+  bool inTune = abs(cents) <= TUNER_IN_TUNE_CENTS;
+  backBuffer[fretLEDs[string]] = CRGB(TUNER_COLOR_STRING); // nut cell: which string
+  if (!inTune)
+    backBuffer[fretLEDs[(FRETBOARD_FRETS / 2) * NUM_STRINGS + string]] = CRGB(TUNER_COLOR_CENTRE);
+  backBuffer[fretLEDs[row * NUM_STRINGS + string]] = CRGB(inTune ? TUNER_COLOR_IN_TUNE : TUNER_COLOR_OFF);
+}
@@ -0,0 +1,244 @@
+#include <Arduino.h>
+#include <atomic>
+#include "main.h"
+#include "frame_buffer.h"
+#include "led_power.h"
+#include "pixel_mapping.h"
+#include "render_task.h"
+#include "trace_log.h"
+#include "event_stream.h"
+#include "supervisor.h"
+#include "effects.h"
+#include "chord_check.h"
+#include "chord_listen.h"
+#include "guitar_tuning.h"
+#include "shape_index.h"
+
+static TaskHandle_t renderTaskHandle = nullptr;
+static std::atomic<bool> clearPending(false);
+static std::atomic<uint32_t> clearRequestedAt(0); // micros(), as PixelCommand::receivedAt
+static CommandMailbox commandMailbox;  // acknowledged BLE writes
+static CommandMailbox fastMailbox;     // BLE fast-path writes
+static CommandMailbox sequenceMailbox; // sequencer steps
+static CommandMailbox audioMailbox;    // tuner display
+static std::atomic<uint32_t> wakeLatencyMax(0);
+static PixelCommand shown; // newest command as it arrived, redrawn after a retune
+static bool showing = false;
+
+static void renderCommand(PixelCommand &command)
+{
+  switch (command.type)
+  {
+  case CMD_CHORD:
+  {
+    LOG_DEBUG(TRACE_RENDER_CHORD);
+    int pixels[6];
+    clearGrid();
+    convertChordPositionsToPixels(command.frets, pixels);
+    break;
+  }
+  case CMD_SCALE:
+    LOG_DEBUG(TRACE_RENDER_SCALE, command.count);
+    clearGrid();
+    convertScalePositionsToPixels(command.scaleData, command.count);
+    break;
+  case CMD_SHAPE:
+  {
+    LOG_DEBUG(TRACE_RENDER_SHAPE, command.root, command.shapeType);
+    int pixels[6];
+    clearGrid();
+    if (isChordShape(command.shapeType) && command.voicing >= 0)
+      convertChordPositionsToPixels(command.frets, pixels); // voiced by fitCommandToTuning()
+    else
+      convertShapeToPixels(command.root, command.shapeType);
+    break;
+  }
+  case CMD_MASK:
+    clearGrid();
+    convertMaskToPixels(command.mask, command.color);
+    break;
+  case CMD_TUNER:
+    clearGrid();
+    convertTunerToPixels(command.tunerString, command.cents);
+    break;
+  case CMD_CLEAR:
+    clearGrid();
+    break;
+  }
+}
+
+// A mailbox already holds only its producer's newest command; keep it if it
+// arrived after the newest one seen so far this frame. Commands it replaced
+// before they were drawn count as superseded.
+static void takeMailbox(CommandMailbox &mailbox, PixelCommand &latest, bool &haveCommand, int &superseded)
+{
+  PixelCommand command;
+  int replaced;
+  if (!commandMailboxTake(mailbox, &command, &replaced))
+    return;
+
+  superseded += replaced;
+  if (!haveCommand)
+    latest = command;
+  else
+  {
+    superseded++;
+    if ((int32_t)(command.receivedAt - latest.receivedAt) >= 0)
+      latest = command;
+  }
+  haveCommand = true;
+}
+
+// A clear is ordered with the commands by when it was requested. One older
+// than the newest command taken this frame is dropped, since the command
+// redraws the whole grid; a newer one supersedes the command.
+static bool takeClear(const PixelCommand &latest, bool &haveCommand, int &superseded)
+{
+  if (!clearPending.exchange(false, std::memory_order_acquire))
+    return false;
+  uint32_t requestedAt = clearRequestedAt.load(std::memory_order_relaxed);
+  if (haveCommand && (int32_t)(latest.receivedAt - requestedAt) >= 0)
+    return false;
+  if (haveCommand)
+    superseded++;
+  haveCommand = false;
+  return true;
+}
+
+static void renderTask(void *parameter)
+{
+  (void)parameter;
+  PixelCommand latest;
+
+  for (;;)
+  {
+    // Sleep until a producer signals new work, or until the lit frame is due
+    // to dim or needs a dither refresh
+    uint32_t waitMs = ledPowerWaitMs();
+    ulTaskNotifyTake(pdTRUE, waitMs == LED_POWER_NO_DEADLINE ? portMAX_DELAY : pdMS_TO_TICKS(waitMs));
+
+    // A new tuning applies to everything drawn from here on
+    bool retuned = applyPendingTuning();
+
+    // Only the newest command matters; older ones are superseded without
+    // being drawn
+    bool haveCommand = false;
+    int superseded = 0;
+    takeMailbox(commandMailbox, latest, haveCommand, superseded);
+    takeMailbox(fastMailbox, latest, haveCommand, superseded);
+    takeMailbox(sequenceMailbox, latest, haveCommand, superseded);
+    takeMailbox(audioMailbox, latest, haveCommand, superseded);
+    bool clear = takeClear(latest, haveCommand, superseded);
+
+    if (superseded > 0)
+    {
+      LOG_INFO(TRACE_COMMANDS_SUPERSEDED, superseded);
+    }
+
+    if (clear)
+    {
+      showing = false;
+      clearGrid();
+      effectsNewTarget(nullptr);
+      chordCheckNewTarget(nullptr);
+      chordListenNewTarget(nullptr);
+    }
+
+    if (haveCommand)
+    {
+      shown = latest;
+      showing = true;
+    }
+    else if (retuned && showing)
+    {
+      // Same notes on the new neck; not an app write, so no sequence number
+      latest = shown;
+      latest.receivedAt = micros();
+      latest.sequence = -1;
+      haveCommand = true;
+    }
+
+    if (haveCommand)
+    {
+      fitCommandToTuning(latest);
+      uint32_t wakeLatency = micros() - latest.receivedAt;
+      if (wakeLatency > wakeLatencyMax.load(std::memory_order_relaxed))
+        wakeLatencyMax.store(wakeLatency, std::memory_order_relaxed);
+      renderCommand(latest);
+      ledPowerActivity();
+      effectsNewTarget(&latest);
+      chordCheckNewTarget(&latest);
+      chordListenNewTarget(&latest);
+    }
+
+    // One push per logical frame, however many commands were handled
+    uint32_t frameStart = micros();
+    bool animating = effectsCompose(chordCheckFeedbackChanged());
+    chordCheckPaint();
+    ledPushBegin();
+    if (!presentFrame() && ledPowerDithering())
+      refreshFrame();
+    ledPushEnd();
+    effectsFrameDone(animating, micros() - frameStart);
+
+    if (haveCommand)
+    {
+      eventRenderComplete(latest.type, superseded, micros() - latest.receivedAt);
+      if (latest.sequence >= 0)
+        eventSequenceApplied((uint16_t)latest.sequence);
+    }
+  }
+}
+
+void startRenderTask()
+{
+  xTaskCreatePinnedToCore(renderTask, "render", RENDER_TASK_STACK, nullptr,
+                          RENDER_TASK_PRIORITY, &renderTaskHandle, RENDER_TASK_CORE);
+}
+
+void submitCommand(const PixelCommand &command)
+{
+  commandMailboxPut(commandMailbox, command);
+  if (renderTaskHandle != nullptr)
+    xTaskNotifyGive(renderTaskHandle);
+}
+
+void submitLatestCommand(const PixelCommand &command)
+{
+  commandMailboxPut(fastMailbox, command);
+  if (renderTaskHandle != nullptr)
+    xTaskNotifyGive(renderTaskHandle);
+}
+
+void submitSequenceStep(const PixelCommand &command)
+{
+  commandMailboxPut(sequenceMailbox, command);
+  if (renderTaskHandle != nullptr)
+    xTaskNotifyGive(renderTaskHandle);
+}
+
+void submitAudioCommand(const PixelCommand &command)
+{
+  commandMailboxPut(audioMailbox, command);
+  if (renderTaskHandle != nullptr)
+    xTaskNotifyGive(renderTaskHandle);
+}
+
+uint32_t takeWakeLatencyMax()
+{
+  return wakeLatencyMax.exchange(0, std::memory_order_relaxed);
+}
+
+void requestClear()
+{
+  clearRequestedAt.store(micros(), std::memory_order_relaxed);
+  clearPending.store(true, std::memory_order_release);
+  if (renderTaskHandle != nullptr)
+    xTaskNotifyGive(renderTaskHandle);
+}
+
+void requestFrame()
+{
+  if (renderTaskHandle != nullptr)
+    xTaskNotifyGive(renderTaskHandle);
+}
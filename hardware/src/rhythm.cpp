@@ -0,0 +1,91 @@
+#include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
+#include "rhythm.h"
+#include "event_stream.h"
+
+static std::atomic<uint8_t> requestedSubdivisions(1);
+
+// Audio task only
+static OnsetDetector detector;
+static StrumTiming pending[RHYTHM_MAX_PENDING];
+static int pendingCount = 0;
+static int pendingSubdivisions = 1;
+static int64_t pendingAnchor = 0; // grid the pending strums were scored on
+
+StrumTiming rhythmScore(const TempoGrid &grid, int subdivisions, int64_t onsetUs)
+{
+  StrumTiming timing;
+  timing.point = tempoGridNearest(grid, subdivisions, onsetUs, &timing.errorUs);
+  return timing;
+}
+
+bool rhythmSetSubdivisions(uint8_t subdivisions)
+{
+  if (subdivisions == 0 || subdivisions > RHYTHM_MAX_SUBDIVISIONS)
+    return false;
+  requestedSubdivisions.store(subdivisions);
+  return true;
+}
+
+static int16_t roundMs(int32_t errorUs)
+{
+  int32_t ms = (errorUs >= 0 ? errorUs + 500 : errorUs - 500) / 1000;
+  return (int16_t)(ms > INT16_MAX ? INT16_MAX : ms < INT16_MIN ? INT16_MIN : ms);
+}
+
+static void sendPending()
+{
+  for (int i = 0; i < pendingCount; i++)
+  {
+    int64_t beat = pending[i].point / pendingSubdivisions;
+    int part = (int)(pending[i].point % pendingSubdivisions);
+    if (part < 0)
+    {
+      beat--;
+      part += pendingSubdivisions;
+    }
+    eventStrumTiming((uint16_t)beat, (uint8_t)part, roundMs(pending[i].errorUs));
+  }
+  pendingCount = 0;
+}
+
+void resetRhythm()
+{
+  onsetDetectorReset(detector);
+  pendingCount = 0;
+}
+
+void rhythmProcessBlock(const int16_t *block, int64_t blockStartUs)
+{
+  int64_t onsets[ONSET_MAX_PER_BLOCK];
+  int found = detectOnsets(detector, block, blockStartUs, onsets);
+
+  TempoGrid grid = tempoClockGrid();
+  int subdivisions = requestedSubdivisions.load();
+  if (pendingCount > 0 && (grid.anchorUs != pendingAnchor || subdivisions != pendingSubdivisions))
+    sendPending(); // tempo or subdivision changed: that bar is over
+  if (grid.periodUs == 0)
+    return;
+
+  for (int i = 0; i < found; i++)
+  {
+    if (pendingCount == RHYTHM_MAX_PENDING)
+      sendPending();
+    pending[pendingCount++] = rhythmScore(grid, subdivisions, onsets[i]);
+    pendingAnchor = grid.anchorUs;
+    pendingSubdivisions = subdivisions;
+  }
+
+  // A bar is over once the clock is in the next one; a strum a little late
+  // for the last beat has been heard by then
+  int64_t barUs = grid.periodUs * grid.beatsPerBar;
+  int64_t blockEnd = blockStartUs + (int64_t)AUDIO_BLOCK_SAMPLES * 1000000 / AUDIO_SAMPLE_RATE;
+  if (pendingCount > 0)
+  {
+    int64_t firstBar = pending[0].point / ((int64_t)subdivisions * grid.beatsPerBar);
+    int64_t currentBar = (blockEnd - grid.anchorUs) / barUs;
+    if (currentBar > firstBar)
+      sendPending();
+  }
+}
@@ -1,103 +1,83 @@
 #include "scale_and_chord_notes.h"
-
-// Intervals
-const int T = 2;
-const int S = 1;
-
-// Scale definitions using structs
-ScalePattern scales[MAX_SCALE_TYPES] = {
-    {"Major", {T, T, S, T, T, T, S}, 7},
-    {"Minor", {T, S, T, T, S, T, T}, 7},
-    {"Diminished Whole-Half", {T, S, T, S, T, S, T, S}, 8},
-    {"Diminished Half-Whole", {S, T, S, T, S, T, S, T}, 8}
-};
+#include "trace_log.h"
 
 const char* noteNames[12] = {
   "C", "C#", "D", "D#", "E", "F",
   "F#", "G", "G#", "A", "A#", "B"
 };
 
-// Helper function to find scale by name
-int findScaleIndex(const char* scaleName) {
-    for (int i = 0; i < MAX_SCALE_TYPES; i++) {
-        if (strcmp(scales[i].name, scaleName) == 0) {
+PitchClassSet scalePitchSet(int root, int scaleId) {
+    if (scaleId < 0 || scaleId >= SCALE_TYPE_COUNT) return 0;
+    return rotatePitchSet(scaleCatalogue[scaleId].intervals, root);
+}
+
+PitchClassSet chordPitchSet(int root, int chordId) {
+    if (chordId < 0 || chordId >= CHORD_TYPE_COUNT) return 0;
+    return rotatePitchSet(chordCatalogue[chordId].intervals, root);
+}
+
+// Helper function to find a catalogue entry by name
+static int findPatternIndex(const PitchPattern* catalogue, int count, const char* name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(catalogue[i].name, name) == 0) {
             return i;
         }
     }
     return -1; // Not found
 }
 
-// Generate a scale
-int generateScale(int root, const char* scaleName, int* output) {
-    int scaleIndex = findScaleIndex(scaleName);
-    if (scaleIndex == -1) {
-        Serial.println("Scale not found!");
-        return 0;
-    }
+int findScaleIndex(const char* scaleName) {
+    return findPatternIndex(scaleCatalogue, SCALE_TYPE_COUNT, scaleName);
+}
 
-    ScalePattern& scale = scales[scaleIndex];
-    int current = root;
-    output[0] = current;
-    int count = 1;
+int findChordIndex(const char* chordType) {
+    return findPatternIndex(chordCatalogue, CHORD_TYPE_COUNT, chordType);
+}
 
-    for (int i = 0; i < scale.length; i++) {
-        current = (current + scale.intervals[i]) % 12;
-        output[count++] = current;
-        if (count >= MAX_SCALE_NOTES) break;
+// Walk the interval set upwards from the root, writing absolute pitch classes
+static int expandPattern(int root, PitchClassSet intervals, int* output, int maxNotes) {
+    int count = 0;
+    for (int interval = 0; interval < 12 && count < maxNotes; interval++) {
+        if (pitchSetHas(intervals, interval)) {
+            output[count++] = (root + interval) % 12;
+        }
     }
+    return count;
+}
 
-    // Debug print to Serial
-    Serial.print("Generated ");
-    Serial.print(scaleName);
-    Serial.print(" scale: ");
-    for (int i = 0; i < count; i++) {
-        Serial.print(noteNames[output[i]]);
-        Serial.print(" ");
+// Generate a scale
+int generateScaleById(int root, int scaleId, int* output) {
+    if (root < 0 || root >= 12 || scaleId < 0 || scaleId >= SCALE_TYPE_COUNT) {
+        LOG_WARN(TRACE_SCALE_NOT_FOUND, root, scaleId);
+        return 0;
     }
-    Serial.println();
 
-    Serial.print("Note indices: ");
-    for (int i = 0; i < count; i++) {
-        Serial.print(output[i]);
-        Serial.print(" ");
-    }
-    Serial.println();
+    const PitchPattern& scale = scaleCatalogue[scaleId];
+    int count = expandPattern(root, scale.intervals, output, MAX_SCALE_NOTES - 1);
+    output[count++] = root; // close on the octave
 
+    LOG_DEBUG(TRACE_SCALE_GENERATED, scaleId, root, count, rotatePitchSet(scale.intervals, root));
     return count;
 }
 
 // Generate a chord
-int generateChord(int root, const char* chordType, int* output) {
-    int scaleNotes[MAX_SCALE_NOTES];
-    int scaleCount = generateScale(root, chordType, scaleNotes);
-    
-    if (scaleCount < 5) {
-        Serial.println("Not enough notes for chord!");
+int generateChordById(int root, int chordId, int* output) {
+    if (root < 0 || root >= 12 || chordId < 0 || chordId >= CHORD_TYPE_COUNT) {
+        LOG_WARN(TRACE_CHORD_NOT_FOUND, root, chordId);
         return 0;
     }
 
-    output[0] = root;           // root
-    output[1] = scaleNotes[2];  // third
-    output[2] = scaleNotes[4];  // fifth
-    
-    int chordCount = 3;
+    const PitchPattern& chord = chordCatalogue[chordId];
+    int count = expandPattern(root, chord.intervals, output, MAX_CHORD_NOTES);
 
-    // Debug print to Serial
-    Serial.print("Generated ");
-    Serial.print(chordType);
-    Serial.print(" chord: ");
-    for (int i = 0; i < chordCount; i++) {
-        Serial.print(noteNames[output[i]]);
-        Serial.print(" ");
-    }
-    Serial.println();
+    LOG_DEBUG(TRACE_CHORD_GENERATED, chordId, root, count, rotatePitchSet(chord.intervals, root));
+    return count;
+}
 
-    Serial.print("Chord indices: ");
-    for (int i = 0; i < chordCount; i++) {
-        Serial.print(output[i]);
-        Serial.print(" ");
-    }
-    Serial.println();
+int generateScale(int root, const char* scaleName, int* output) {
+    return generateScaleById(root, findScaleIndex(scaleName), output);
+}
 
-    return chordCount;
-}
\ No newline at end of file
+int generateChord(int root, const char* chordType, int* output) {
+    return generateChordById(root, findChordIndex(chordType), output);
+}
@@ -0,0 +1,322 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "sequencer.h"
+#include "command_queue.h"
+#include "render_task.h"
+#include "shape_index.h"
+#include "event_stream.h"
+#include "trace_log.h"
+
+static esp_timer_handle_t stepTimer = nullptr;
+static uint8_t arena[SEQUENCE_ARENA_SIZE];
+
+// Shared between the BLE task and the timer callback; hold sequenceLock
+static portMUX_TYPE sequenceLock = portMUX_INITIALIZER_UNLOCKED;
+static size_t arenaUsed = 0;
+static int stepCount = 0;
+static size_t cursor = 0; // arena offset of the next step
+static int stepIndex = -1; // step on the LEDs
+static SequenceState state = SEQUENCE_STOPPED;
+static uint16_t bpm = SEQUENCE_DEFAULT_BPM;
+static bool looping = false;
+static int64_t stepDeadline = 0;    // esp_timer time at which the next step starts
+static int64_t pausedRemaining = 0; // time left on the current step when paused
+
+static int64_t ticksToMicros(uint16_t ticks, uint16_t beatsPerMinute)
+{
+  return (int64_t)ticks * 60000000LL / ((int64_t)beatsPerMinute * SEQUENCE_TICKS_PER_BEAT);
+}
+
+static uint16_t readU16(const uint8_t *data)
+{
+  return (uint16_t)(data[0] | (data[1] << 8));
+}
+
+// Turn one step record into a display command. The body is checked against
+// its kind, so this also validates uploads. Returns false if it does not fit.
+static bool decodeStep(const uint8_t *record, PixelCommand &command)
+{
+  FrameView body;
+  body.length = record[3];
+  body.payload = record + SEQUENCE_STEP_HEADER;
+
+  command.type = (CommandType)record[0];
+  command.count = 0;
+  switch (record[0])
+  {
+  case CMD_CHORD:
+    body.opcode = FRAME_OP_CHORD;
+    command.count = decodeChordFrame(body, command.frets, 6);
+    return command.count == 6;
+  case CMD_SCALE:
+    body.opcode = FRAME_OP_SCALE;
+    command.count = decodeScaleFrame(body, command.scaleData, MAX_SCALE_PAIRS);
+    return command.count > 0;
+  case CMD_SHAPE:
+    body.opcode = FRAME_OP_SHAPE;
+    return decodeShapeFrame(body, &command.root, &command.shapeType, &command.voicing) &&
+           isShapeId(command.root, command.shapeType, command.voicing);
+  case CMD_MASK:
+    if (body.length != 3 + SEQUENCE_MASK_BYTES)
+      return false;
+    command.color = ((uint32_t)body.payload[0] << 16) | ((uint32_t)body.payload[1] << 8) | body.payload[2];
+    cellMaskClear(command.mask);
+    for (int cell = 0; cell < FRETBOARD_CELLS; cell++)
+    {
+      if ((body.payload[3 + cell / 8] >> (cell % 8)) & 1)
+        cellMaskSet(command.mask, cell);
+    }
+    return true;
+  case CMD_CLEAR:
+    return body.length == 0;
+  default:
+    return false;
+  }
+}
+
+// Wake the timer task at `deadline` (any task). One-shot, so nothing runs
+// between steps. A callback that finds nothing due just returns, so a wake
+// armed for an older deadline (a pause or tempo change racing with a step)
+// costs one spurious call at most.
+static void armStepTimer(int64_t deadline)
+{
+  int64_t delay = deadline - esp_timer_get_time();
+  esp_timer_stop(stepTimer);
+  // A racing callback may re-arm between the stop and the start; the
+  // deadline set here is the newer one, so replace its wake
+  while (esp_timer_start_once(stepTimer, delay > 0 ? (uint64_t)delay : 0) == ESP_ERR_INVALID_STATE)
+    esp_timer_stop(stepTimer);
+}
+
+// Fires at each step's deadline while playing. Deadlines advance by the step
+// length from the previous deadline, never from "now", so timer latency does
+// not add up. Only the step record is copied under the lock; it is decoded
+// after, with interrupts back on.
+static void onStepTimer(void *arg)
+{
+  (void)arg;
+  uint8_t record[SEQUENCE_STEP_HEADER + 255];
+  int started = -1;
+  bool ended = false;
+
+  portENTER_CRITICAL(&sequenceLock);
+  if (state == SEQUENCE_PLAYING && esp_timer_get_time() >= stepDeadline)
+  {
+    if (cursor >= arenaUsed && looping)
+    {
+      cursor = 0;
+      stepIndex = -1;
+    }
+
+    if (cursor >= arenaUsed)
+    {
+      // Last step done; it stays lit until something else is drawn
+      state = SEQUENCE_STOPPED;
+      ended = true;
+    }
+    else
+    {
+      const uint8_t *step = arena + cursor;
+      size_t size = SEQUENCE_STEP_HEADER + step[3];
+      memcpy(record, step, size);
+      stepDeadline += ticksToMicros(readU16(step + 1), bpm);
+      cursor += size;
+      started = ++stepIndex;
+    }
+  }
+  bool playing = state == SEQUENCE_PLAYING;
+  int64_t nextDeadline = stepDeadline;
+  portEXIT_CRITICAL(&sequenceLock);
+
+  if (ended)
+    eventSequenceStep(SEQUENCE_ENDED);
+
+  if (started >= 0)
+  {
+    PixelCommand command;
+    decodeStep(record, command); // validated on upload
+    command.receivedAt = micros();
+    command.sequence = -1;
+    submitSequenceStep(command);
+    eventSequenceStep((uint16_t)started);
+  }
+
+  // Early (an older deadline) or a step just started: wait for the next one.
+  // Fails harmlessly if the BLE task has already armed a newer deadline.
+  if (playing)
+  {
+    int64_t delay = nextDeadline - esp_timer_get_time();
+    esp_timer_start_once(stepTimer, delay > 0 ? (uint64_t)delay : 0);
+  }
+}
+
+static void logState()
+{
+  LOG_INFO(TRACE_SEQUENCE_STATE, state, stepCount, bpm, looping);
+}
+
+void setupSequencer()
+{
+  esp_timer_create_args_t args = {};
+  args.callback = onStepTimer;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "sequencer";
+  args.skip_unhandled_events = true;
+  esp_timer_create(&args, &stepTimer);
+}
+
+static uint8_t appendSteps(const uint8_t *data, size_t length)
+{
+  // Check every record before touching the arena, so a bad frame adds nothing
+  PixelCommand scratch;
+  int added = 0;
+  for (size_t offset = 0; offset < length; added++)
+  {
+    if (length - offset < SEQUENCE_STEP_HEADER ||
+        length - offset < (size_t)SEQUENCE_STEP_HEADER + data[offset + 3] ||
+        readU16(data + offset + 1) == 0 || !decodeStep(data + offset, scratch))
+      return REJECT_MALFORMED;
+    offset += SEQUENCE_STEP_HEADER + data[offset + 3];
+  }
+  if (added == 0)
+    return REJECT_MALFORMED;
+
+  uint8_t reason = 0;
+  portENTER_CRITICAL(&sequenceLock);
+  if (arenaUsed + length > SEQUENCE_ARENA_SIZE)
+    reason = REJECT_NO_ROOM;
+  else
+  {
+    // Only bytes past arenaUsed change, so this is safe while playing
+    memcpy(arena + arenaUsed, data, length);
+    arenaUsed += length;
+    stepCount += added;
+  }
+  portEXIT_CRITICAL(&sequenceLock);
+  return reason;
+}
+
+void stopSequence()
+{
+  portENTER_CRITICAL(&sequenceLock);
+  state = SEQUENCE_STOPPED;
+  cursor = 0;
+  stepIndex = -1;
+  portEXIT_CRITICAL(&sequenceLock);
+  esp_timer_stop(stepTimer);
+}
+
+uint8_t sequencerHandleFrame(const FrameView &frame)
+{
+  if (frame.opcode != FRAME_OP_SEQUENCE || frame.length == 0)
+    return REJECT_MALFORMED;
+
+  const uint8_t *args = frame.payload + 1;
+  size_t argLength = frame.length - 1;
+  int64_t now = esp_timer_get_time();
+
+  switch (frame.payload[0])
+  {
+  case SEQ_OP_BEGIN:
+  {
+    if (argLength != 3)
+      return REJECT_MALFORMED;
+    uint16_t newBpm = readU16(args);
+    if (newBpm < SEQUENCE_MIN_BPM || newBpm > SEQUENCE_MAX_BPM)
+      return REJECT_MALFORMED;
+
+    portENTER_CRITICAL(&sequenceLock);
+    state = SEQUENCE_STOPPED;
+    arenaUsed = 0;
+    stepCount = 0;
+    cursor = 0;
+    stepIndex = -1;
+    bpm = newBpm;
+    looping = args[2] != 0;
+    portEXIT_CRITICAL(&sequenceLock);
+    esp_timer_stop(stepTimer);
+    break;
+  }
+  case SEQ_OP_STEPS:
+    return appendSteps(args, argLength);
+  case SEQ_OP_PLAY:
+  {
+    bool empty;
+    int64_t deadline;
+    portENTER_CRITICAL(&sequenceLock);
+    empty = arenaUsed == 0;
+    if (!empty && state == SEQUENCE_PAUSED)
+    {
+      stepDeadline = now + pausedRemaining;
+      state = SEQUENCE_PLAYING;
+    }
+    else if (!empty && state == SEQUENCE_STOPPED)
+    {
+      cursor = 0;
+      stepIndex = -1;
+      stepDeadline = now;
+      state = SEQUENCE_PLAYING;
+    }
+    deadline = stepDeadline;
+    portEXIT_CRITICAL(&sequenceLock);
+
+    if (empty)
+      return REJECT_MALFORMED;
+    armStepTimer(deadline);
+    break;
+  }
+  case SEQ_OP_PAUSE:
+    portENTER_CRITICAL(&sequenceLock);
+    if (state == SEQUENCE_PLAYING)
+    {
+      pausedRemaining = stepDeadline > now ? stepDeadline - now : 0;
+      state = SEQUENCE_PAUSED;
+    }
+    portEXIT_CRITICAL(&sequenceLock);
+    esp_timer_stop(stepTimer);
+    break;
+  case SEQ_OP_STOP:
+    stopSequence();
+    requestClear();
+    break;
+  case SEQ_OP_TEMPO:
+  {
+    if (argLength != 2)
+      return REJECT_MALFORMED;
+    uint16_t newBpm = readU16(args);
+    if (newBpm < SEQUENCE_MIN_BPM || newBpm > SEQUENCE_MAX_BPM)
+      return REJECT_MALFORMED;
+
+    // Whatever is left of the current step stretches or shrinks with the tempo
+    bool rearm = false;
+    int64_t deadline;
+    portENTER_CRITICAL(&sequenceLock);
+    if (state == SEQUENCE_PLAYING && stepDeadline > now)
+    {
+      stepDeadline = now + (stepDeadline - now) * bpm / newBpm;
+      rearm = true;
+    }
+    else if (state == SEQUENCE_PAUSED)
+      pausedRemaining = pausedRemaining * bpm / newBpm;
+    bpm = newBpm;
+    deadline = stepDeadline;
+    portEXIT_CRITICAL(&sequenceLock);
+
+    if (rearm)
+      armStepTimer(deadline);
+    break;
+  }
+  case SEQ_OP_LOOP:
+    if (argLength != 1)
+      return REJECT_MALFORMED;
+    portENTER_CRITICAL(&sequenceLock);
+    looping = args[0] != 0;
+    portEXIT_CRITICAL(&sequenceLock);
+    break;
+  default:
+    return REJECT_MALFORMED;
+  }
+
+  logState();
+  return 0;
+}
@@ -0,0 +1,98 @@
+#include <Arduino.h>
+#include "shape_index.h"
+#include "chord_voicing.h"
+
+static_assert(FRETBOARD_FRETS <= 32, "one string's frets are a 32-bit column");
+
+#define SHAPE_FRET_BITS (FRETBOARD_FRETS == 32 ? 0xFFFFFFFFu : (1u << FRETBOARD_FRETS) - 1)
+
+// Scales first, then chords. Built for the tuning by retuneShapeIndex().
+struct ShapeIndex
+{
+  CellMask masks[12][SHAPE_COUNT];
+};
+
+// Every cell on one string, per string
+struct StringCells
+{
+  CellMask strings[FRETBOARD_STRINGS];
+};
+
+static constexpr StringCells buildStringCells()
+{
+  StringCells cells = {};
+  for (int string = 0; string < FRETBOARD_STRINGS; string++)
+  {
+    for (int fret = 0; fret < FRETBOARD_FRETS; fret++)
+      cellMaskSet(cells.strings[string], fret * FRETBOARD_STRINGS + string);
+  }
+  return cells;
+}
+
+static constexpr StringCells stringCells = buildStringCells();
+static ShapeIndex shapeIndex;
+
+// Frets of a string whose note is in the set, bit n = fret n
+static constexpr uint32_t shapeColumn(PitchClassSet notes, int openPitch, int capo, bool chord)
+{
+  // Rotated down by the open note, bit n is fret n's note; the octave
+  // repeats up the neck
+  uint32_t octave = rotatePitchSet(notes, -openPitch);
+  uint32_t column = (octave | octave << 12 | octave << 24) & SHAPE_FRET_BITS & ~((1u << capo) - 1);
+  return chord ? column & (0u - column) : column; // chords only take the lowest matching fret
+}
+
+// E major triad in standard tuning: open low E, fret 1 (G#) on the G string
+static_assert(shapeColumn(pitchSet(4, 8, 11), 4, 0, true) == 0x1 && shapeColumn(pitchSet(4, 8, 11), 7, 0, true) == 0x2,
+              "shape column does not match standard tuning");
+
+void retuneShapeIndex(const uint8_t *openPitch, int capo, uint32_t strings)
+{
+  for (int string = 0; string < FRETBOARD_STRINGS; string++)
+  {
+    if (((strings >> string) & 1) == 0)
+      continue;
+
+    const CellMask &column = stringCells.strings[string];
+    for (int root = 0; root < 12; root++)
+    {
+      for (int shape = 0; shape < SHAPE_COUNT; shape++)
+      {
+        bool chord = shape >= SCALE_TYPE_COUNT;
+        PitchClassSet intervals = chord ? chordCatalogue[shape - SCALE_TYPE_COUNT].intervals : scaleCatalogue[shape].intervals;
+        CellMask &mask = shapeIndex.masks[root][shape];
+        for (int word = 0; word < CELL_MASK_WORDS; word++)
+          mask.words[word] &= ~column.words[word];
+
+        uint32_t frets = shapeColumn(rotatePitchSet(intervals, root), openPitch[string], capo, chord);
+        for (; frets != 0; frets &= frets - 1)
+          cellMaskSet(mask, __builtin_ctz(frets) * FRETBOARD_STRINGS + string);
+      }
+    }
+  }
+}
+
+const CellMask *getShapeMask(int root, int type)
+{
+  if (root < 0 || root >= 12)
+    return nullptr;
+
+  if (isChordShape(type))
+  {
+    int chord = type & ~SHAPE_CHORD_FLAG;
+    return (chord < CHORD_TYPE_COUNT) ? &shapeIndex.masks[root][SCALE_TYPE_COUNT + chord] : nullptr;
+  }
+  return (type >= 0 && type < SCALE_TYPE_COUNT) ? &shapeIndex.masks[root][type] : nullptr;
+}
+
+bool isChordShape(int type)
+{
+  return (type & SHAPE_CHORD_FLAG) != 0;
+}
+
+bool isShapeId(int root, int type, int voicing)
+{
+  if (getShapeMask(root, type) == nullptr)
+    return false;
+  return isChordShape(type) ? voicing >= 0 && voicing < VOICING_MAX_RESULTS : voicing == 0;
+}
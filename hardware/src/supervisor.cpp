@@ -0,0 +1,191 @@
+#include <Arduino.h>
+#include <atomic>
+#include "supervisor.h"
+#include "main.h"
+#include "bluetooth.h"
+#include "frame_buffer.h"
+#include "link_tuning.h"
+#include "render_task.h"
+#include "sequencer.h"
+#include "effects.h"
+#include "touch_sensing.h"
+#include "audio_input.h"
+#include "event_stream.h"
+#include "trace_log.h"
+
+#if __has_include("esp_pm.h")
+#include "esp_pm.h"
+#include "esp_idf_version.h"
+#endif
+#if defined(CONFIG_PM_ENABLE) && !defined(GUITARPAL_NO_SLEEP)
+#define SUPERVISOR_USE_PM 1
+#else
+#define SUPERVISOR_USE_PM 0
+#endif
+
+static QueueHandle_t systemQueue = nullptr;
+static TaskHandle_t statusTaskHandle = nullptr;
+static std::atomic<bool> clientConnected(false);
+static PowerMode powerMode = POWER_MODE_NONE;
+#if SUPERVISOR_USE_PM
+static esp_pm_lock_handle_t ledPushLock = nullptr;
+static esp_pm_lock_handle_t audioLock = nullptr;
+#endif
+
+static void setupPowerManagement()
+{
+#if SUPERVISOR_USE_PM
+#if ESP_IDF_VERSION_MAJOR >= 5
+  esp_pm_config_t config = {};
+#else
+  esp_pm_config_esp32_t config = {};
+#endif
+  config.max_freq_mhz = POWER_MAX_FREQ_MHZ;
+  config.min_freq_mhz = POWER_MIN_FREQ_MHZ;
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+  config.light_sleep_enable = true;
+  PowerMode configuredMode = POWER_MODE_LIGHT_SLEEP;
+#else
+  PowerMode configuredMode = POWER_MODE_DFS;
+#endif
+  esp_err_t err = esp_pm_configure(&config);
+  if (err == ESP_OK)
+    err = esp_pm_lock_create(ESP_PM_APB_FREQ_MAX, 0, "ledpush", &ledPushLock);
+  if (err == ESP_OK)
+    err = esp_pm_lock_create(ESP_PM_CPU_FREQ_MAX, 0, "audio", &audioLock);
+  if (err == ESP_OK)
+  {
+    powerMode = configuredMode;
+    if (powerMode == POWER_MODE_DFS)
+      LOG_WARN(TRACE_POWER_NO_LIGHT_SLEEP);
+  }
+  else
+  {
+    powerMode = POWER_MODE_UNAVAILABLE;
+    LOG_WARN(TRACE_POWER_FAILED, err);
+  }
+#elif !defined(GUITARPAL_NO_SLEEP)
+  // Reported with every EVENT_POWER as well
+  powerMode = POWER_MODE_UNAVAILABLE;
+  LOG_WARN(TRACE_POWER_UNAVAILABLE);
+#endif
+  LOG_INFO(TRACE_POWER_MODE, powerMode);
+}
+
+// Status LEDs follow the connection state; sleeps until it changes
+static void statusTask(void *parameter)
+{
+  (void)parameter;
+  for (;;)
+  {
+    bool connected = clientConnected.load();
+    digitalWrite(BL_CONNECTED_PIN, connected ? HIGH : LOW);
+    digitalWrite(BL_DISCONNECTED_PIN, connected ? LOW : HIGH);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+}
+
+static void handleEvent(SystemEvent event)
+{
+  switch (event)
+  {
+  case SYSTEM_CONNECTED:
+    LOG_INFO(TRACE_CLIENT_CONNECTED);
+    clientConnected.store(true);
+    eventStreamConnected();
+    startTouchScanning();
+    break;
+  case SYSTEM_DISCONNECTED:
+  {
+    LOG_INFO(TRACE_CLIENT_DISCONNECTED);
+    clientConnected.store(false);
+    stopSequence();
+    stopTouchScanning();
+    stopAudio();
+    resetEffects();
+    requestClear();
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+    FrameStats stats = getFrameStats();
+    LOG_INFO(TRACE_FRAME_STATS, (int)stats.pushesIssued, (int)stats.pushesSkipped);
+#endif
+    BLEDevice::startAdvertising();
+    LOG_INFO(TRACE_ADVERTISING_RESTARTED);
+    break;
+  }
+  case SYSTEM_LINK_ACTIVE:
+    break; // nothing to do but recompute the idle timeout below
+  }
+  xTaskNotifyGive(statusTaskHandle);
+}
+
+static void supervisorTask(void *parameter)
+{
+  (void)parameter;
+  TickType_t wait = portMAX_DELAY;
+  uint8_t event;
+
+  for (;;)
+  {
+    // Block until something happens or the link's idle timeout is due
+    if (xQueueReceive(systemQueue, &event, wait) == pdTRUE)
+      handleEvent((SystemEvent)event);
+
+    uint32_t next = updateLinkMode();
+    wait = (next == LINK_NO_DEADLINE) ? portMAX_DELAY : pdMS_TO_TICKS(next);
+  }
+}
+
+void startSupervisor()
+{
+  setupPowerManagement();
+
+  systemQueue = xQueueCreate(SUPERVISOR_QUEUE_SIZE, sizeof(uint8_t));
+  xTaskCreatePinnedToCore(statusTask, "status", STATUS_TASK_STACK, nullptr,
+                          STATUS_TASK_PRIORITY, &statusTaskHandle, STATUS_TASK_CORE);
+  xTaskCreatePinnedToCore(supervisorTask, "supervisor", SUPERVISOR_TASK_STACK, nullptr,
+                          SUPERVISOR_TASK_PRIORITY, nullptr, SUPERVISOR_TASK_CORE);
+}
+
+void postSystemEvent(SystemEvent event)
+{
+  uint8_t value = event;
+  if (systemQueue != nullptr)
+    xQueueSend(systemQueue, &value, 0);
+}
+
+PowerMode getPowerMode()
+{
+  return powerMode;
+}
+
+void ledPushBegin()
+{
+#if SUPERVISOR_USE_PM
+  if (ledPushLock != nullptr)
+    esp_pm_lock_acquire(ledPushLock);
+#endif
+}
+
+void ledPushEnd()
+{
+#if SUPERVISOR_USE_PM
+  if (ledPushLock != nullptr)
+    esp_pm_lock_release(ledPushLock);
+#endif
+}
+
+void audioCaptureBegin()
+{
+#if SUPERVISOR_USE_PM
+  if (audioLock != nullptr)
+    esp_pm_lock_acquire(audioLock);
+#endif
+}
+
+void audioCaptureEnd()
+{
+#if SUPERVISOR_USE_PM
+  if (audioLock != nullptr)
+    esp_pm_lock_release(audioLock);
+#endif
+}
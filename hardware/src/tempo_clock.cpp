@@ -0,0 +1,60 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "tempo_clock.h"
+#include "render_task.h"
+
+static portMUX_TYPE gridLock = portMUX_INITIALIZER_UNLOCKED;
+static TempoGrid grid = {0, 0, 0, 4};
+static esp_timer_handle_t beatTimer = nullptr;
+
+static void onBeat(void *arg)
+{
+  (void)arg;
+  requestFrame();
+}
+
+void setupTempoClock()
+{
+  esp_timer_create_args_t args = {};
+  args.callback = onBeat;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "beat";
+  args.skip_unhandled_events = true;
+  esp_timer_create(&args, &beatTimer);
+}
+
+void tempoClockSet(uint16_t bpm, uint8_t beatsPerBar)
+{
+  if (beatTimer != nullptr)
+    esp_timer_stop(beatTimer); // not running is fine
+
+  TempoGrid next;
+  next.periodUs = bpm != 0 ? 60000000LL / bpm : 0;
+  next.bpm = bpm;
+  next.beatsPerBar = beatsPerBar;
+  next.anchorUs = esp_timer_get_time();
+  if (beatTimer != nullptr && next.periodUs > 0)
+    esp_timer_start_periodic(beatTimer, (uint64_t)next.periodUs);
+
+  portENTER_CRITICAL(&gridLock);
+  grid = next;
+  portEXIT_CRITICAL(&gridLock);
+}
+
+TempoGrid tempoClockGrid()
+{
+  portENTER_CRITICAL(&gridLock);
+  TempoGrid copy = grid;
+  portEXIT_CRITICAL(&gridLock);
+  return copy;
+}
+
+int64_t tempoGridNearest(const TempoGrid &grid, int subdivisions, int64_t atUs, int32_t *errorUs)
+{
+  // In units of period / subdivisions without rounding the step, so long
+  // sessions do not drift off the timer's beats
+  int64_t scaled = (atUs - grid.anchorUs) * subdivisions;
+  int64_t index = (scaled >= 0 ? scaled + grid.periodUs / 2 : scaled - grid.periodUs / 2) / grid.periodUs;
+  *errorUs = (int32_t)((scaled - index * grid.periodUs) / subdivisions);
+  return index;
+}
@@ -0,0 +1,211 @@
+#include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
+#include <driver/touch_pad.h>
+#include "touch_sensing.h"
+#include "main.h"
+#include "event_stream.h"
+#include "chord_check.h"
+#include "trace_log.h"
+
+static_assert(FRETBOARD_FRETS <= (1 << TOUCH_ROW_BITS), "not enough mux address pins for every fret row");
+static_assert(TOUCH_SCAN_PERIOD_US <= 2000, "the full neck must be scanned at 500 Hz or more");
+static_assert(FRETBOARD_FRETS * TOUCH_ROW_US <= TOUCH_SCAN_PERIOD_US * 3 / 4, "a full scan must leave the touch task idle between ticks");
+static_assert(TOUCH_DEBOUNCE_SCANS >= 2, "debouncing needs at least two scans");
+
+static const uint8_t stringPads[NUM_STRINGS] = TOUCH_STRING_PADS;
+static const uint8_t rowPins[TOUCH_ROW_BITS] = TOUCH_ROW_PINS;
+
+static TaskHandle_t touchTaskHandle = nullptr;
+static esp_timer_handle_t scanTimer = nullptr;
+static std::atomic<bool> scanInProgress(false);
+static std::atomic<bool> resetPending(false);
+static std::atomic<bool> scanning(false);
+
+static TouchScanner scanner; // touch task only
+static TouchStats touchStats = {};
+
+// Published mask, read by any task
+static portMUX_TYPE maskLock = portMUX_INITIALIZER_UNLOCKED;
+static CellMask publishedMask = {};
+
+void touchScannerReset(TouchScanner &scanner)
+{
+  for (int cell = 0; cell < FRETBOARD_CELLS; cell++)
+  {
+    scanner.cells[cell].baseline = 0;
+    scanner.cells[cell].pending = 0;
+    scanner.cells[cell].pressed = false;
+  }
+  cellMaskClear(scanner.pressed);
+  scanner.scans = 0;
+}
+
+bool touchScannerUpdate(TouchScanner &scanner, const uint16_t *readings)
+{
+  scanner.scans++;
+  if (scanner.scans <= TOUCH_CALIBRATION_SCANS)
+  {
+    // Sum the calibration scans, then turn the sums into the first baselines
+    for (int cell = 0; cell < FRETBOARD_CELLS; cell++)
+    {
+      scanner.cells[cell].baseline += readings[cell];
+      if (scanner.scans == TOUCH_CALIBRATION_SCANS)
+        scanner.cells[cell].baseline = (scanner.cells[cell].baseline << TOUCH_BASELINE_SHIFT) / TOUCH_CALIBRATION_SCANS;
+    }
+    return false;
+  }
+
+  bool changed = false;
+  for (int cell = 0; cell < FRETBOARD_CELLS; cell++)
+  {
+    TouchCell &state = scanner.cells[cell];
+    int32_t signal = (state.baseline >> TOUCH_BASELINE_SHIFT) - readings[cell];
+
+    bool pressed = signal >= (state.pressed ? TOUCH_RELEASE_SIGNAL : TOUCH_PRESS_SIGNAL);
+    if (pressed == state.pressed)
+      state.pending = 0;
+    else if (++state.pending >= TOUCH_DEBOUNCE_SCANS)
+    {
+      state.pressed = pressed;
+      state.pending = 0;
+      scanner.pressed.words[cell / 64] ^= (uint64_t)1 << (cell % 64);
+      changed = true;
+    }
+
+    // Follow drift only well clear of a press
+    if (!state.pressed && signal < TOUCH_RELEASE_SIGNAL)
+      state.baseline += readings[cell] - (state.baseline >> TOUCH_BASELINE_SHIFT);
+  }
+  return changed;
+}
+
+// One measurement window per row: the FSM measures every string channel at once
+static void scanMatrix(uint16_t *readings)
+{
+  for (int fret = 0; fret < FRETBOARD_FRETS; fret++)
+  {
+    for (int bit = 0; bit < TOUCH_ROW_BITS; bit++)
+      digitalWrite(rowPins[bit], (fret >> bit) & 1);
+    delayMicroseconds(TOUCH_SETTLE_US);
+
+    touch_pad_sw_start();
+    while (!touch_pad_meas_is_done())
+    {
+    }
+    for (int string = 0; string < NUM_STRINGS; string++)
+      touch_pad_read_raw_data((touch_pad_t)stringPads[string], &readings[fret * NUM_STRINGS + string]);
+  }
+}
+
+static void publishMask(const CellMask &mask)
+{
+  portENTER_CRITICAL(&maskLock);
+  publishedMask = mask;
+  portEXIT_CRITICAL(&maskLock);
+}
+
+static void touchTask(void *parameter)
+{
+  (void)parameter;
+  uint16_t readings[FRETBOARD_CELLS];
+
+  for (;;)
+  {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    if (resetPending.exchange(false))
+    {
+      touchScannerReset(scanner);
+      publishMask(scanner.pressed);
+      chordCheckTouch(scanner.pressed);
+    }
+
+    if (scanning.load())
+    {
+      uint32_t start = micros();
+      scanMatrix(readings);
+      if (touchScannerUpdate(scanner, readings))
+      {
+        publishMask(scanner.pressed);
+        eventTouch(scanner.pressed);
+        chordCheckTouch(scanner.pressed);
+      }
+
+      uint32_t elapsed = micros() - start;
+      touchStats.scans++;
+      if (elapsed > touchStats.maxScanMicros)
+        touchStats.maxScanMicros = elapsed;
+    }
+    scanInProgress.store(false);
+  }
+}
+
+// A tick that finds the last scan unfinished is counted and skipped, so a slow
+// scan stretches the period instead of queueing scans back to back
+static void onScanTimer(void *arg)
+{
+  (void)arg;
+  if (scanInProgress.exchange(true))
+  {
+    touchStats.late++;
+    return;
+  }
+  xTaskNotifyGive(touchTaskHandle);
+}
+
+void setupTouch()
+{
+  if (!TOUCH_ENABLED)
+    return;
+
+  for (int bit = 0; bit < TOUCH_ROW_BITS; bit++)
+    pinMode(rowPins[bit], OUTPUT);
+  touch_pad_init();
+  touch_pad_set_fsm_mode(TOUCH_FSM_MODE_SW);
+  touch_pad_set_meas_time(TOUCH_SLEEP_CYCLES, TOUCH_MEASURE_CYCLES);
+  for (int string = 0; string < NUM_STRINGS; string++)
+    touch_pad_config((touch_pad_t)stringPads[string], 0);
+
+  xTaskCreatePinnedToCore(touchTask, "touch", TOUCH_TASK_STACK, nullptr,
+                          TOUCH_TASK_PRIORITY, &touchTaskHandle, TOUCH_TASK_CORE);
+
+  esp_timer_create_args_t args = {};
+  args.callback = onScanTimer;
+  args.dispatch_method = ESP_TIMER_TASK;
+  args.name = "touch";
+  args.skip_unhandled_events = true;
+  esp_timer_create(&args, &scanTimer);
+}
+
+void startTouchScanning()
+{
+  if (scanTimer == nullptr || scanning.exchange(true))
+    return;
+  resetPending.store(true);
+  esp_timer_start_periodic(scanTimer, TOUCH_SCAN_PERIOD_US);
+}
+
+void stopTouchScanning()
+{
+  if (scanTimer == nullptr || !scanning.exchange(false))
+    return;
+  esp_timer_stop(scanTimer);
+  LOG_INFO(TRACE_TOUCH_STATS, (int)touchStats.scans, (int)touchStats.late, (int)touchStats.maxScanMicros);
+
+  // Nobody is touching a board nobody is connected to
+  resetPending.store(true);
+  xTaskNotifyGive(touchTaskHandle);
+}
+
+void getTouchMask(CellMask *mask)
+{
+  portENTER_CRITICAL(&maskLock);
+  *mask = publishedMask;
+  portEXIT_CRITICAL(&maskLock);
+}
+
+TouchStats getTouchStats()
+{
+  return touchStats;
+}
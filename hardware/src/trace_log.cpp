@@ -0,0 +1,127 @@
+#include <Arduino.h>
+#include <atomic>
+#include <stdio.h>
+#include "trace_log.h"
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+#define TRACE_EVENT_FORMAT(id, format) format,
+static const char *const traceFormats[TRACE_EVENT_COUNT] = {
+    TRACE_EVENTS(TRACE_EVENT_FORMAT)};
+#undef TRACE_EVENT_FORMAT
+
+static const char traceLevelTags[] = "-EWID";
+#endif
+
+// Multi-producer ring: every slot carries a sequence word saying whose turn it
+// is. Sequences are stored relative to the slot's lap base (position - index),
+// so an all-zero ring is already initialised and logging works before setup().
+//   sequence == base      slot free for the producer holding `position`
+//   sequence == base + 1  record written, ready for the consumer
+struct TraceSlot
+{
+  std::atomic<uint32_t> sequence;
+  TraceRecord record;
+};
+
+static TraceSlot traceRing[TRACE_RING_SIZE];
+static std::atomic<uint32_t> traceEnqueue(0); // next position to claim, shared by producers
+static uint32_t traceDequeue = 0;             // next position to read, trace task only
+static std::atomic<uint32_t> traceDropped(0);
+
+void traceLog(uint8_t level, TraceEvent event, int a0, int a1, int a2, int a3, int a4, int a5)
+{
+  uint32_t position = traceEnqueue.load(std::memory_order_relaxed);
+  TraceSlot *slot;
+  for (;;)
+  {
+    slot = &traceRing[position & (TRACE_RING_SIZE - 1)];
+    uint32_t base = position & ~(uint32_t)(TRACE_RING_SIZE - 1);
+    int32_t turn = (int32_t)(slot->sequence.load(std::memory_order_acquire) - base);
+    if (turn == 0)
+    {
+      // Our lap: claim the position unless another producer got there first
+      if (traceEnqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+        break;
+    }
+    else if (turn < 0)
+    {
+      // Consumer is a full lap behind
+      traceDropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    else
+    {
+      position = traceEnqueue.load(std::memory_order_relaxed);
+    }
+  }
+
+  TraceRecord &record = slot->record;
+  record.timestamp = (uint32_t)micros();
+  record.level = level;
+  record.event = event;
+  record.args[0] = a0;
+  record.args[1] = a1;
+  record.args[2] = a2;
+  record.args[3] = a3;
+  record.args[4] = a4;
+  record.args[5] = a5;
+  slot->sequence.store((position & ~(uint32_t)(TRACE_RING_SIZE - 1)) + 1, std::memory_order_release);
+}
+
+bool tracePop(TraceRecord *record)
+{
+  TraceSlot &slot = traceRing[traceDequeue & (TRACE_RING_SIZE - 1)];
+  uint32_t base = traceDequeue & ~(uint32_t)(TRACE_RING_SIZE - 1);
+  if (slot.sequence.load(std::memory_order_acquire) != base + 1)
+    return false;
+
+  *record = slot.record;
+  // Hand the slot to the producer of the next lap
+  slot.sequence.store(base + TRACE_RING_SIZE, std::memory_order_release);
+  traceDequeue++;
+  return true;
+}
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+static void printRecord(const TraceRecord &record)
+{
+  char line[128];
+  const char *format = record.event < TRACE_EVENT_COUNT ? traceFormats[record.event] : "Unknown event";
+  int prefix = snprintf(line, sizeof(line), "[%10lu] %c ", (unsigned long)record.timestamp,
+                        traceLevelTags[record.level <= LOG_LEVEL_DEBUG ? record.level : 0]);
+  snprintf(line + prefix, sizeof(line) - prefix, format, record.args[0], record.args[1], record.args[2],
+           record.args[3], record.args[4], record.args[5]);
+  Serial.println(line);
+}
+
+static void traceTask(void *parameter)
+{
+  (void)parameter;
+  TraceRecord record;
+
+  for (;;)
+  {
+    while (tracePop(&record))
+      printRecord(record);
+
+    uint32_t dropped = traceDropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0)
+    {
+      Serial.print("Trace ring full - dropped ");
+      Serial.print(dropped);
+      Serial.println(" records");
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(TRACE_DRAIN_PERIOD_MS));
+  }
+}
+
+#endif
+
+void startTraceTask()
+{
+#if LOG_LEVEL > LOG_LEVEL_NONE
+  xTaskCreatePinnedToCore(traceTask, "trace", TRACE_TASK_STACK, nullptr,
+                          TRACE_TASK_PRIORITY, nullptr, TRACE_TASK_CORE);
+#endif
+}
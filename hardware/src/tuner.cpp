@@ -0,0 +1,145 @@
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+#include <utility>
+#include "tuner.h"
+#include "main.h"
+#include "command_queue.h"
+#include "render_task.h"
+#include "event_stream.h"
+
+static_assert(PITCH_FRAME_SAMPLES % AUDIO_BLOCK_SAMPLES == 0, "the pitch frame is a whole number of blocks");
+
+// Display state, audio task only
+static TunerState tuner;
+static uint8_t shownString = TUNER_NO_STRING;
+static int shownRow = 0;
+static bool shownInTune = false;
+static uint32_t lastVoicedAt = 0;
+static uint32_t lastEventAt = 0;
+
+void tunerStateReset(TunerState &state)
+{
+  state.filled = 0;
+  state.periodCount = 0;
+}
+
+static uint32_t median3(uint32_t a, uint32_t b, uint32_t c)
+{
+  if (a > b)
+    std::swap(a, b);
+  if (b > c)
+    b = c;
+  return a > b ? a : b;
+}
+
+bool tunerAnalyze(TunerState &state, const int16_t *block, TunerReading *reading)
+{
+  const int keep = PITCH_FRAME_SAMPLES - AUDIO_BLOCK_SAMPLES;
+  memmove(state.frame, state.frame + AUDIO_BLOCK_SAMPLES, keep * sizeof(int16_t));
+  memcpy(state.frame + keep, block, AUDIO_BLOCK_SAMPLES * sizeof(int16_t));
+  if (state.filled < PITCH_FRAME_SAMPLES)
+  {
+    state.filled += AUDIO_BLOCK_SAMPLES;
+    if (state.filled < PITCH_FRAME_SAMPLES)
+      return false;
+  }
+
+  PitchEstimate estimate;
+  if (!estimatePitch(state.frame, &estimate))
+  {
+    state.periodCount = 0;
+    return false;
+  }
+
+  // The median of three rides out a single octave slip at the attack
+  state.periods[2] = state.periods[1];
+  state.periods[1] = state.periods[0];
+  state.periods[0] = estimate.periodQ8;
+  if (state.periodCount < 3)
+    state.periodCount++;
+  uint32_t period = state.periodCount == 3 ? median3(state.periods[0], state.periods[1], state.periods[2])
+                                           : estimate.periodQ8;
+
+  // One logarithm per block: cents from A4, then from each open string
+  uint32_t centiHz = pitchCentiHz(period);
+  float fromA4 = 1200.0f * log2f((float)centiHz / 44000.0f);
+  int nearest = 0;
+  float nearestCents = 0;
+  for (int string = 0; string < NUM_STRINGS; string++)
+  {
+    float cents = fromA4 - 100.0f * (openStringMidi[string] - 69);
+    if (string == 0 || fabsf(cents) < fabsf(nearestCents))
+    {
+      nearest = string;
+      nearestCents = cents;
+    }
+  }
+  if (fabsf(nearestCents) > TUNER_MAX_CENTS)
+    return false;
+
+  reading->string = (uint8_t)nearest;
+  reading->cents = (int16_t)lroundf(nearestCents);
+  reading->centiHz = centiHz;
+  reading->aperiodicity = estimate.aperiodicity;
+  return true;
+}
+
+int tunerNeedleRow(int cents)
+{
+  const int centre = FRETBOARD_FRETS / 2;
+  int rows = (cents + (cents < 0 ? -TUNER_CENTS_PER_ROW / 2 : TUNER_CENTS_PER_ROW / 2)) / TUNER_CENTS_PER_ROW;
+  if (rows < 1 - centre)
+    rows = 1 - centre; // row 0 is the nut
+  if (rows > FRETBOARD_FRETS - 1 - centre)
+    rows = FRETBOARD_FRETS - 1 - centre;
+  return centre + rows;
+}
+
+void resetTuner()
+{
+  tunerStateReset(tuner);
+  shownString = TUNER_NO_STRING;
+}
+
+void tunerProcessBlock(const int16_t *block)
+{
+  TunerReading reading;
+  uint32_t now = millis();
+
+  if (!tunerAnalyze(tuner, block, &reading))
+  {
+    if (shownString != TUNER_NO_STRING && now - lastVoicedAt >= TUNER_HOLD_MS)
+    {
+      shownString = TUNER_NO_STRING;
+      requestClear();
+      eventTuner(TUNER_NO_STRING, 0, 0, 0);
+    }
+    return;
+  }
+
+  lastVoicedAt = now;
+  int row = tunerNeedleRow(reading.cents);
+  bool inTune = abs(reading.cents) <= TUNER_IN_TUNE_CENTS;
+  bool moved = reading.string != shownString || row != shownRow || inTune != shownInTune;
+  if (moved)
+  {
+    PixelCommand command;
+    command.type = CMD_TUNER;
+    command.tunerString = reading.string;
+    command.cents = reading.cents;
+    command.receivedAt = micros();
+    command.sequence = -1;
+    submitAudioCommand(command);
+    shownString = reading.string;
+    shownRow = row;
+    shownInTune = inTune;
+  }
+
+  if (moved || now - lastEventAt >= TUNER_EVENT_INTERVAL_MS)
+  {
+    uint8_t clarity = (uint8_t)(100 - (uint32_t)reading.aperiodicity * 100 / 32768);
+    eventTuner(reading.string, reading.cents, reading.centiHz / 10, clarity);
+    lastEventAt = now;
+  }
+}
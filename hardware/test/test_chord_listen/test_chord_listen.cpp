@@ -0,0 +1,174 @@
+// Host regression tests for chord listening (chord_listen.h).
+//
+//   pio test -e native_test
+//
+// am_strums.wav and c_strums.wav each hold six downstrokes, 0.5 s apart, of
+// A minor (x02210: A2 E3 A3 C4 E4) and C major (x32010: C3 E3 G3 C4 E4):
+// Karplus-Strong strings, 3 ms between strings, 16-bit mono at
+// AUDIO_SAMPLE_RATE. The two share C and E, so a chroma that cannot tell A2
+// from the bass strings' neighbours scores them alike. Each recording must
+// score clearly higher against its own chord than the other one does.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include "chord_listen.h"
+#include "scale_and_chord_notes.h"
+
+#define STRUMS_PER_FILE 6
+#define MIN_MARGIN 25 // percent, between the mean scores
+
+// ================== Recordings ==================
+static std::string fixturePath(const char *name)
+{
+  std::string path(__FILE__);
+  size_t slash = path.find_last_of("/\\");
+  return (slash == std::string::npos ? std::string() : path.substr(0, slash + 1)) + name;
+}
+
+static uint32_t loadU32(const uint8_t *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// 16-bit mono PCM at AUDIO_SAMPLE_RATE, scaled to the ADC's 12 bits as
+// the audio task delivers it
+static std::vector<int16_t> loadRecording(const char *name)
+{
+  std::vector<int16_t> samples;
+  std::string path = fixturePath(name);
+  FILE *file = fopen(path.c_str(), "rb");
+  TEST_ASSERT_NOT_NULL_MESSAGE(file, path.c_str());
+
+  std::vector<uint8_t> bytes;
+  uint8_t chunk[4096];
+  size_t read;
+  while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0)
+    bytes.insert(bytes.end(), chunk, chunk + read);
+  fclose(file);
+  TEST_ASSERT_TRUE_MESSAGE(bytes.size() >= 12 && memcmp(bytes.data(), "RIFF", 4) == 0 && memcmp(bytes.data() + 8, "WAVE", 4) == 0, name);
+
+  bool format = false;
+  for (size_t at = 12; at + 8 <= bytes.size();)
+  {
+    uint32_t length = loadU32(bytes.data() + at + 4);
+    const uint8_t *body = bytes.data() + at + 8;
+    TEST_ASSERT_TRUE_MESSAGE(at + 8 + length <= bytes.size(), name);
+    if (memcmp(bytes.data() + at, "fmt ", 4) == 0)
+    {
+      TEST_ASSERT_EQUAL_UINT16_MESSAGE(1, body[0] | (body[1] << 8), name);  // PCM
+      TEST_ASSERT_EQUAL_UINT16_MESSAGE(1, body[2] | (body[3] << 8), name);  // mono
+      TEST_ASSERT_EQUAL_UINT32_MESSAGE(AUDIO_SAMPLE_RATE, loadU32(body + 4), name);
+      TEST_ASSERT_EQUAL_UINT16_MESSAGE(16, body[14] | (body[15] << 8), name);
+      format = true;
+    }
+    else if (memcmp(bytes.data() + at, "data", 4) == 0)
+    {
+      for (uint32_t i = 0; i + 1 < length; i += 2)
+        samples.push_back((int16_t)(body[i] | (body[i + 1] << 8)) / 16);
+    }
+    at += 8 + length + (length & 1);
+  }
+  TEST_ASSERT_TRUE_MESSAGE(format && !samples.empty(), name);
+  return samples;
+}
+
+struct Strums
+{
+  int count;
+  int scoreSum;
+  int heardCount[12]; // strums each pitch class was heard in
+};
+
+static Strums listen(const std::vector<int16_t> &samples, PitchClassSet chord)
+{
+  static ChordListenState state;
+  chordListenStateReset(state);
+  Strums strums = {};
+  for (size_t at = 0; at + AUDIO_BLOCK_SAMPLES <= samples.size(); at += AUDIO_BLOCK_SAMPLES)
+  {
+    ChordMatch match;
+    if (!chordListenAnalyze(state, samples.data() + at, chord, &match))
+      continue;
+    strums.count++;
+    strums.scoreSum += match.score;
+    for (int pitchClass = 0; pitchClass < 12; pitchClass++)
+      strums.heardCount[pitchClass] += pitchSetHas(match.heard, pitchClass) ? 1 : 0;
+  }
+  return strums;
+}
+
+// Right recording against its chord beats the wrong one by MIN_MARGIN
+static void checkMargin(const char *right, const char *wrong, PitchClassSet chord)
+{
+  Strums rightStrums = listen(loadRecording(right), chord);
+  Strums wrongStrums = listen(loadRecording(wrong), chord);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(STRUMS_PER_FILE, rightStrums.count, right);
+  TEST_ASSERT_EQUAL_INT_MESSAGE(STRUMS_PER_FILE, wrongStrums.count, wrong);
+
+  int rightMean = rightStrums.scoreSum / rightStrums.count;
+  int wrongMean = wrongStrums.scoreSum / wrongStrums.count;
+  char message[96];
+  snprintf(message, sizeof(message), "%s scored %d, %s %d", right, rightMean, wrong, wrongMean);
+  TEST_ASSERT_TRUE_MESSAGE(rightMean - wrongMean >= MIN_MARGIN, message);
+}
+
+// ================== Tests ==================
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_a_minor_beats_c_major()
+{
+  checkMargin("am_strums.wav", "c_strums.wav", chordPitchSet(9, CHORD_MINOR));
+}
+
+static void test_c_major_beats_a_minor()
+{
+  checkMargin("c_strums.wav", "am_strums.wav", chordPitchSet(0, CHORD_MAJOR));
+}
+
+// The pitch classes heard in most strums are the chord's own: overtones and
+// the neighbours of the bass notes stay under the heard threshold
+static void test_heard_is_the_chord()
+{
+  struct Recording
+  {
+    const char *name;
+    PitchClassSet chord;
+  };
+  const Recording recordings[] = {
+      {"am_strums.wav", chordPitchSet(9, CHORD_MINOR)},
+      {"c_strums.wav", chordPitchSet(0, CHORD_MAJOR)},
+  };
+
+  for (const Recording &recording : recordings)
+  {
+    Strums strums = listen(loadRecording(recording.name), recording.chord);
+    PitchClassSet usuallyHeard = 0;
+    for (int pitchClass = 0; pitchClass < 12; pitchClass++)
+    {
+      if (2 * strums.heardCount[pitchClass] >= strums.count)
+        usuallyHeard |= (PitchClassSet)(1u << pitchClass);
+    }
+    TEST_ASSERT_EQUAL_HEX16_MESSAGE(recording.chord, usuallyHeard, recording.name);
+  }
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_a_minor_beats_c_major);
+  RUN_TEST(test_c_major_beats_a_minor);
+  RUN_TEST(test_heard_is_the_chord);
+  return UNITY_END();
+}
@@ -0,0 +1,343 @@
+// Host tests for the chord and scale tokenizer (data_handling.h).
+//
+//   pio test -e native_test
+//
+// The original String parsers (legacy_parsers.h) are the reference for input
+// in the app's format: generated chords and scales, with the whitespace and
+// brackets the app may send, must parse to the same values. On anything else
+// the tokenizer is stricter by design, so mutated corpus entries are only
+// checked for what the firmware relies on: a count in range, nothing written
+// past the output, no negative scale values.
+
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+#include "data_handling.h"
+#include "legacy_parsers.h"
+#include "frame_buffer.h"
+#include "main.h"
+#include "pixel_mapping.h"
+
+#define GENERATED_CASES 2000
+#define MUTATED_CASES 20000
+#define MAX_CHORD_TOKENS 6
+#define MAX_SCALE_PAIRS 20
+#define FUZZ_SCALE_PAIRS 4 // small, so mutants overflow it often
+#define CANARY 0x5A5A5A5A
+#define MAX_INPUT 1024 // a 20-pair scale with the widest gaps
+
+// ================== Seed Corpus ==================
+// What the app sends, edge cases of the grammar, and inputs that must be
+// rejected. Also the seeds the mutation fuzzer starts from.
+static const char *const seedCorpus[] = {
+    "[-1, 3, 2, 0, 1, 0]",
+    "[3, 2, 0, 0, 0, 3]",
+    "[-1,-1,0,2,3,2]",
+    "  [ 0 , 2 , 2 , 1 , 0 , 0 ]  ",
+    "-1, 0, 2, 2, 1, 0",
+    "[12]",
+    "[]",
+    "[[0, 0], [0, 1], [0, 3], [1, 0], [1, 2], [1, 3]]",
+    "[[5,5],[5,7],[4,5],[4,7]]",
+    "[ [ 2 , 9 ] ,\t[3, 10]\r\n]",
+    "[0, 1], [2, 3]",
+    "[[0, -1]]",
+    "[[-1, 3]]",
+    "[[0, 1, 2]]",
+    "[[0], [1, 2]]",
+    "[[0, 1],]",
+    "[1, 2,, 3]",
+    "[1, 2",
+    "1, 2]",
+    "[[1, 2]",
+    "[12345]",
+    "[-]",
+    "[1 2]",
+    "[1, 2] x",
+    "[1, [2], 3]",
+    "[1, 2, 3, 4, 5, 6, 7]",
+    "[[0, 0], [1, 1], [2, 2], [3, 3], [4, 4]]",
+};
+
+#define SEED_COUNT (sizeof(seedCorpus) / sizeof(seedCorpus[0]))
+
+// ================== Input Generation ==================
+static uint32_t rngState = 0x2545F491;
+
+static uint32_t nextRandom()
+{
+  rngState ^= rngState << 13;
+  rngState ^= rngState >> 17;
+  rngState ^= rngState << 5;
+  return rngState;
+}
+
+static int randomBelow(int limit)
+{
+  return (int)(nextRandom() % (uint32_t)limit);
+}
+
+// Whitespace the app (or a hand-written lesson) may put between tokens
+static void appendSpace(char *text, size_t &length)
+{
+  static const char *const gaps[] = {"", "", " ", "  ", "\t", " \r\n "};
+  const char *gap = gaps[randomBelow(sizeof(gaps) / sizeof(gaps[0]))];
+  while (*gap != '\0')
+    text[length++] = *gap++;
+}
+
+static void appendText(char *text, size_t &length, const char *part)
+{
+  while (*part != '\0')
+    text[length++] = *part++;
+}
+
+static void appendNumber(char *text, size_t &length, int value)
+{
+  length += snprintf(text + length, MAX_INPUT - length, "%d", value);
+}
+
+// "[f, f, ...]" with 1 to 6 frets from -1 to 24, brackets optional
+static size_t generateChord(char *text, int *expected, int &expectedCount)
+{
+  size_t length = 0;
+  bool brackets = randomBelow(4) != 0;
+  expectedCount = 1 + randomBelow(MAX_CHORD_TOKENS);
+  if (brackets)
+    appendText(text, length, "[");
+  for (int i = 0; i < expectedCount; i++)
+  {
+    if (i > 0)
+    {
+      appendSpace(text, length);
+      appendText(text, length, ",");
+    }
+    appendSpace(text, length);
+    expected[i] = randomBelow(26) - 1;
+    appendNumber(text, length, expected[i]);
+  }
+  appendSpace(text, length);
+  if (brackets)
+    appendText(text, length, "]");
+  text[length] = '\0';
+  return length;
+}
+
+// "[[s, f], [s, f], ...]" with 1 to 20 pairs
+static size_t generateScale(char *text, int expected[][2], int &expectedCount)
+{
+  size_t length = 0;
+  expectedCount = 1 + randomBelow(MAX_SCALE_PAIRS);
+  appendText(text, length, "[");
+  for (int i = 0; i < expectedCount; i++)
+  {
+    if (i > 0)
+    {
+      appendSpace(text, length);
+      appendText(text, length, ",");
+    }
+    appendSpace(text, length);
+    appendText(text, length, "[");
+    expected[i][0] = randomBelow(NUM_STRINGS);
+    expected[i][1] = randomBelow(25);
+    appendSpace(text, length);
+    appendNumber(text, length, expected[i][0]);
+    appendSpace(text, length);
+    appendText(text, length, ",");
+    appendSpace(text, length);
+    appendNumber(text, length, expected[i][1]);
+    appendSpace(text, length);
+    appendText(text, length, "]");
+  }
+  appendSpace(text, length);
+  appendText(text, length, "]");
+  text[length] = '\0';
+  return length;
+}
+
+// One to four random edits of a seed: replace, insert or delete a byte, or cut the tail
+static size_t mutate(const char *seed, char *text)
+{
+  static const char alphabet[] = "[]-, 0123456789\t\nx";
+  size_t length = strlen(seed);
+  memcpy(text, seed, length);
+
+  int edits = 1 + randomBelow(4);
+  for (int edit = 0; edit < edits; edit++)
+  {
+    int kind = randomBelow(4);
+    size_t at = length > 0 ? (size_t)randomBelow((int)length) : 0;
+    char c = randomBelow(8) == 0 ? (char)randomBelow(256) : alphabet[randomBelow(sizeof(alphabet) - 1)];
+    if (kind == 0 && length > 0)
+    {
+      text[at] = c;
+    }
+    else if (kind == 1 && length < MAX_INPUT - 1)
+    {
+      memmove(text + at + 1, text + at, length - at);
+      text[at] = c;
+      length++;
+    }
+    else if (kind == 2 && length > 0)
+    {
+      memmove(text + at, text + at + 1, length - at - 1);
+      length--;
+    }
+    else if (kind == 3)
+    {
+      length = at;
+    }
+  }
+  text[length] = '\0';
+  return length;
+}
+
+// ================== Tests ==================
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_seed_corpus()
+{
+  struct Expectation
+  {
+    const char *text;
+    int chordCount; // parseChordCommand result
+    int scaleCount; // parseScaleCommand result
+  };
+  static const Expectation expectations[] = {
+      {"[-1, 3, 2, 0, 1, 0]", 6, 0},
+      {"  [ 0 , 2 , 2 , 1 , 0 , 0 ]  ", 6, 0},
+      {"-1, 0, 2, 2, 1, 0", 6, 0},
+      {"[]", 0, 0},
+      {"[[5,5],[5,7],[4,5],[4,7]]", 0, 4},
+      {"[ [ 2 , 9 ] ,\t[3, 10]\r\n]", 0, 2},
+      {"[0, 1], [2, 3]", 0, 2},
+      {"[[0, -1]]", 0, 0}, // negative fret
+      {"[[-1, 3]]", 0, 0}, // negative string
+      {"[[0, 1, 2]]", 0, 0},
+      {"[1, 2,, 3]", 0, 0},
+      {"[1, 2", 0, 0},
+      {"[12345]", 0, 0},
+      {"[-]", 0, 0},
+      {"[1, 2] x", 0, 0},
+      {"[1, [2], 3]", 0, 0},
+      {"[1, 2, 3, 4, 5, 6, 7]", 0, 0}, // more than the output holds
+  };
+
+  for (const Expectation &expectation : expectations)
+  {
+    int tokens[MAX_CHORD_TOKENS];
+    int pairs[MAX_SCALE_PAIRS][2];
+    size_t length = strlen(expectation.text);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(expectation.chordCount, parseChordCommand(expectation.text, length, tokens, MAX_CHORD_TOKENS), expectation.text);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(expectation.scaleCount, parseScaleCommand(expectation.text, length, pairs, MAX_SCALE_PAIRS), expectation.text);
+  }
+}
+
+static void test_chords_match_string_parser()
+{
+  char text[MAX_INPUT];
+  for (int i = 0; i < GENERATED_CASES; i++)
+  {
+    int expected[MAX_CHORD_TOKENS];
+    int expectedCount;
+    size_t length = generateChord(text, expected, expectedCount);
+
+    int tokens[MAX_CHORD_TOKENS];
+    int legacyTokens[MAX_CHORD_TOKENS];
+    int count = parseChordCommand(text, length, tokens, MAX_CHORD_TOKENS);
+    int legacyCount = legacyParseChordCommand(String(text), legacyTokens, MAX_CHORD_TOKENS);
+
+    TEST_ASSERT_EQUAL_INT_MESSAGE(legacyCount, count, text);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(expectedCount, count, text);
+    TEST_ASSERT_EQUAL_INT_ARRAY_MESSAGE(legacyTokens, tokens, count, text);
+    TEST_ASSERT_EQUAL_INT_ARRAY_MESSAGE(expected, tokens, count, text);
+  }
+}
+
+static void test_scales_match_string_parser()
+{
+  char text[MAX_INPUT];
+  for (int i = 0; i < GENERATED_CASES; i++)
+  {
+    int expected[MAX_SCALE_PAIRS][2];
+    int expectedCount;
+    size_t length = generateScale(text, expected, expectedCount);
+
+    int pairs[MAX_SCALE_PAIRS][2];
+    int legacyPairs[MAX_SCALE_PAIRS][2];
+    int count = parseScaleCommand(text, length, pairs, MAX_SCALE_PAIRS);
+    int legacyCount = legacyParseScaleCommand(String(text), legacyPairs, MAX_SCALE_PAIRS);
+
+    TEST_ASSERT_EQUAL_INT_MESSAGE(legacyCount, count, text);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(expectedCount, count, text);
+    TEST_ASSERT_EQUAL_INT_ARRAY_MESSAGE(&legacyPairs[0][0], &pairs[0][0], count * 2, text);
+    TEST_ASSERT_EQUAL_INT_ARRAY_MESSAGE(&expected[0][0], &pairs[0][0], count * 2, text);
+  }
+}
+
+static void test_mutated_corpus()
+{
+  char text[MAX_INPUT];
+  for (int i = 0; i < MUTATED_CASES; i++)
+  {
+    size_t length = mutate(seedCorpus[randomBelow(SEED_COUNT)], text);
+
+    int tokens[MAX_CHORD_TOKENS + 1];
+    tokens[MAX_CHORD_TOKENS] = CANARY;
+    int count = parseChordCommand(text, length, tokens, MAX_CHORD_TOKENS);
+    TEST_ASSERT_TRUE_MESSAGE(count >= 0 && count <= MAX_CHORD_TOKENS, text);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CANARY, tokens[MAX_CHORD_TOKENS], text);
+
+    int pairs[FUZZ_SCALE_PAIRS + 1][2];
+    pairs[FUZZ_SCALE_PAIRS][0] = CANARY;
+    pairs[FUZZ_SCALE_PAIRS][1] = CANARY;
+    count = parseScaleCommand(text, length, pairs, FUZZ_SCALE_PAIRS);
+    TEST_ASSERT_TRUE_MESSAGE(count >= 0 && count <= FUZZ_SCALE_PAIRS, text);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CANARY, pairs[FUZZ_SCALE_PAIRS][0], text);
+    TEST_ASSERT_EQUAL_INT_MESSAGE(CANARY, pairs[FUZZ_SCALE_PAIRS][1], text);
+    for (int pair = 0; pair < count; pair++)
+      TEST_ASSERT_TRUE_MESSAGE(pairs[pair][0] >= 0 && pairs[pair][1] >= 0, text);
+  }
+}
+
+// The length bounds the read even without a terminating NUL, and a NUL ends the input early
+static void test_length_and_nul()
+{
+  static const char unterminated[] = {'[', '1', ',', ' ', '2', ']', '9'};
+  int tokens[MAX_CHORD_TOKENS];
+  TEST_ASSERT_EQUAL_INT(2, parseChordCommand(unterminated, 6, tokens, MAX_CHORD_TOKENS));
+
+  static const char embedded[] = "[1, 2]\0[3, 4]";
+  TEST_ASSERT_EQUAL_INT(2, parseChordCommand(embedded, sizeof(embedded) - 1, tokens, MAX_CHORD_TOKENS));
+  TEST_ASSERT_EQUAL_INT(0, parseChordCommand(nullptr, 4, tokens, MAX_CHORD_TOKENS));
+}
+
+// Pairs that reach the mapper by another route still stay inside fretLEDs
+static void test_scale_mapping_ignores_negative_frets()
+{
+  int pairs[2][2] = {{0, -1}, {5, -3}};
+  clearGrid();
+  convertScalePositionsToPixels(pairs, 2);
+  for (int led = 0; led < NUM_LEDS; led++)
+    TEST_ASSERT_TRUE(backBuffer[led] == CRGB(CRGB::Black));
+}
+
+int main(int argc, char **argv)
+{
+  (void)argc;
+  (void)argv;
+  UNITY_BEGIN();
+  RUN_TEST(test_seed_corpus);
+  RUN_TEST(test_chords_match_string_parser);
+  RUN_TEST(test_scales_match_string_parser);
+  RUN_TEST(test_mutated_corpus);
+  RUN_TEST(test_length_and_nul);
+  RUN_TEST(test_scale_mapping_ignores_negative_frets);
+  return UNITY_END();
+}
@@ -527,7 +527,7 @@ class _ScalePracticePageState extends State<ScalePracticePage> {
 
         // Send scale positions specifically to scale pixel characteristic
         // This targets the _scalePixelCharUUID in _pixelServiceUUID service
-        widget.bluetoothService.sendScaleData(positionsString);
+        widget.bluetoothService.sendScaleFast(positions);
       } else {
         print("Scale not found: $scaleTypeKey -> $noteKey");
         // Fallback message - send error indicator to scale characteristic
@@ -733,7 +733,7 @@ class _ChordPracticePageState extends State<ChordPracticePage> {
 
         // Send fret positions specifically to chord pixel characteristic
         // This targets the _chordPixelCharUUID in _pixelServiceUUID service
-        widget.bluetoothService.sendChordData(fretPosString);
+        widget.bluetoothService.sendChordFast(fretNum);
       } else {
         print("Chord not found: $chordTypeKey -> $noteKey");
         // Fallback message - send error indicator to chord characteristic
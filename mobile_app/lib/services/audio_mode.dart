@@ -0,0 +1,20 @@
+import 'frame_protocol.dart';
+
+/// FRAME_OP_AUDIO frames: what the board listens for on its audio input
+/// (see hardware/include/audio_input.h). Written to the sequence
+/// characteristic; boards without the input reject them as unsupported.
+/// Listening stops on disconnect.
+class AudioMode {
+  static const int off = 0;
+  static const int tuner = 1; // readings arrive as TunerEvent
+  static const int chord = 2; // strums scored as ChordMatchEvent
+  static const int rhythm = 3; // strums timed as StrumTimingEvent
+
+  static List<int> select(int mode) =>
+      FrameProtocol.encodeFrame(FrameProtocol.opAudio, [mode]);
+
+  /// Rhythm practice against the metronome (LedEffects.metronome), with
+  /// [strumsPerBeat] 1-4: 2 scores eighths, 4 sixteenths.
+  static List<int> rhythmPractice(int strumsPerBeat) =>
+      FrameProtocol.encodeFrame(FrameProtocol.opAudio, [rhythm, strumsPerBeat]);
+}
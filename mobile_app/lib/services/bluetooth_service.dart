@@ -1,5 +1,12 @@
 import 'dart:async';
 import 'package:flutter_blue_plus/flutter_blue_plus.dart';
+import 'audio_mode.dart';
+import 'board_events.dart';
+import 'frame_protocol.dart';
+import 'guitar_tuning.dart';
+import 'led_effects.dart';
+import 'lesson_sequence.dart';
+import 'link_params.dart';
 
 class ESP32BluetoothService {
   // Connection state tracking
@@ -12,8 +19,25 @@ class ESP32BluetoothService {
   BluetoothCharacteristic? _initCharacteristic;
   BluetoothCharacteristic? _chordPixelCharacteristic;
   BluetoothCharacteristic? _scalePixelCharacteristic;
-
-  Timer? _sendTimer;
+  BluetoothCharacteristic? _eventCharacteristic;
+  BluetoothCharacteristic? _linkCharacteristic;
+  BluetoothCharacteristic? _fastPixelCharacteristic;
+  BluetoothCharacteristic? _sequenceCharacteristic;
+
+  // MTU / interval / PHY the board reports; sizes every write
+  LinkParams _linkParams = LinkParams.initial;
+
+  // Fast path: one write without response in flight, only the newest frame
+  // waits behind it. Sequence numbers restart with every connection.
+  int _fastSequence = 0;
+  bool _fastInFlight = false;
+  List<int>? _fastPending;
+  int? _appliedSequence;
+
+  // Board notifications and link state replace the old 5 s init polling
+  StreamSubscription<List<int>>? _eventSubscription;
+  StreamSubscription<List<int>>? _linkParamsSubscription;
+  StreamSubscription<BluetoothConnectionState>? _linkSubscription;
 
   // UUIDs for the ESP32 service and characteristic
   final String _initServiceUUID = "4fafc201-1fb5-459e-8fcc-c5c9c331914b";
@@ -22,6 +46,14 @@ class ESP32BluetoothService {
   final String _pixelServiceUUID = "c3c50c29-d4a5-4998-b382-62dcc1845e10";
   final String _chordPixelCharUUID = "c3c50c29-d4a5-4998-b382-62dcc1845e11";
   final String _scalePixelCharUUID = "c3c50c29-d4a5-4998-b382-62dcc1845e12";
+  final String _eventCharUUID = "c3c50c29-d4a5-4998-b382-62dcc1845e13";
+  final String _linkCharUUID = "c3c50c29-d4a5-4998-b382-62dcc1845e14";
+  final String _fastPixelCharUUID = "c3c50c29-d4a5-4998-b382-62dcc1845e15";
+  final String _sequenceCharUUID = "c3c50c29-d4a5-4998-b382-62dcc1845e16";
+
+  // The board's local MTU limit (LINK_MTU); Android asks for it on connect,
+  // iOS negotiates on its own
+  static const int _requestedMtu = 247;
 
   // Stream controllers for state updates
   final StreamController<bool> _connectionStateController =
@@ -30,6 +62,10 @@ class ESP32BluetoothService {
       StreamController<bool>.broadcast();
   final StreamController<String> _connectionStatusController =
       StreamController<String>.broadcast();
+  final StreamController<BoardEvent> _eventController =
+      StreamController<BoardEvent>.broadcast();
+  final StreamController<LinkParams> _linkParamsController =
+      StreamController<LinkParams>.broadcast();
 
   // Getters for current state
   bool get connected => _connected;
@@ -43,6 +79,16 @@ class ESP32BluetoothService {
   Stream<String> get connectionStatusStream =>
       _connectionStatusController.stream;
 
+  /// Render acknowledgements, rejections and stats pushed by the board
+  Stream<BoardEvent> get eventStream => _eventController.stream;
+
+  /// Link parameters as granted, updated whenever the board renegotiates
+  LinkParams get linkParams => _linkParams;
+  Stream<LinkParams> get linkParamsStream => _linkParamsController.stream;
+
+  /// Sequence number of the newest fast-path frame the board has drawn
+  int? get appliedSequence => _appliedSequence;
+
   /// Initiates connection to ESP32 device via Bluetooth Low Energy (BLE)
   Future<void> connectToESP32() async {
     _updateConnectingState(true);
@@ -98,12 +144,20 @@ class ESP32BluetoothService {
   Future<void> _connectToDevice(BluetoothDevice device) async {
     try {
       // Attempt to connect to the device
-      await device.connect();
+      await device.connect(mtu: _requestedMtu);
       _connectedDevice = device;
       _updateConnectionStatus('Connected');
       _updateConnectionState(true);
       _updateConnectingState(false);
 
+      // The link itself reports drops; no need to probe it with writes
+      _linkSubscription = device.connectionState.listen((state) {
+        if (state == BluetoothConnectionState.disconnected &&
+            _connectedDevice == device) {
+          _clearConnection('Disconnected');
+        }
+      });
+
       // Discover services offered by the device
       List<BluetoothService> services = await device.discoverServices();
 
@@ -143,13 +197,43 @@ class ESP32BluetoothService {
               foundScalePixelChar = true;
               print('Found scale pixel characteristic');
             }
+            // Board event notifications
+            else if (char.uuid.toString().toLowerCase() ==
+                _eventCharUUID.toLowerCase()) {
+              _eventCharacteristic = char;
+              print('Found event characteristic');
+            }
+            // Negotiated link parameters
+            else if (char.uuid.toString().toLowerCase() ==
+                _linkCharUUID.toLowerCase()) {
+              _linkCharacteristic = char;
+              print('Found link characteristic');
+            }
+            // Sequenced write-without-response frames
+            else if (char.uuid.toString().toLowerCase() ==
+                _fastPixelCharUUID.toLowerCase()) {
+              _fastPixelCharacteristic = char;
+              print('Found fast pixel characteristic');
+            }
+            // On-board lesson sequencer
+            else if (char.uuid.toString().toLowerCase() ==
+                _sequenceCharUUID.toLowerCase()) {
+              _sequenceCharacteristic = char;
+              print('Found sequence characteristic');
+            }
           }
         }
       }
 
-      // Start periodic messages if we found the init characteristic
+      // Say hello once; after that the board talks through notifications
       if (foundInitChar) {
-        _startSendingMessages();
+        await _sendHandshake();
+      }
+      if (_eventCharacteristic != null) {
+        await _subscribeToEvents();
+      }
+      if (_linkCharacteristic != null) {
+        await _subscribeToLinkParams();
       }
 
       // Log which characteristics were found
@@ -171,23 +255,75 @@ class ESP32BluetoothService {
     }
   }
 
-  /// Periodically sends messages to the ESP32 device using init characteristic
-  void _startSendingMessages() {
-    _sendTimer = Timer.periodic(const Duration(seconds: 5), (timer) async {
-      if (_initCharacteristic != null && _connected) {
-        try {
-          // Send 'Guitar-Pal' message to the initialization characteristic
-          await _initCharacteristic!.write('Guitar-Pal'.codeUnits);
-          print('Sent periodic message to init characteristic');
-        } catch (e) {
-          // Handle write errors
-          print('Init characteristic write failed: $e');
-          _updateConnectionStatus('Write failed: $e');
-          _updateConnectionState(false);
-          _updateConnectingState(false);
+  /// Sends the one-off 'Guitar-Pal' greeting to the init characteristic
+  Future<void> _sendHandshake() async {
+    try {
+      await _initCharacteristic!.write('Guitar-Pal'.codeUnits);
+      print('Sent handshake to init characteristic');
+    } catch (e) {
+      print('Init characteristic write failed: $e');
+      _updateConnectionStatus('Write failed: $e');
+    }
+  }
+
+  /// Enables notifications on the event characteristic and forwards decoded
+  /// events to [eventStream]
+  Future<void> _subscribeToEvents() async {
+    try {
+      _eventSubscription = _eventCharacteristic!.onValueReceived.listen((
+        value,
+      ) {
+        for (final event in BoardEvent.decodeBatch(value)) {
+          if (event is SequenceAppliedEvent) {
+            _appliedSequence = event.sequence;
+          }
+          if (!_eventController.isClosed) {
+            _eventController.add(event);
+          }
         }
-      }
-    });
+      });
+      await _eventCharacteristic!.setNotifyValue(true);
+      print('Subscribed to board events');
+    } catch (e) {
+      print('Event subscription failed: $e');
+    }
+  }
+
+  /// Reads the link parameters once and follows later changes
+  Future<void> _subscribeToLinkParams() async {
+    try {
+      _linkParamsSubscription = _linkCharacteristic!.onValueReceived.listen(
+        _updateLinkParams,
+      );
+      await _linkCharacteristic!.setNotifyValue(true);
+      _updateLinkParams(await _linkCharacteristic!.read());
+    } catch (e) {
+      print('Link parameter read failed: $e');
+    }
+  }
+
+  void _updateLinkParams(List<int> value) {
+    final params = LinkParams.decode(value);
+    if (params == null) {
+      return;
+    }
+    _linkParams = params;
+    print('Link parameters: $params');
+    if (!_linkParamsController.isClosed) {
+      _linkParamsController.add(params);
+    }
+  }
+
+  /// Writes [data], allowing a long (multi-packet) write only when it does not
+  /// fit in one ATT packet at the current MTU
+  Future<void> _writeSized(
+    BluetoothCharacteristic characteristic,
+    List<int> data,
+  ) {
+    return characteristic.write(
+      data,
+      allowLongWrite: data.length > _linkParams.maxWrite,
+    );
   }
 
   /// Send chord fret positions to ESP32 chord pixel characteristic
@@ -195,7 +331,7 @@ class ESP32BluetoothService {
     if (_chordPixelCharacteristic != null && _connected) {
       try {
         // Send fret position data to chord pixel characteristic
-        await _chordPixelCharacteristic!.write(fretPositions.codeUnits);
+        await _writeSized(_chordPixelCharacteristic!, fretPositions.codeUnits);
         print('Sent chord data to chord pixel characteristic: $fretPositions');
       } catch (e) {
         print('Chord characteristic write failed: $e');
@@ -217,7 +353,7 @@ class ESP32BluetoothService {
     if (_scalePixelCharacteristic != null && _connected) {
       try {
         // Send scale data to scale pixel characteristic
-        await _scalePixelCharacteristic!.write(scaleData.codeUnits);
+        await _writeSized(_scalePixelCharacteristic!, scaleData.codeUnits);
         print('Sent scale data to scale pixel characteristic: $scaleData');
       } catch (e) {
         print('Scale characteristic write failed: $e');
@@ -234,6 +370,198 @@ class ESP32BluetoothService {
     }
   }
 
+  /// Send chord fret positions as a compact binary frame (7 bytes)
+  Future<void> sendChordFrame(List<int> fretNum) async {
+    if (_chordPixelCharacteristic != null && _connected) {
+      try {
+        await _writeSized(
+          _chordPixelCharacteristic!,
+          FrameProtocol.encodeChord(fretNum),
+        );
+        print('Sent chord frame to chord pixel characteristic: $fretNum');
+      } catch (e) {
+        print('Chord frame write failed: $e');
+        _updateConnectionStatus('Chord write failed: $e');
+      }
+    } else {
+      print('Chord pixel characteristic not available or not connected');
+    }
+  }
+
+  /// Send scale positions as a compact binary frame (one byte per position)
+  Future<void> sendScaleFrame(List<List<int>> positions) async {
+    if (_scalePixelCharacteristic != null && _connected) {
+      try {
+        await _writeSized(
+          _scalePixelCharacteristic!,
+          FrameProtocol.encodeScale(positions),
+        );
+        print('Sent scale frame to scale pixel characteristic: $positions');
+      } catch (e) {
+        print('Scale frame write failed: $e');
+        _updateConnectionStatus('Scale write failed: $e');
+      }
+    } else {
+      print('Scale pixel characteristic not available or not connected');
+    }
+  }
+
+  /// Send a 2-byte (root, type) shape ID; the ESP32 lights it from its own
+  /// index. Chords can pick one of the board's voicings, 0 = easiest.
+  Future<void> sendShapeFrame(int root, int type, {int voicing = 0}) async {
+    if (_chordPixelCharacteristic != null && _connected) {
+      try {
+        await _writeSized(
+          _chordPixelCharacteristic!,
+          FrameProtocol.encodeShape(root, type, voicing: voicing),
+        );
+        print('Sent shape frame: root $root, type $type');
+      } catch (e) {
+        print('Shape frame write failed: $e');
+        _updateConnectionStatus('Shape write failed: $e');
+      }
+    } else {
+      print('Chord pixel characteristic not available or not connected');
+    }
+  }
+
+  /// Send chord fret positions on the fast path. Meant for scrubbing: if
+  /// several calls arrive while a write is in flight only the last is sent.
+  /// Falls back to [sendChordFrame] on boards without the fast path.
+  Future<void> sendChordFast(List<int> fretNum) async {
+    if (_fastPixelCharacteristic == null) {
+      return sendChordFrame(fretNum);
+    }
+    try {
+      await _sendFast(FrameProtocol.encodeChord(fretNum));
+    } catch (e) {
+      print('Chord fast write failed: $e');
+    }
+  }
+
+  /// Send scale positions on the fast path, see [sendChordFast]
+  Future<void> sendScaleFast(List<List<int>> positions) async {
+    if (_fastPixelCharacteristic == null) {
+      return sendScaleFrame(positions);
+    }
+    try {
+      await _sendFast(FrameProtocol.encodeScale(positions));
+    } catch (e) {
+      print('Scale fast write failed: $e');
+    }
+  }
+
+  /// Send a (root, type) shape ID on the fast path, see [sendChordFast]
+  Future<void> sendShapeFast(int root, int type, {int voicing = 0}) async {
+    if (_fastPixelCharacteristic == null) {
+      return sendShapeFrame(root, type, voicing: voicing);
+    }
+    try {
+      await _sendFast(FrameProtocol.encodeShape(root, type, voicing: voicing));
+    } catch (e) {
+      print('Shape fast write failed: $e');
+    }
+  }
+
+  /// Queue [frame] as the newest fast-path frame and send it once the write
+  /// in flight (if any) has gone out; frames it replaces are never sent
+  Future<void> _sendFast(List<int> frame) async {
+    _fastPending = frame;
+    if (_fastInFlight || !_connected) {
+      return;
+    }
+
+    _fastInFlight = true;
+    try {
+      while (_fastPending != null && _fastPixelCharacteristic != null) {
+        final next = _fastPending!;
+        _fastPending = null;
+        _fastSequence = (_fastSequence + 1) & 0xFFFF;
+        await _fastPixelCharacteristic!.write(
+          FrameProtocol.withSequence(_fastSequence, next),
+          withoutResponse: true,
+        );
+      }
+    } finally {
+      _fastInFlight = false;
+    }
+  }
+
+  /// Replace the board's lesson with [steps]; the board plays it on its own
+  /// clock, so timing no longer depends on the phone. Returns false if the
+  /// upload did not complete.
+  Future<bool> uploadSequence(
+    List<SequenceStep> steps, {
+    required int bpm,
+    bool loop = false,
+  }) async {
+    try {
+      for (final frame in LessonSequence.encodeUpload(
+        steps,
+        bpm: bpm,
+        loop: loop,
+      )) {
+        if (!await _sendSequenceFrame(frame)) {
+          return false;
+        }
+      }
+      print('Uploaded sequence: ${steps.length} steps at $bpm bpm');
+      return true;
+    } catch (e) {
+      print('Sequence upload failed: $e');
+      return false;
+    }
+  }
+
+  Future<bool> playSequence() => _sendSequenceFrame(LessonSequence.play());
+  Future<bool> pauseSequence() => _sendSequenceFrame(LessonSequence.pause());
+  Future<bool> stopSequence() => _sendSequenceFrame(LessonSequence.stop());
+  Future<bool> setSequenceLoop(bool enabled) =>
+      _sendSequenceFrame(LessonSequence.loop(enabled));
+  Future<bool> setSequenceTempo(int bpm) =>
+      _sendSequenceFrame(LessonSequence.tempo(bpm));
+
+  /// LED animations, see [LedEffects]. They share the sequence characteristic.
+  Future<bool> setTransitions({int fadeMs = 0, int revealStepMs = 0}) =>
+      _sendSequenceFrame(
+          LedEffects.transitions(fadeMs: fadeMs, revealStepMs: revealStepMs));
+  Future<bool> setPulse(int? periodMs) =>
+      _sendSequenceFrame(LedEffects.pulse(periodMs));
+  Future<bool> setMetronome(int? bpm, {int beatsPerBar = 4}) =>
+      _sendSequenceFrame(LedEffects.metronome(bpm, beatsPerBar: beatsPerBar));
+
+  /// What the board listens for, see [AudioMode]. Also on the sequence
+  /// characteristic.
+  Future<bool> setAudioMode(int mode) =>
+      _sendSequenceFrame(AudioMode.select(mode));
+
+  /// Score strum timing against the running metronome, see
+  /// [AudioMode.rhythmPractice].
+  Future<bool> startRhythmPractice(int strumsPerBeat) =>
+      _sendSequenceFrame(AudioMode.rhythmPractice(strumsPerBeat));
+
+  /// The tuning and capo the board fits chords and scales to, see
+  /// [GuitarTuning]. What is lit is redrawn on the new neck.
+  Future<bool> setTuning(int preset, {int capo = 0}) =>
+      _sendSequenceFrame(GuitarTuning.select(preset, capo: capo));
+  Future<bool> setCustomTuning(List<int> openStringMidi, {int capo = 0}) =>
+      _sendSequenceFrame(GuitarTuning.custom(openStringMidi, capo: capo));
+
+  Future<bool> _sendSequenceFrame(List<int> frame) async {
+    if (_sequenceCharacteristic == null || !_connected) {
+      print('Sequence characteristic not available or not connected');
+      return false;
+    }
+    try {
+      await _writeSized(_sequenceCharacteristic!, frame);
+      return true;
+    } catch (e) {
+      print('Sequence write failed: $e');
+      _updateConnectionStatus('Sequence write failed: $e');
+      return false;
+    }
+  }
+
   /// Send custom message to ESP32 (legacy method - uses init characteristic)
   Future<void> sendMessage(String message) async {
     if (_initCharacteristic != null && _connected) {
@@ -253,21 +581,39 @@ class ESP32BluetoothService {
 
   /// Disconnect from the current device
   Future<void> disconnect() async {
-    _sendTimer?.cancel();
-    _sendTimer = null;
+    final device = _connectedDevice;
+    _clearConnection('Disconnected');
 
-    await _connectedDevice?.disconnect().catchError((e) {
+    await device?.disconnect().catchError((e) {
       print('Error disconnecting: $e');
     });
+  }
+
+  /// Drop subscriptions and characteristics after a disconnect
+  void _clearConnection(String status) {
+    _eventSubscription?.cancel();
+    _eventSubscription = null;
+    _linkParamsSubscription?.cancel();
+    _linkParamsSubscription = null;
+    _linkSubscription?.cancel();
+    _linkSubscription = null;
 
     // Clear all characteristics
     _connectedDevice = null;
     _initCharacteristic = null;
     _chordPixelCharacteristic = null;
     _scalePixelCharacteristic = null;
+    _eventCharacteristic = null;
+    _linkCharacteristic = null;
+    _fastPixelCharacteristic = null;
+    _sequenceCharacteristic = null;
+    _linkParams = LinkParams.initial;
+    _fastSequence = 0;
+    _fastPending = null;
+    _appliedSequence = null;
 
     _updateConnectionState(false);
-    _updateConnectionStatus('Disconnected');
+    _updateConnectionStatus(status);
     _updateConnectingState(false);
   }
 
@@ -295,8 +641,12 @@ class ESP32BluetoothService {
 
   /// Clean up resources
   void dispose() {
-    _sendTimer?.cancel();
-    _sendTimer = null;
+    _eventSubscription?.cancel();
+    _eventSubscription = null;
+    _linkParamsSubscription?.cancel();
+    _linkParamsSubscription = null;
+    _linkSubscription?.cancel();
+    _linkSubscription = null;
 
     _connectedDevice?.disconnect().catchError((e) {
       print('Error disconnecting: $e');
@@ -307,6 +657,11 @@ class ESP32BluetoothService {
     _initCharacteristic = null;
     _chordPixelCharacteristic = null;
     _scalePixelCharacteristic = null;
+    _eventCharacteristic = null;
+    _linkCharacteristic = null;
+    _fastPixelCharacteristic = null;
+    _sequenceCharacteristic = null;
+    _fastPending = null;
 
     if (!_connectionStateController.isClosed) {
       _connectionStateController.close();
@@ -317,5 +672,11 @@ class ESP32BluetoothService {
     if (!_connectionStatusController.isClosed) {
       _connectionStatusController.close();
     }
+    if (!_eventController.isClosed) {
+      _eventController.close();
+    }
+    if (!_linkParamsController.isClosed) {
+      _linkParamsController.close();
+    }
   }
 }
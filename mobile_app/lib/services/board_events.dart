@@ -0,0 +1,359 @@
+import 'frame_protocol.dart';
+
+/// Events notified by the ESP32 on the event characteristic
+/// (see hardware/include/event_stream.h). Several events arrive batched in one
+/// FRAME_OP_EVENTS frame; multi-byte fields are little-endian.
+sealed class BoardEvent {
+  const BoardEvent();
+
+  static const int renderComplete = 0x01;
+  static const int commandRejected = 0x02;
+  static const int stats = 0x03;
+  static const int touch = 0x04;
+  static const int sequenceApplied = 0x05;
+  static const int sequenceStep = 0x06;
+  static const int power = 0x07;
+  static const int chordCheck = 0x08;
+  static const int tuner = 0x09;
+  static const int chordMatch = 0x0A;
+  static const int strumTiming = 0x0B;
+
+  /// Decode one notification into its events. Returns an empty list if the
+  /// frame is damaged; unknown event types end the batch.
+  static List<BoardEvent> decodeBatch(List<int> frame) {
+    final payload = FrameProtocol.decode(frame, FrameProtocol.opEvents);
+    if (payload == null) {
+      return const [];
+    }
+
+    final events = <BoardEvent>[];
+    int offset = 0;
+    while (offset < payload.length) {
+      final type = payload[offset];
+      final body = offset + 1;
+      switch (type) {
+        case renderComplete when body + 6 <= payload.length:
+          events.add(RenderCompleteEvent(
+            commandType: payload[body],
+            superseded: payload[body + 1],
+            latencyMicros: _u32(payload, body + 2),
+          ));
+          offset = body + 6;
+        case commandRejected when body + 2 <= payload.length:
+          events.add(CommandRejectedEvent(
+            source: payload[body],
+            reason: payload[body + 1],
+          ));
+          offset = body + 2;
+        case stats when body + 10 <= payload.length:
+          events.add(StatsEvent(
+            freeHeap: _u32(payload, body),
+            pushesPerSecond: _u16(payload, body + 4),
+            eventsDropped: _u16(payload, body + 6),
+            effectsLoad: _u16(payload, body + 8) / 100,
+          ));
+          offset = body + 10;
+        case touch when body + 7 <= payload.length:
+          events.add(TouchEvent(
+            frets: [
+              for (final fret in payload.sublist(body, body + 6))
+                fret == TouchEvent.none ? null : fret,
+            ],
+            pressedCells: payload[body + 6],
+          ));
+          offset = body + 7;
+        case sequenceApplied when body + 2 <= payload.length:
+          events.add(SequenceAppliedEvent(_u16(payload, body)));
+          offset = body + 2;
+        case sequenceStep when body + 2 <= payload.length:
+          events.add(SequenceStepEvent(_u16(payload, body)));
+          offset = body + 2;
+        case power when body + 8 <= payload.length:
+          events.add(PowerEvent(
+            mode: payload[body],
+            wakeLatencyMicros: _u32(payload, body + 1),
+            ledPeakMilliamps: _u16(payload, body + 5),
+            brightness: payload[body + 7],
+          ));
+          offset = body + 8;
+        case chordCheck when body + 6 <= payload.length:
+          events.add(ChordCheckEvent(
+            state: payload[body],
+            fingersDown: payload[body + 1],
+            fingers: payload[body + 2],
+            wrongCells: payload[body + 3],
+            elapsedMs: _u16(payload, body + 4),
+          ));
+          offset = body + 6;
+        case tuner when body + 6 <= payload.length:
+          final cents = _u16(payload, body + 1);
+          events.add(TunerEvent(
+            string: payload[body] == TunerEvent.noString ? null : payload[body],
+            cents: cents >= 0x8000 ? cents - 0x10000 : cents,
+            frequency: _u16(payload, body + 3) / 10,
+            clarity: payload[body + 5],
+          ));
+          offset = body + 6;
+        case chordMatch when body + 6 <= payload.length:
+          events.add(ChordMatchEvent(
+            score: payload[body],
+            heard: _u16(payload, body + 1),
+            chord: _u16(payload, body + 3),
+            latencyMs: payload[body + 5],
+          ));
+          offset = body + 6;
+        case strumTiming when body + 5 <= payload.length:
+          final error = _u16(payload, body + 3);
+          events.add(StrumTimingEvent(
+            beat: _u16(payload, body),
+            part: payload[body + 2],
+            errorMs: error >= 0x8000 ? error - 0x10000 : error,
+          ));
+          offset = body + 5;
+        default:
+          return events;
+      }
+    }
+    return events;
+  }
+
+  static int _u16(List<int> data, int offset) =>
+      data[offset] | (data[offset + 1] << 8);
+
+  static int _u32(List<int> data, int offset) =>
+      _u16(data, offset) | (_u16(data, offset + 2) << 16);
+}
+
+/// A command reached the LEDs; latency is measured from BLE write to push
+class RenderCompleteEvent extends BoardEvent {
+  // Command types, as CommandType in hardware/include/command_queue.h
+  static const int clear = 0;
+  static const int chord = 1;
+  static const int scale = 2;
+  static const int shape = 3;
+
+  final int commandType;
+  final int superseded; // older commands replaced before they were drawn
+  final int latencyMicros;
+
+  const RenderCompleteEvent({
+    required this.commandType,
+    required this.superseded,
+    required this.latencyMicros,
+  });
+
+  @override
+  String toString() =>
+      'RenderComplete(type $commandType, ${latencyMicros}us, superseded $superseded)';
+}
+
+/// A write was refused by the board
+class CommandRejectedEvent extends BoardEvent {
+  static const int sourceChord = 0;
+  static const int sourceScale = 1;
+  static const int sourceFast = 2;
+  static const int sourceSequence = 3;
+
+  static const int malformed = 1;
+  static const int queueFull = 2; // older firmware: newer boards replace instead
+  static const int noRoom = 3; // sequence does not fit on the board
+  static const int unsupported = 4; // feature not built into the firmware
+
+  final int source;
+  final int reason;
+
+  const CommandRejectedEvent({required this.source, required this.reason});
+
+  @override
+  String toString() => 'CommandRejected(source $source, reason $reason)';
+}
+
+/// The newest fast-path frame (see FrameProtocol.withSequence) is on the LEDs
+class SequenceAppliedEvent extends BoardEvent {
+  final int sequence;
+
+  const SequenceAppliedEvent(this.sequence);
+
+  @override
+  String toString() => 'SequenceApplied($sequence)';
+}
+
+/// The fingers on the board's touch sensors moved (boards with the touch
+/// matrix fitted). Sent on every debounced change while connected.
+class TouchEvent extends BoardEvent {
+  static const int none = 0xFF;
+
+  /// Highest pressed fret per string (string 0 first), null if untouched
+  final List<int?> frets;
+  final int pressedCells;
+
+  const TouchEvent({required this.frets, required this.pressedCells});
+
+  @override
+  String toString() =>
+      'Touch(${frets.map((f) => f ?? 'x').join(' ')}, $pressedCells cells)';
+}
+
+/// The board's sequencer moved to a new step
+class SequenceStepEvent extends BoardEvent {
+  static const int ended = 0xFFFF;
+
+  final int step;
+
+  const SequenceStepEvent(this.step);
+
+  bool get isEnd => step == ended;
+
+  @override
+  String toString() => isEnd ? 'SequenceEnded' : 'SequenceStep($step)';
+}
+
+/// Power management state, sent with every [StatsEvent]
+class PowerEvent extends BoardEvent {
+  // PowerMode in hardware/include/supervisor.h
+  static const int modeNone = 0;
+  static const int modeFrequencyScaling = 1;
+  static const int modeLightSleep = 2;
+  static const int modeUnavailable = 3; // the board's SDK has no power management
+
+  final int mode;
+  final int wakeLatencyMicros; // worst write -> render start since the last report
+  final int ledPeakMilliamps; // highest estimated strip draw since the last report
+  final int brightness; // of the last push, after the board's power budget
+
+  const PowerEvent({
+    required this.mode,
+    required this.wakeLatencyMicros,
+    required this.ledPeakMilliamps,
+    required this.brightness,
+  });
+
+  @override
+  String toString() => 'Power(mode $mode, wake ${wakeLatencyMicros}us, '
+      'LEDs ${ledPeakMilliamps}mA at brightness $brightness)';
+}
+
+/// The player's fingers against the chord on the LEDs (boards with the touch
+/// matrix fitted). Sent whenever the counts change; [correct] carries the
+/// time-to-correct, [missed] that the chord moved on before it was played.
+class ChordCheckEvent extends BoardEvent {
+  static const int progress = 0;
+  static const int correct = 1;
+  static const int missed = 2;
+
+  final int state;
+  final int fingersDown; // chord fingers in place
+  final int fingers; // fingers the chord needs
+  final int wrongCells; // pressed cells the chord does not use
+  final int elapsedMs; // since the chord was shown
+
+  const ChordCheckEvent({
+    required this.state,
+    required this.fingersDown,
+    required this.fingers,
+    required this.wrongCells,
+    required this.elapsedMs,
+  });
+
+  /// Share of the chord's fingers in place, less one finger per wrong cell
+  double get accuracy => fingers == 0
+      ? 0
+      : ((fingersDown - wrongCells) / fingers).clamp(0.0, 1.0).toDouble();
+
+  bool get isCorrect => state == correct;
+
+  @override
+  String toString() =>
+      'ChordCheck(${const ['progress', 'correct', 'missed'].elementAtOrNull(state) ?? state}, '
+      '$fingersDown/$fingers, $wrongCells wrong, ${elapsedMs}ms)';
+}
+
+/// A tuner reading (AudioMode.tuner): the nearest open string and how far
+/// the note is from it. Sent when the board's needle moves and every 100 ms
+/// while a note sounds; [string] is null once the note has died away.
+class TunerEvent extends BoardEvent {
+  static const int noString = 0xFF;
+
+  final int? string; // 0 = low E
+  final int cents; // negative = flat
+  final double frequency; // Hz
+  final int clarity; // percent, how periodic the sound is
+
+  const TunerEvent({
+    required this.string,
+    required this.cents,
+    required this.frequency,
+    required this.clarity,
+  });
+
+  @override
+  String toString() => string == null
+      ? 'Tuner(no note)'
+      : 'Tuner(string $string, ${cents >= 0 ? '+' : ''}$cents cents, '
+          '${frequency.toStringAsFixed(1)} Hz)';
+}
+
+/// A strum scored against the chord on the LEDs (AudioMode.chord). Pitch
+/// classes are 12-bit sets, bit 0 = C.
+class ChordMatchEvent extends BoardEvent {
+  final int score; // percent; the right chord scores about 45-65
+  final int heard; // pitch classes in the strum
+  final int chord; // pitch classes of the chord on the LEDs, 0 if none
+  final int latencyMs; // from the start of the strum to the score
+
+  const ChordMatchEvent({
+    required this.score,
+    required this.heard,
+    required this.chord,
+    required this.latencyMs,
+  });
+
+  /// Chord notes the strum did not sound
+  int get missing => chord & ~heard;
+
+  /// Notes sounded that are not in the chord
+  int get extra => heard & ~chord;
+
+  @override
+  String toString() => 'ChordMatch($score%, heard '
+      '0x${heard.toRadixString(16)}, chord 0x${chord.toRadixString(16)}, '
+      '${latencyMs}ms)';
+}
+
+/// A strum against the board's metronome (AudioMode.rhythm). The board
+/// sends a bar's strums together once the bar is over.
+class StrumTimingEvent extends BoardEvent {
+  final int beat; // since the metronome started, wraps at 65536
+  final int part; // which strum of the beat, 0 = on the beat
+  final int errorMs; // negative = early
+
+  const StrumTimingEvent({
+    required this.beat,
+    required this.part,
+    required this.errorMs,
+  });
+
+  @override
+  String toString() =>
+      'StrumTiming(beat $beat.$part, ${errorMs >= 0 ? '+' : ''}${errorMs}ms)';
+}
+
+/// Periodic health report, about once a second while connected
+class StatsEvent extends BoardEvent {
+  final int freeHeap;
+  final int pushesPerSecond;
+  final int eventsDropped;
+  final double effectsLoad; // peak % of an effects frame spent drawing it
+
+  const StatsEvent({
+    required this.freeHeap,
+    required this.pushesPerSecond,
+    required this.eventsDropped,
+    required this.effectsLoad,
+  });
+
+  @override
+  String toString() =>
+      'Stats(heap $freeHeap, $pushesPerSecond pushes/s, dropped $eventsDropped, '
+      'effects ${effectsLoad.toStringAsFixed(2)}%)';
+}
@@ -0,0 +1,152 @@
+/// Encoder for the compact binary frame protocol understood by the ESP32
+/// firmware (see hardware/include/ble_protocol.h).
+///
+/// Frame layout: [header][opcode][length][payload ...][crc8]
+class FrameProtocol {
+  static const int header = 0xA1; // magic 0xA, version 1
+  static const int opChord = 0x01;
+  static const int opScale = 0x02;
+  static const int opShape = 0x03;
+  static const int opSequence = 0x04; // see lesson_sequence.dart
+  static const int opEffects = 0x05; // see led_effects.dart
+  static const int opAudio = 0x06; // see audio_mode.dart
+  static const int opTuning = 0x07; // see guitar_tuning.dart
+  static const int opEvents = 0x10; // board -> app, see board_events.dart
+  static const int opLink = 0x11; // board -> app, see link_params.dart
+
+  // Shape type byte: a scale ID, or shapeChordFlag | chord ID.
+  // IDs follow ScaleId/ChordId in hardware/include/scale_and_chord_notes.h.
+  static const int shapeChordFlag = 0x80;
+  static const List<String> scaleTypes = [
+    'Major', 'Minor', 'Diminished Whole-Half', 'Diminished Half-Whole',
+    'Dorian', 'Phrygian', 'Lydian', 'Mixolydian', 'Locrian',
+    'Major Pentatonic', 'Minor Pentatonic', 'Blues', 'Harmonic Minor',
+    'Melodic Minor', 'Phrygian Dominant', 'Lydian Dominant', 'Altered',
+    'Whole Tone', 'Chromatic',
+  ];
+  static const List<String> chordTypes = [
+    'Major', 'Minor', 'Diminished', 'Augmented', 'Sus2', 'Sus4', '5', '6',
+    'Minor 6', '7', 'Major 7', 'Minor 7', 'Minor Major 7',
+    'Half-Diminished 7', 'Diminished 7', '7 Sus4', 'Add9', 'Minor Add9', '9',
+    'Major 9', 'Minor 9',
+  ];
+
+  /// Shape type byte for a scale name from [scaleTypes] (-1 if unknown)
+  static int scaleShape(String name) => scaleTypes.indexOf(name);
+
+  /// Shape type byte for a chord name from [chordTypes] (-1 if unknown)
+  static int chordShape(String name) {
+    final index = chordTypes.indexOf(name);
+    return index < 0 ? -1 : shapeChordFlag | index;
+  }
+
+  static const int maxPayload = 64;
+  static const int maxScalePairs = 20; // scaleData buffer size on the ESP32
+
+  /// CRC-8 with polynomial 0x07 and initial value 0x00
+  static int crc8(List<int> data) {
+    int crc = 0;
+    for (final byte in data) {
+      crc ^= byte & 0xFF;
+      for (int bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x80) != 0 ? ((crc << 1) ^ 0x07) & 0xFF : (crc << 1) & 0xFF;
+      }
+    }
+    return crc;
+  }
+
+  /// Wrap [payload] in a frame with header, length and CRC
+  static List<int> encodeFrame(int opcode, List<int> payload) {
+    final frame = <int>[header, opcode, payload.length, ...payload];
+    frame.add(crc8(frame));
+    return frame;
+  }
+
+  /// Validate a frame received from the board and return its payload, or
+  /// null if the header, length, CRC or opcode do not match.
+  static List<int>? decode(List<int> frame, int opcode) {
+    if (frame.length < 4 || frame[0] != header || frame[1] != opcode) {
+      return null;
+    }
+    final length = frame[2];
+    if (frame.length != length + 4 ||
+        crc8(frame.sublist(0, frame.length - 1)) != frame.last) {
+      return null;
+    }
+    return frame.sublist(3, 3 + length);
+  }
+
+  /// Prefix a frame with a 16-bit little-endian sequence number for the
+  /// write-without-response fast path; the board ignores any frame that is
+  /// not newer than the last one it accepted.
+  static List<int> withSequence(int sequence, List<int> frame) {
+    return <int>[sequence & 0xFF, (sequence >> 8) & 0xFF, ...frame];
+  }
+
+  /// Encode 6 fret positions (-1 muted, 0 open, 1-14 fretted) as a 7 byte frame
+  static List<int> encodeChord(List<int> fretNum) =>
+      encodeFrame(opChord, chordPayload(fretNum));
+
+  /// Chord payload: one nibble per string, fret + 1
+  static List<int> chordPayload(List<int> fretNum) {
+    if (fretNum.length != 6) {
+      throw ArgumentError('Chord frame needs 6 fret positions');
+    }
+    final nibbles = fretNum.map((fret) {
+      if (fret < -1 || fret > 14) {
+        throw ArgumentError('Fret $fret out of range for chord frame');
+      }
+      return fret + 1;
+    }).toList();
+    return <int>[
+      (nibbles[0] << 4) | nibbles[1],
+      (nibbles[2] << 4) | nibbles[3],
+      (nibbles[4] << 4) | nibbles[5],
+    ];
+  }
+
+  /// Encode [string, fret] pairs, one byte per pair
+  static List<int> encodeScale(List<List<int>> positions) =>
+      encodeFrame(opScale, scalePayload(positions));
+
+  /// Scale payload: string in the high nibble, fret in the low nibble
+  static List<int> scalePayload(List<List<int>> positions) {
+    if (positions.isEmpty || positions.length > maxScalePairs) {
+      throw ArgumentError('Scale frame needs 1-$maxScalePairs positions');
+    }
+    return positions.map((pos) {
+      final string = pos[0];
+      final fret = pos[1];
+      if (string < 0 || string > 5 || fret < 0 || fret > 15) {
+        throw ArgumentError('Position $pos out of range for scale frame');
+      }
+      return (string << 4) | fret;
+    }).toList();
+  }
+
+  /// Encode a (root, type) shape ID; the board looks the LED mask up itself.
+  /// root is a pitch class, 0 = C ... 11 = B. Chords are drawn as the
+  /// board's easiest voicing for its tuning, or the [voicing]th easiest.
+  static List<int> encodeShape(int root, int type, {int voicing = 0}) =>
+      encodeFrame(opShape, shapePayload(root, type, voicing: voicing));
+
+  /// Board-side voicings per chord (VOICING_MAX_RESULTS in chord_voicing.h)
+  static const int maxVoicings = 8;
+
+  /// Shape payload: [root][type], or [root][type][voicing] for chords
+  static List<int> shapePayload(int root, int type, {int voicing = 0}) {
+    if (root < 0 || root > 11) {
+      throw ArgumentError('Root $root is not a pitch class');
+    }
+    if (type < 0) {
+      throw ArgumentError('Unknown shape type');
+    }
+    if (voicing == 0) {
+      return [root, type & 0xFF];
+    }
+    if ((type & shapeChordFlag) == 0 || voicing < 0 || voicing >= maxVoicings) {
+      throw ArgumentError('Voicing $voicing out of range for shape type $type');
+    }
+    return [root, type & 0xFF, voicing];
+  }
+}
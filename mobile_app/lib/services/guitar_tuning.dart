@@ -0,0 +1,23 @@
+import 'frame_protocol.dart';
+
+/// FRAME_OP_TUNING frames: the tuning and capo of the player's guitar (see
+/// hardware/include/guitar_tuning.h). Chord and scale data stay in standard
+/// tuning without a capo; the board moves every note to where it is on the
+/// chosen neck and redraws what is lit, so nothing needs to be resent.
+/// Written to the sequence characteristic.
+class GuitarTuning {
+  static const int standard = 0; // E A D G B E
+  static const int dropD = 1; // D A D G B E
+  static const int dadgad = 2; // D A D G A D
+  static const int halfStepDown = 3; // Eb Ab Db Gb Bb Eb
+  static const int customPreset = 0xFF;
+  static const int maxCapo = 7;
+
+  static List<int> select(int preset, {int capo = 0}) =>
+      FrameProtocol.encodeFrame(FrameProtocol.opTuning, [preset, capo]);
+
+  /// Any tuning: the open-string MIDI notes (28-76), low string first.
+  static List<int> custom(List<int> openStringMidi, {int capo = 0}) =>
+      FrameProtocol.encodeFrame(
+          FrameProtocol.opTuning, [customPreset, capo, ...openStringMidi]);
+}
@@ -0,0 +1,56 @@
+import 'frame_protocol.dart';
+
+/// FRAME_OP_EFFECTS frames: animations the board runs on its own frame
+/// timer (see hardware/include/effects.h). Written to the sequence
+/// characteristic. Every effect is off after a reconnect.
+class LedEffects {
+  static const int opTransitions = 0x01;
+  static const int opPulse = 0x02;
+  static const int opMetronome = 0x03;
+
+  static const int maxFadeMs = 2000;
+  static const int maxRevealMs = 1000;
+  static const int minPulseMs = 200;
+  static const int maxPulseMs = 5000;
+  static const int minBpm = 20;
+  static const int maxBpm = 300;
+  static const int maxBeatsPerBar = 16;
+
+  /// Cross-fade over [fadeMs] into every new chord or scale, and reveal
+  /// scales one note per [revealStepMs] in the order they were sent.
+  /// 0 turns either off.
+  static List<int> transitions({int fadeMs = 0, int revealStepMs = 0}) {
+    _check(fadeMs, 0, maxFadeMs, 'Fade');
+    _check(revealStepMs, 0, maxRevealMs, 'Reveal step');
+    return _control(opTransitions, [..._u16(fadeMs), ..._u16(revealStepMs)]);
+  }
+
+  /// Breathe the lit cells once per [periodMs]; null turns it off
+  static List<int> pulse(int? periodMs) {
+    if (periodMs != null) {
+      _check(periodMs, minPulseMs, maxPulseMs, 'Pulse period');
+    }
+    return _control(opPulse, _u16(periodMs ?? 0));
+  }
+
+  /// Flash the unlit open-string cells on every beat, brighter on the first
+  /// of each bar; null turns it off
+  static List<int> metronome(int? bpm, {int beatsPerBar = 4}) {
+    if (bpm != null) {
+      _check(bpm, minBpm, maxBpm, 'Tempo');
+    }
+    _check(beatsPerBar, 1, maxBeatsPerBar, 'Beats per bar');
+    return _control(opMetronome, [..._u16(bpm ?? 0), beatsPerBar]);
+  }
+
+  static void _check(int value, int min, int max, String name) {
+    if (value < min || value > max) {
+      throw ArgumentError('$name $value out of range ($min-$max)');
+    }
+  }
+
+  static List<int> _u16(int value) => [value & 0xFF, (value >> 8) & 0xFF];
+
+  static List<int> _control(int op, List<int> args) =>
+      FrameProtocol.encodeFrame(FrameProtocol.opEffects, [op, ...args]);
+}
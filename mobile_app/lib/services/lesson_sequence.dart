@@ -0,0 +1,127 @@
+import 'frame_protocol.dart';
+
+/// One step of a lesson played by the board's sequencer
+/// (see hardware/include/sequencer.h). Durations are in ticks of
+/// [ticksPerBeat] per beat, so the board can change tempo on its own.
+class SequenceStep {
+  static const int ticksPerBeat = 24;
+
+  // Step kinds, as CommandType in hardware/include/command_queue.h
+  static const int kindRest = 0;
+  static const int kindChord = 1;
+  static const int kindScale = 2;
+  static const int kindShape = 3;
+  static const int kindMask = 4;
+
+  // Fret cells on the 8x8 test grid (FRETBOARD_CELLS)
+  static const int fretboardCells = 48;
+  static const int maskBytes = (fretboardCells + 7) ~/ 8;
+
+  final int kind;
+  final int ticks;
+  final List<int> body;
+
+  SequenceStep._(this.kind, this.ticks, this.body) {
+    if (ticks <= 0 || ticks > 0xFFFF) {
+      throw ArgumentError('Step duration $ticks ticks out of range');
+    }
+  }
+
+  /// Silence for [ticks]
+  SequenceStep.rest({required int ticks}) : this._(kindRest, ticks, const []);
+
+  /// 6 fret positions, as FrameProtocol.encodeChord
+  SequenceStep.chord(List<int> fretNum, {required int ticks})
+      : this._(kindChord, ticks, FrameProtocol.chordPayload(fretNum));
+
+  /// [string, fret] pairs, as FrameProtocol.encodeScale
+  SequenceStep.scale(List<List<int>> positions, {required int ticks})
+      : this._(kindScale, ticks, FrameProtocol.scalePayload(positions));
+
+  /// A (root, type) shape ID, as FrameProtocol.encodeShape
+  SequenceStep.shape(int root, int type, {required int ticks, int voicing = 0})
+      : this._(kindShape, ticks,
+            FrameProtocol.shapePayload(root, type, voicing: voicing));
+
+  /// Arbitrary cells (fret * 6 + string) in one 0xRRGGBB colour
+  factory SequenceStep.cells(
+    Iterable<int> cells, {
+    required int color,
+    required int ticks,
+  }) {
+    final body = List<int>.filled(3 + maskBytes, 0);
+    body[0] = (color >> 16) & 0xFF;
+    body[1] = (color >> 8) & 0xFF;
+    body[2] = color & 0xFF;
+    for (final cell in cells) {
+      if (cell < 0 || cell >= fretboardCells) {
+        throw ArgumentError('Cell $cell is not on the fretboard');
+      }
+      body[3 + cell ~/ 8] |= 1 << (cell % 8);
+    }
+    return SequenceStep._(kindMask, ticks, body);
+  }
+
+  /// [kind][ticks: u16][body length][body]
+  List<int> encode() =>
+      [kind, ticks & 0xFF, (ticks >> 8) & 0xFF, body.length, ...body];
+}
+
+/// FRAME_OP_SEQUENCE frames: uploads and transport controls
+class LessonSequence {
+  static const int opBegin = 0x01;
+  static const int opSteps = 0x02;
+  static const int opPlay = 0x03;
+  static const int opPause = 0x04;
+  static const int opStop = 0x05;
+  static const int opTempo = 0x06;
+  static const int opLoop = 0x07;
+
+  static const int minBpm = 20;
+  static const int maxBpm = 300;
+  static const int arenaSize = 2048; // SEQUENCE_ARENA_SIZE on the board
+
+  /// Frames that replace the board's sequence with [steps]: one begin frame,
+  /// then as many steps per frame as fit. Send them in order, then [play].
+  static List<List<int>> encodeUpload(
+    List<SequenceStep> steps, {
+    required int bpm,
+    bool loop = false,
+  }) {
+    final frames = <List<int>>[_control(opBegin, [..._bpm(bpm), loop ? 1 : 0])];
+    var payload = <int>[opSteps];
+    var total = 0;
+    for (final step in steps) {
+      final record = step.encode();
+      total += record.length;
+      if (payload.length + record.length > FrameProtocol.maxPayload) {
+        frames.add(FrameProtocol.encodeFrame(FrameProtocol.opSequence, payload));
+        payload = <int>[opSteps];
+      }
+      payload.addAll(record);
+    }
+    if (total > arenaSize) {
+      throw ArgumentError('Sequence needs $total bytes, the board has $arenaSize');
+    }
+    if (payload.length > 1) {
+      frames.add(FrameProtocol.encodeFrame(FrameProtocol.opSequence, payload));
+    }
+    return frames;
+  }
+
+  static List<int> play() => _control(opPlay);
+  static List<int> pause() => _control(opPause);
+  static List<int> stop() => _control(opStop);
+  static List<int> loop(bool enabled) => _control(opLoop, [enabled ? 1 : 0]);
+  static List<int> tempo(int bpm) => _control(opTempo, _bpm(bpm));
+
+  static List<int> _bpm(int value) {
+    if (value < minBpm || value > maxBpm) {
+      throw ArgumentError('Tempo $value bpm out of range');
+    }
+    return [value & 0xFF, (value >> 8) & 0xFF];
+  }
+
+  static List<int> _control(int op, [List<int> args = const []]) =>
+      FrameProtocol.encodeFrame(FrameProtocol.opSequence, [op, ...args]);
+}
@@ -0,0 +1,61 @@
+import 'frame_protocol.dart';
+
+/// Link parameters the phone granted, as published by the ESP32 on the link
+/// characteristic (see hardware/include/link_tuning.h).
+class LinkParams {
+  final int mtu;
+  final int intervalUnits; // 1.25 ms units, 0 until the first update completes
+  final int latency;
+  final int timeoutUnits; // 10 ms units
+  final int txPhy; // 1 = 1M, 2 = 2M
+  final int rxPhy;
+  final bool active; // short lesson interval rather than the idle one
+
+  const LinkParams({
+    required this.mtu,
+    required this.intervalUnits,
+    required this.latency,
+    required this.timeoutUnits,
+    required this.txPhy,
+    required this.rxPhy,
+    required this.active,
+  });
+
+  /// What every BLE link starts with
+  static const LinkParams initial = LinkParams(
+    mtu: 23,
+    intervalUnits: 0,
+    latency: 0,
+    timeoutUnits: 0,
+    txPhy: 1,
+    rxPhy: 1,
+    active: false,
+  );
+
+  /// Largest write that fits in a single ATT packet
+  int get maxWrite => mtu - 3;
+
+  double get intervalMs => intervalUnits * 1.25;
+
+  /// Decode a FRAME_OP_LINK frame, or null if it is damaged
+  static LinkParams? decode(List<int> frame) {
+    final payload = FrameProtocol.decode(frame, FrameProtocol.opLink);
+    if (payload == null || payload.length < 11) {
+      return null;
+    }
+    int u16(int offset) => payload[offset] | (payload[offset + 1] << 8);
+    return LinkParams(
+      mtu: u16(0),
+      intervalUnits: u16(2),
+      latency: u16(4),
+      timeoutUnits: u16(6),
+      txPhy: payload[8],
+      rxPhy: payload[9],
+      active: payload[10] != 0,
+    );
+  }
+
+  @override
+  String toString() =>
+      'LinkParams(mtu $mtu, ${intervalMs}ms, latency $latency, phy $txPhy/$rxPhy, ${active ? 'active' : 'idle'})';
+}